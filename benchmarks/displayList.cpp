@@ -0,0 +1,143 @@
+// Display list benchmark of the headless software renderer.
+// Draws a mesh of 100k small triangles per frame, once in immediate mode and once by calling a display list
+// compiled from the same calls, and prints the frames and vertices rendered per second for both. The mesh is drawn
+// once rasterized and once with every triangle culled, which leaves the geometry stage alone.
+//
+// compile command
+// g++ -O3 displayList.cpp ../softwareRenderer/*.cpp -pthread -o displayList
+// ./displayList [-frames <count>] [-size <width>x<height>] [-threads <count>]
+//
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../softwareRenderer/softwareRenderer.h"
+
+#define GRID_COLUMNS 250 // The mesh is a grid of GRID_COLUMNS x GRID_ROWS cells, two triangles per cell.
+#define GRID_ROWS 200
+#define TRIANGLES (GRID_COLUMNS * GRID_ROWS * 2)
+
+static void vertex(int column, int row)
+{
+    glColor3f((float)column / GRID_COLUMNS, (float)row / GRID_ROWS, 0.5f);
+    glVertex3f(-1.0f + 2.0f * column / GRID_COLUMNS, -1.0f + 2.0f * row / GRID_ROWS, 0.0f);
+}
+
+void drawMesh(void)
+{
+    glBegin(GL_TRIANGLES);
+
+    for(int row = 0; row < GRID_ROWS; ++row)
+    {
+        for(int column = 0; column < GRID_COLUMNS; ++column)
+        {
+            vertex(column, row);
+            vertex(column + 1, row);
+            vertex(column + 1, row + 1);
+
+            vertex(column, row);
+            vertex(column + 1, row + 1);
+            vertex(column, row + 1);
+        }
+    }
+
+    glEnd();
+}
+
+// Renders frameCount frames, drawing the mesh immediately when list is 0, and returns the frames per second.
+double measure(int frameCount, GLuint list)
+{
+    // One untimed frame to grow the buffers and warm up the caches.
+    glClear(GL_COLOR_BUFFER_BIT);
+    list ? glCallList(list) : drawMesh();
+    swglSwapBuffers();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for(int frame = 0; frame < frameCount; ++frame)
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+        list ? glCallList(list) : drawMesh();
+        swglSwapBuffers();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return frameCount / (seconds > 0.0 ? seconds : 1.0);
+}
+
+void compare(const char *name, int frameCount, GLuint list)
+{
+    double immediate = measure(frameCount, 0);
+    double called = measure(frameCount, list);
+
+    printf("%s, immediate: %.1f frames/s, %.1f million vertices/s.\n", name, immediate, immediate * TRIANGLES * 3 / 1000000.0);
+    printf("%s, display list: %.1f frames/s, %.1f million vertices/s, %.2fx.\n",
+        name, called, called * TRIANGLES * 3 / 1000000.0, called / (immediate > 0.0 ? immediate : 1.0));
+}
+
+int main(int argc, char *argv[])
+{
+    int frameCount = 20;
+    int width = 1024;
+    int height = 768;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-frames") && i + 1 < argc)
+        {
+            frameCount = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-size") && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &width, &height) == 2)
+        {
+            ++i;
+        }
+        else if(!strcmp(argv[i], "-threads") && i + 1 < argc && swglSetThreadCount(atoi(argv[i + 1])))
+        {
+            ++i;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-frames <count>] [-size <width>x<height>] [-threads <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    HSWGLRC context = swglCreateContext(width, height);
+
+    if(!context)
+    {
+        fprintf(stderr, "Failed to create software rendering context.\n");
+        return 1;
+    }
+
+    swglMakeCurrent(context);
+    // The mesh is the same every frame, the draw cache would skip the geometry stage this measures.
+    swglSetDrawCache(FALSE);
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    printf("%d frames of %d triangles at %dx%d with the %s rasterizer on %d threads.\n",
+        frameCount, TRIANGLES, width, height, swglGetInstructionSetName(swglGetInstructionSet()), swglGetThreadCount());
+
+    GLuint list = glGenLists(1);
+    glNewList(list, GL_COMPILE);
+    drawMesh();
+    glEndList();
+
+    compare("Rasterized", frameCount, list);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT_AND_BACK);
+    compare("Geometry only", frameCount, list);
+
+    glDeleteLists(list, 1);
+
+    swglMakeCurrent(NULL);
+    swglDeleteContext(context);
+    return 0;
+}
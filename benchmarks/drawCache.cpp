@@ -0,0 +1,159 @@
+// Draw cache benchmark of the headless software renderer.
+// Draws a display list of 100k small triangles per frame, once standing still and once rotating a little every
+// frame, each with the draw cache of swglSetDrawCache() on and off. Prints the frames per second and the share of
+// draws replayed. The still mesh shows what skipping the geometry stage and setup saves, the rotating one what
+// hashing costs a draw that changes every frame.
+//
+// compile command
+// g++ -O3 drawCache.cpp ../softwareRenderer/*.cpp -pthread -o drawCache
+// ./drawCache [-frames <count>] [-size <width>x<height>] [-threads <count>]
+//
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../softwareRenderer/softwareRenderer.h"
+
+#define GRID_COLUMNS 250 // The mesh is a grid of GRID_COLUMNS x GRID_ROWS cells, two triangles per cell.
+#define GRID_ROWS 200
+#define TRIANGLES (GRID_COLUMNS * GRID_ROWS * 2)
+
+static void vertex(int column, int row)
+{
+    glColor3f((float)column / GRID_COLUMNS, (float)row / GRID_ROWS, 0.5f);
+    glVertex3f(-1.0f + 2.0f * column / GRID_COLUMNS, -1.0f + 2.0f * row / GRID_ROWS, 0.0f);
+}
+
+static void drawMesh(void)
+{
+    glBegin(GL_TRIANGLES);
+
+    for(int row = 0; row < GRID_ROWS; ++row)
+    {
+        for(int column = 0; column < GRID_COLUMNS; ++column)
+        {
+            vertex(column, row);
+            vertex(column + 1, row);
+            vertex(column + 1, row + 1);
+
+            vertex(column, row);
+            vertex(column + 1, row + 1);
+            vertex(column, row + 1);
+        }
+    }
+
+    glEnd();
+}
+
+static void drawFrame(GLuint list, float angle)
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+    glLoadIdentity();
+    glRotatef(angle, 0.0f, 0.0f, 1.0f);
+    glCallList(list);
+    swglSwapBuffers();
+}
+
+// Renders frameCount frames, turning the mesh by step degrees every frame, and returns the frames per second. Sets
+// replayed to the share of draws taken from the draw cache.
+static double measure(int frameCount, GLuint list, float step, double *replayed)
+{
+    // Untimed frames until a still mesh is replayed.
+    float angle = 0.0f;
+
+    for(int frame = 0; frame < 3; ++frame)
+    {
+        drawFrame(list, angle += step);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    unsigned long long lookups = 0;
+    unsigned long long hits = 0;
+
+    for(int frame = 0; frame < frameCount; ++frame)
+    {
+        drawFrame(list, angle += step);
+
+        SWGLFrameStats stats;
+        swglGetFrameStats(&stats);
+        lookups += stats.drawCacheLookups;
+        hits += stats.drawCacheHits;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    *replayed = lookups ? (double)hits / lookups : 0.0;
+    return frameCount / (seconds > 0.0 ? seconds : 1.0);
+}
+
+static void compare(const char *name, int frameCount, GLuint list, float step)
+{
+    double replayed;
+    swglSetDrawCache(FALSE);
+    double uncached = measure(frameCount, list, step, &replayed);
+    swglSetDrawCache(TRUE);
+    double cached = measure(frameCount, list, step, &replayed);
+
+    printf("%s: %.1f frames/s without the draw cache, %.1f frames/s with it, %.2fx, %.0f%% of the draws replayed.\n",
+        name, uncached, cached, cached / (uncached > 0.0 ? uncached : 1.0), replayed * 100.0);
+}
+
+int main(int argc, char *argv[])
+{
+    int frameCount = 20;
+    int width = 1024;
+    int height = 768;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-frames") && i + 1 < argc)
+        {
+            frameCount = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-size") && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &width, &height) == 2)
+        {
+            ++i;
+        }
+        else if(!strcmp(argv[i], "-threads") && i + 1 < argc && swglSetThreadCount(atoi(argv[i + 1])))
+        {
+            ++i;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-frames <count>] [-size <width>x<height>] [-threads <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    HSWGLRC context = swglCreateContext(width, height);
+
+    if(!context)
+    {
+        fprintf(stderr, "Failed to create software rendering context.\n");
+        return 1;
+    }
+
+    swglMakeCurrent(context);
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+
+    printf("%d frames of %d triangles at %dx%d with the %s rasterizer on %d threads.\n",
+        frameCount, TRIANGLES, width, height, swglGetInstructionSetName(swglGetInstructionSet()), swglGetThreadCount());
+
+    GLuint list = glGenLists(1);
+    glNewList(list, GL_COMPILE);
+    drawMesh();
+    glEndList();
+
+    compare("Still", frameCount, list, 0.0f);
+    compare("Rotating", frameCount, list, 0.5f);
+
+    glDeleteLists(list, 1);
+
+    swglMakeCurrent(NULL);
+    swglDeleteContext(context);
+    return 0;
+}
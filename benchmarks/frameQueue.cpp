@@ -0,0 +1,137 @@
+// Frame queue benchmark of the headless software renderer.
+// Draws 20k overlapping immediate mode triangles per frame, rotating a little every frame, with each frame queue
+// depth of swglSetFrameQueueDepth(). Prints the frames per second, the frames queued ahead and the time the
+// application waited for them. The triangles keep both the front end (transform, setup and binning) and the
+// rasterizer busy, the overlap of the two is what a queue can win; it needs more than one hardware thread.
+//
+// compile command
+// g++ -O3 frameQueue.cpp ../softwareRenderer/*.cpp -pthread -o frameQueue
+// ./frameQueue [-frames <count>] [-size <width>x<height>] [-threads <count>]
+//
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../softwareRenderer/softwareRenderer.h"
+
+#define TRIANGLES 20000
+
+static void drawFrame(float angle)
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+    glLoadIdentity();
+    glRotatef(angle, 0.0f, 0.0f, 1.0f);
+    glBegin(GL_TRIANGLES);
+
+    // Triangles a 20th of the screen wide, scattered over it.
+    for(int i = 0; i < TRIANGLES; ++i)
+    {
+        float x = -0.9f + 1.8f * (float)((i * 37) % 1000) / 1000.0f;
+        float y = -0.9f + 1.8f * (float)((i * 91) % 997) / 997.0f;
+
+        glColor3f((float)(i % 7) / 7.0f, (float)(i % 11) / 11.0f, 0.5f);
+        glVertex3f(x, y, 0.0f);
+        glVertex3f(x + 0.1f, y, 0.0f);
+        glVertex3f(x, y + 0.1f, 0.0f);
+    }
+
+    glEnd();
+    swglSwapBuffers();
+}
+
+// Renders frameCount frames with depth frames queued at most and returns the frames per second. Sets queued and
+// stalled to the frames queued ahead and the milliseconds waited per frame.
+static double measure(int frameCount, int depth, double *queued, double *stalled)
+{
+    float angle = 0.0f;
+    swglSetFrameQueueDepth(depth);
+
+    for(int frame = 0; frame < 3; ++frame)
+    {
+        drawFrame(angle += 0.5f);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    unsigned long long framesQueued = 0;
+    unsigned long long stallMicroseconds = 0;
+
+    for(int frame = 0; frame < frameCount; ++frame)
+    {
+        drawFrame(angle += 0.5f);
+
+        SWGLFrameStats stats;
+        swglGetFrameStats(&stats);
+        framesQueued += stats.framesQueued;
+        stallMicroseconds += stats.queueStallMicroseconds;
+    }
+
+    glFinish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    *queued = (double)framesQueued / frameCount;
+    *stalled = stallMicroseconds / 1000.0 / frameCount;
+    return frameCount / (seconds > 0.0 ? seconds : 1.0);
+}
+
+int main(int argc, char *argv[])
+{
+    int frameCount = 50;
+    int width = 1024;
+    int height = 768;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-frames") && i + 1 < argc)
+        {
+            frameCount = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-size") && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &width, &height) == 2)
+        {
+            ++i;
+        }
+        else if(!strcmp(argv[i], "-threads") && i + 1 < argc && swglSetThreadCount(atoi(argv[i + 1])))
+        {
+            ++i;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-frames <count>] [-size <width>x<height>] [-threads <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    HSWGLRC context = swglCreateContext(width, height);
+
+    if(!context || frameCount <= 0)
+    {
+        fprintf(stderr, "Failed to create software rendering context.\n");
+        return 1;
+    }
+
+    swglMakeCurrent(context);
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+
+    printf("%d frames of %d triangles at %dx%d with the %s rasterizer on %d threads.\n",
+        frameCount, TRIANGLES, width, height, swglGetInstructionSetName(swglGetInstructionSet()), swglGetThreadCount());
+
+    double synchronous = 0.0;
+
+    for(int depth = 0; depth <= 3; ++depth)
+    {
+        double queued;
+        double stalled;
+        double framesPerSecond = measure(frameCount, depth, &queued, &stalled);
+        synchronous = depth == 0 ? framesPerSecond : synchronous;
+
+        printf("Queue depth %d: %.1f frames/s, %.2fx, %.2f frames queued ahead, %.3f ms per frame waiting for them.\n",
+            depth, framesPerSecond, framesPerSecond / (synchronous > 0.0 ? synchronous : 1.0), queued, stalled);
+    }
+
+    swglMakeCurrent(NULL);
+    swglDeleteContext(context);
+    return 0;
+}
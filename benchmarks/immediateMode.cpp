@@ -0,0 +1,154 @@
+// Immediate mode benchmark of the headless software renderer.
+// Draws a mesh of 100k small triangles between one glBegin/glEnd pair per frame, with a glColor3f and a
+// glVertex3f call per vertex, once processing every primitive as it arrives and once with vertex batching,
+// and prints the API calls and vertices handled per second for both. The mesh is drawn once rasterized and once
+// with every triangle culled, which leaves the geometry stage alone.
+//
+// compile command
+// g++ -O3 immediateMode.cpp ../softwareRenderer/*.cpp -pthread -o immediateMode
+// ./immediateMode [-frames <count>] [-size <width>x<height>] [-threads <count>]
+//
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../softwareRenderer/softwareRenderer.h"
+
+#define GRID_COLUMNS 250 // The mesh is a grid of GRID_COLUMNS x GRID_ROWS cells, two triangles per cell.
+#define GRID_ROWS 200
+#define TRIANGLES (GRID_COLUMNS * GRID_ROWS * 2)
+#define CALLS_PER_FRAME (TRIANGLES * 6 + 2) // glColor3f and glVertex3f per vertex, plus glBegin and glEnd.
+
+static void vertex(int column, int row)
+{
+    glColor3f((float)column / GRID_COLUMNS, (float)row / GRID_ROWS, 0.5f);
+    glVertex3f(-1.0f + 2.0f * column / GRID_COLUMNS, -1.0f + 2.0f * row / GRID_ROWS, 0.0f);
+}
+
+void drawMesh(void)
+{
+    glBegin(GL_TRIANGLES);
+
+    for(int row = 0; row < GRID_ROWS; ++row)
+    {
+        for(int column = 0; column < GRID_COLUMNS; ++column)
+        {
+            vertex(column, row);
+            vertex(column + 1, row);
+            vertex(column + 1, row + 1);
+
+            vertex(column, row);
+            vertex(column + 1, row + 1);
+            vertex(column, row + 1);
+        }
+    }
+
+    glEnd();
+}
+
+struct Result
+{
+    double callsPerSecond; // Immediate mode calls issued per second, timed until glEnd() returns.
+    double verticesPerSecond; // Vertices per second through the whole frame, including rasterization.
+};
+
+// Renders frameCount frames and measures the calls and vertices handled per second.
+Result measure(int frameCount, int batching)
+{
+    swglSetVertexBatching(batching);
+
+    // One untimed frame to grow the buffers and warm up the caches.
+    glClear(GL_COLOR_BUFFER_BIT);
+    drawMesh();
+    swglSwapBuffers();
+
+    double callSeconds = 0.0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for(int frame = 0; frame < frameCount; ++frame)
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        std::chrono::steady_clock::time_point callStart = std::chrono::steady_clock::now();
+        drawMesh();
+        callSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - callStart).count();
+
+        swglSwapBuffers();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Result result;
+    result.callsPerSecond = (double)CALLS_PER_FRAME * frameCount / (callSeconds > 0.0 ? callSeconds : 1.0);
+    result.verticesPerSecond = (double)TRIANGLES * 3 * frameCount / (seconds > 0.0 ? seconds : 1.0);
+    return result;
+}
+
+void compare(const char *name, int frameCount)
+{
+    Result immediate = measure(frameCount, FALSE);
+    Result batched = measure(frameCount, TRUE);
+
+    printf("%s, immediate: %.1f million calls/s, %.1f million vertices/s.\n", name, immediate.callsPerSecond / 1000000.0, immediate.verticesPerSecond / 1000000.0);
+    printf("%s, batched: %.1f million calls/s, %.1f million vertices/s.\n", name, batched.callsPerSecond / 1000000.0, batched.verticesPerSecond / 1000000.0);
+}
+
+int main(int argc, char *argv[])
+{
+    int frameCount = 20;
+    int width = 1024;
+    int height = 768;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-frames") && i + 1 < argc)
+        {
+            frameCount = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-size") && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &width, &height) == 2)
+        {
+            ++i;
+        }
+        else if(!strcmp(argv[i], "-threads") && i + 1 < argc && swglSetThreadCount(atoi(argv[i + 1])))
+        {
+            ++i;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-frames <count>] [-size <width>x<height>] [-threads <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    HSWGLRC context = swglCreateContext(width, height);
+
+    if(!context)
+    {
+        fprintf(stderr, "Failed to create software rendering context.\n");
+        return 1;
+    }
+
+    swglMakeCurrent(context);
+    // The mesh is the same every frame, the draw cache would skip the geometry stage this measures.
+    swglSetDrawCache(FALSE);
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    printf("%d frames of %d triangles at %dx%d with the %s rasterizer on %d threads.\n",
+        frameCount, TRIANGLES, width, height, swglGetInstructionSetName(swglGetInstructionSet()), swglGetThreadCount());
+
+    compare("Rasterized", frameCount);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT_AND_BACK);
+    compare("Geometry only", frameCount);
+
+    swglMakeCurrent(NULL);
+    swglDeleteContext(context);
+    return 0;
+}
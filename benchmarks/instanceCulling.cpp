@@ -0,0 +1,191 @@
+// Instance culling benchmark of the headless software renderer.
+// Draws a field of rotating triangles and quads with swglDrawInstanced(), spread over an area 8 times wider and
+// taller than the 45 degree view of the samples so that most of them are off-screen, and prints the frames per
+// second and the visible and culled instances with each instance culling mode of swglSetInstanceCulling(). The
+// field is drawn once rasterized and once with every primitive face culled, which leaves the geometry stage alone.
+//
+// compile command
+// g++ -O3 instanceCulling.cpp ../softwareRenderer/*.cpp -pthread -o instanceCulling
+// ./instanceCulling [-frames <count>] [-size <width>x<height>] [-threads <count>] [-instances <count>]
+//
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../softwareRenderer/softwareRenderer.h"
+
+#define FIELD_DEPTH 20.0f // Distance of the field from the eye.
+#define FIELD_SPREAD 8.0f // Width and height of the field relative to the view at FIELD_DEPTH.
+#define TILE_COLUMNS 16 // Instances of a tile of the field are consecutive, half of them triangles and half quads.
+#define TILE_ROWS 8
+
+static const GLfloat trianglePositions[] = {0.0f, 1.0f, 0.0f, -1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f};
+static const GLfloat triangleColors[] = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+static const GLfloat squarePositions[] = {-1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, -1.0f, 0.0f, -1.0f, -1.0f, 0.0f};
+
+static int instanceCount = 100000;
+static GLfloat *triangleMatrices;
+static GLfloat *squareMatrices;
+
+// Places instance i of the field on a grid, rotated by angle degrees around the Y axis for triangles
+// and the X axis for quads, like polygonRotation.
+static void setInstance(GLfloat *matrix, int i, int column, int row, int columns, GLfloat spacing, GLfloat angle, bool square)
+{
+    GLfloat c = cosf((angle + i * 7.0f) * 3.14159265f / 180.0f);
+    GLfloat s = sinf((angle + i * 7.0f) * 3.14159265f / 180.0f);
+
+    memset(matrix, 0, 16 * sizeof(GLfloat));
+    matrix[0] = square ? 1.0f : c;
+    matrix[2] = square ? 0.0f : -s;
+    matrix[5] = square ? c : 1.0f;
+    matrix[6] = square ? s : 0.0f;
+    matrix[8] = square ? 0.0f : s;
+    matrix[9] = square ? -s : 0.0f;
+    matrix[10] = c;
+    matrix[12] = (column - (columns - 1) * 0.5f) * spacing;
+    matrix[13] = (row - (columns - 1) * 0.5f) * spacing;
+    matrix[14] = -FIELD_DEPTH;
+    matrix[15] = 1.0f;
+}
+
+static void drawField(int frame)
+{
+    int columns = (int)ceilf(sqrtf((GLfloat)instanceCount));
+    GLfloat spacing = 2.0f * FIELD_DEPTH * tanf(22.5f * 3.14159265f / 180.0f) * FIELD_SPREAD / columns;
+    int triangles = 0;
+    int squares = 0;
+
+    // Instances are ordered by tiles of TILE_COLUMNS x TILE_ROWS cells, which keeps those of a culling group close.
+    int tilesX = (columns + TILE_COLUMNS - 1) / TILE_COLUMNS;
+    int tileCells = TILE_COLUMNS * TILE_ROWS;
+    int cells = tilesX * tileCells * ((columns + TILE_ROWS - 1) / TILE_ROWS);
+
+    for(int cell = 0, i = 0; cell < cells && i < instanceCount; ++cell)
+    {
+        int tile = cell / tileCells;
+        int column = tile % tilesX * TILE_COLUMNS + cell % TILE_COLUMNS;
+        int row = tile / tilesX * TILE_ROWS + cell % tileCells / TILE_COLUMNS;
+
+        if(column >= columns || row >= columns)
+        {
+            continue;
+        }
+
+        if(i % 2 == 0)
+        {
+            setInstance(&triangleMatrices[triangles++ * 16], i, column, row, columns, spacing, frame * 0.2f, false);
+        }
+        else
+        {
+            setInstance(&squareMatrices[squares++ * 16], i, column, row, columns, spacing, frame * -0.15f, true);
+        }
+
+        ++i;
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    swglDrawInstanced(GL_TRIANGLES, 3, trianglePositions, triangleColors, triangles, triangleMatrices, NULL);
+    glColor3f(0.5f, 0.5f, 1.0f);
+    swglDrawInstanced(GL_QUADS, 4, squarePositions, NULL, squares, squareMatrices, NULL);
+    swglSwapBuffers();
+}
+
+// Renders frameCount frames with one instance culling mode and prints the frames per second.
+static void measure(const char *title, const char *name, int mode, int frameCount)
+{
+    swglSetInstanceCulling(mode);
+
+    // One untimed frame to grow the buffers and warm up the caches.
+    drawField(0);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for(int frame = 0; frame < frameCount; ++frame)
+    {
+        drawField(frame);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    SWGLFrameStats stats;
+    swglGetFrameStats(&stats);
+
+    printf("%s, %s: %.1f frames/s, %.3f ms/frame, %llu instances visible, %llu culled.\n", title, name,
+        frameCount / (seconds > 0.0 ? seconds : 1.0), seconds * 1000.0 / (frameCount > 0 ? frameCount : 1), stats.objectsVisible, stats.objectsCulled);
+}
+
+static void compare(const char *title, int frameCount)
+{
+    measure(title, "no culling", SWGL_INSTANCE_CULLING_NONE, frameCount);
+    measure(title, "bounding spheres", SWGL_INSTANCE_CULLING_SPHERES, frameCount);
+    measure(title, "grouped bounding spheres", SWGL_INSTANCE_CULLING_GROUPS, frameCount);
+}
+
+int main(int argc, char *argv[])
+{
+    int frameCount = 20;
+    int width = 1024;
+    int height = 768;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-frames") && i + 1 < argc)
+        {
+            frameCount = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-size") && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &width, &height) == 2)
+        {
+            ++i;
+        }
+        else if(!strcmp(argv[i], "-threads") && i + 1 < argc && swglSetThreadCount(atoi(argv[i + 1])))
+        {
+            ++i;
+        }
+        else if(!strcmp(argv[i], "-instances") && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            instanceCount = atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-frames <count>] [-size <width>x<height>] [-threads <count>] [-instances <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    HSWGLRC context = swglCreateContext(width, height);
+    triangleMatrices = (GLfloat *)malloc((size_t)instanceCount * 16 * sizeof(GLfloat));
+    squareMatrices = (GLfloat *)malloc((size_t)instanceCount * 16 * sizeof(GLfloat));
+
+    if(!context || !triangleMatrices || !squareMatrices)
+    {
+        fprintf(stderr, "Failed to create software rendering context.\n");
+        return 1;
+    }
+
+    swglMakeCurrent(context);
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluPerspective(45.0f, (GLfloat)width / (GLfloat)height, 0.1f, 100.0f);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
+
+    printf("%d frames of %d instances at %dx%d with the %s rasterizer on %d threads.\n",
+        frameCount, instanceCount, width, height, swglGetInstructionSetName(swglGetInstructionSet()), swglGetThreadCount());
+
+    compare("Rasterized", frameCount);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT_AND_BACK);
+    compare("Geometry only", frameCount);
+
+    swglMakeCurrent(NULL);
+    swglDeleteContext(context);
+    free(triangleMatrices);
+    free(squareMatrices);
+    return 0;
+}
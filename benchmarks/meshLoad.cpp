@@ -0,0 +1,244 @@
+// Mesh loading benchmark of the headless software renderer.
+// Writes a grid mesh as an OBJ file, an ASCII PLY file and a binary PLY file, then measures how many megabytes of
+// each swglLoadMesh() parses per second. The OBJ file is also read with std::getline() and std::istringstream,
+// the way a simple loader would, for comparison. The files are in the page cache after writing them, so the times
+// do not include the disk.
+//
+// compile command
+// g++ -O3 meshLoad.cpp ../softwareRenderer/*.cpp -pthread -o meshLoad
+// ./meshLoad [-size <grid size>] [-repeat <count>] [-threads <count>]
+//
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../softwareRenderer/softwareRenderer.h"
+
+#define OBJ_FILE "meshLoad.obj"
+#define ASCII_PLY_FILE "meshLoad.ascii.ply"
+#define BINARY_PLY_FILE "meshLoad.binary.ply"
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Vertex of a size by size grid, a wavy surface with a color per vertex.
+static void gridVertex(int size, int column, int row, float *vertex)
+{
+    float u = (float)column / (size - 1);
+    float v = (float)row / (size - 1);
+    vertex[0] = u * 2.0f - 1.0f;
+    vertex[1] = v * 2.0f - 1.0f;
+    vertex[2] = 0.1f * sinf(u * 31.0f) * cosf(v * 17.0f);
+    vertex[3] = u;
+    vertex[4] = v;
+    vertex[5] = 1.0f - u * v;
+}
+
+// Writes the grid in all three formats, every cell as a quad. Returns the size of each file.
+static bool writeMeshes(int size, size_t fileSizes[3])
+{
+    FILE *obj = fopen(OBJ_FILE, "wb");
+    FILE *asciiPly = fopen(ASCII_PLY_FILE, "wb");
+    FILE *binaryPly = fopen(BINARY_PLY_FILE, "wb");
+    bool written = obj && asciiPly && binaryPly;
+
+    if(written)
+    {
+        int vertexCount = size * size;
+        int faceCount = (size - 1) * (size - 1);
+        const char *header = "ply\nformat %s 1.0\nelement vertex %d\nproperty float x\nproperty float y\nproperty float z\n"
+            "property uchar red\nproperty uchar green\nproperty uchar blue\nelement face %d\n"
+            "property list uchar int vertex_indices\nend_header\n";
+        fprintf(asciiPly, header, "ascii", vertexCount, faceCount);
+        fprintf(binaryPly, header, "binary_little_endian", vertexCount, faceCount);
+        fprintf(obj, "# %d by %d grid\n", size, size);
+
+        for(int row = 0; row < size; ++row)
+        {
+            for(int column = 0; column < size; ++column)
+            {
+                float vertex[6];
+                unsigned char color[3];
+                gridVertex(size, column, row, vertex);
+
+                for(int i = 0; i < 3; ++i)
+                {
+                    color[i] = (unsigned char)(vertex[3 + i] * 255.0f + 0.5f);
+                }
+
+                fprintf(obj, "v %.6f %.6f %.6f %.6f %.6f %.6f\n", vertex[0], vertex[1], vertex[2], vertex[3], vertex[4], vertex[5]);
+                fprintf(asciiPly, "%.6f %.6f %.6f %d %d %d\n", vertex[0], vertex[1], vertex[2], color[0], color[1], color[2]);
+                fwrite(vertex, sizeof(float), 3, binaryPly);
+                fwrite(color, 1, 3, binaryPly);
+            }
+        }
+
+        for(int row = 0; row + 1 < size; ++row)
+        {
+            for(int column = 0; column + 1 < size; ++column)
+            {
+                int quad[4] = {row * size + column, row * size + column + 1, (row + 1) * size + column + 1, (row + 1) * size + column};
+                unsigned char count = 4;
+                fprintf(obj, "f %d %d %d %d\n", quad[0] + 1, quad[1] + 1, quad[2] + 1, quad[3] + 1);
+                fprintf(asciiPly, "4 %d %d %d %d\n", quad[0], quad[1], quad[2], quad[3]);
+                fwrite(&count, 1, 1, binaryPly);
+                fwrite(quad, sizeof(int), 4, binaryPly);
+            }
+        }
+
+        fileSizes[0] = (size_t)ftell(obj);
+        fileSizes[1] = (size_t)ftell(asciiPly);
+        fileSizes[2] = (size_t)ftell(binaryPly);
+    }
+
+    written = (!obj || fclose(obj) == 0) && written;
+    written = (!asciiPly || fclose(asciiPly) == 0) && written;
+    written = (!binaryPly || fclose(binaryPly) == 0) && written;
+    return written;
+}
+
+// OBJ loading the way a simple loader does it, a line at a time through a string stream.
+static bool loadObjWithStreams(const char *fileName, std::vector<float> &vertices, std::vector<unsigned int> &indices)
+{
+    std::ifstream file(fileName);
+    std::string line;
+
+    if(!file)
+    {
+        return false;
+    }
+
+    while(std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string command;
+        stream >> command;
+
+        if(command == "v")
+        {
+            float value[6] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+            stream >> value[0] >> value[1] >> value[2] >> value[3] >> value[4] >> value[5];
+            vertices.insert(vertices.end(), value, value + 6);
+        }
+        else if(command == "f")
+        {
+            std::vector<unsigned int> face;
+            std::string corner;
+
+            while(stream >> corner)
+            {
+                face.push_back((unsigned int)atoi(corner.c_str()) - 1);
+            }
+
+            for(size_t i = 2; i < face.size(); ++i)
+            {
+                indices.push_back(face[0]);
+                indices.push_back(face[i - 1]);
+                indices.push_back(face[i]);
+            }
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int size = 1000;
+    int repeatCount = 5;
+    int threadCount = 0;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-size") && i + 1 < argc && atoi(argv[i + 1]) >= 2 && atoi(argv[i + 1]) <= 20000)
+        {
+            size = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-repeat") && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            repeatCount = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-threads") && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            threadCount = atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-size <grid size>] [-repeat <count>] [-threads <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    size_t fileSizes[3];
+
+    if(!writeMeshes(size, fileSizes))
+    {
+        fprintf(stderr, "Failed to write the mesh files.\n");
+        return 1;
+    }
+
+    swglSetThreadCount(threadCount);
+
+    const char *fileNames[3] = {OBJ_FILE, ASCII_PLY_FILE, BINARY_PLY_FILE};
+    const char *names[3] = {"OBJ", "ASCII PLY", "Binary PLY"};
+    double times[4] = {0.0, 0.0, 0.0, 0.0};
+    GLsizei triangleCounts[3] = {0, 0, 0};
+    bool failed = false;
+
+    for(int repeat = 0; repeat < repeatCount && !failed; ++repeat)
+    {
+        for(int format = 0; format < 3 && !failed; ++format)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            HSWGLMESH mesh = swglLoadMesh(fileNames[format]);
+            times[format] += millisecondsSince(start);
+            failed = !mesh;
+
+            if(mesh)
+            {
+                swglGetMeshData(mesh, NULL, NULL, &triangleCounts[format], NULL);
+                triangleCounts[format] /= 3;
+                swglDeleteMesh(mesh);
+            }
+        }
+
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        failed = failed || !loadObjWithStreams(OBJ_FILE, vertices, indices);
+        times[3] += millisecondsSince(start);
+    }
+
+    for(int format = 0; format < 3; ++format)
+    {
+        remove(fileNames[format]);
+    }
+
+    if(failed)
+    {
+        fprintf(stderr, "Failed to load the mesh files.\n");
+        return 1;
+    }
+
+    printf("Grid of %d by %d vertices, %d triangles, %d threads.\n", size, size, (int)triangleCounts[0], swglGetThreadCount());
+
+    for(int format = 0; format < 4; ++format)
+    {
+        double milliseconds = times[format] / repeatCount;
+        size_t fileSize = fileSizes[format < 3 ? format : 0];
+        printf("%-32s %6.1f MB in %8.2f ms, %7.1f MB/s.\n", format < 3 ? names[format] : "OBJ with std::istringstream",
+            fileSize / 1048576.0, milliseconds, fileSize / 1048576.0 / (milliseconds / 1000.0));
+    }
+
+    return 0;
+}
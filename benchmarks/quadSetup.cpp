@@ -0,0 +1,146 @@
+// Quad setup benchmark of the headless software renderer.
+// Draws screen-filling and tiny quads, once split into two triangles and once set up as single primitives,
+// and prints the quads rendered per second for both.
+//
+// compile command
+// g++ -O3 quadSetup.cpp ../softwareRenderer/*.cpp -pthread -o quadSetup
+// ./quadSetup [-frames <count>] [-size <width>x<height>] [-threads <count>]
+//
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../softwareRenderer/softwareRenderer.h"
+
+#define SCREEN_QUADS 32 // Quads covering the whole viewport drawn per frame.
+#define TINY_GRID 256 // Tiny quads are drawn on a grid of TINY_GRID x TINY_GRID cells per frame.
+
+// Quads covering the viewport, one color each. Without depth test every quad writes every pixel.
+void drawScreenQuads(void)
+{
+    glBegin(GL_QUADS);
+
+    for(int i = 0; i < SCREEN_QUADS; ++i)
+    {
+        float shade = (float)i / SCREEN_QUADS;
+        glColor3f(shade, 1.0f - shade, 0.5f);
+        glVertex3f(-1.0f, -1.0f, 0.0f);
+        glVertex3f(1.0f, -1.0f, 0.0f);
+        glVertex3f(1.0f, 1.0f, 0.0f);
+        glVertex3f(-1.0f, 1.0f, 0.0f);
+    }
+
+    glEnd();
+}
+
+// One quad per grid cell, covering half the cell in each direction.
+void drawTinyQuads(void)
+{
+    const float cell = 2.0f / TINY_GRID;
+
+    glBegin(GL_QUADS);
+
+    for(int row = 0; row < TINY_GRID; ++row)
+    {
+        for(int column = 0; column < TINY_GRID; ++column)
+        {
+            float x = -1.0f + column * cell;
+            float y = -1.0f + row * cell;
+            glColor3f((float)column / TINY_GRID, (float)row / TINY_GRID, 0.5f);
+            glVertex3f(x, y, 0.0f);
+            glVertex3f(x + cell * 0.5f, y, 0.0f);
+            glVertex3f(x + cell * 0.5f, y + cell * 0.5f, 0.0f);
+            glVertex3f(x, y + cell * 0.5f, 0.0f);
+        }
+    }
+
+    glEnd();
+}
+
+// Renders frameCount frames and returns the quads drawn per second.
+double measure(void (*drawQuads)(void), int quadsPerFrame, int frameCount, int nativeQuads)
+{
+    swglSetNativeQuads(nativeQuads);
+
+    // One untimed frame to grow the bins and warm up the caches.
+    glClear(GL_COLOR_BUFFER_BIT);
+    drawQuads();
+    swglSwapBuffers();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for(int frame = 0; frame < frameCount; ++frame)
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+        drawQuads();
+        swglSwapBuffers();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return (double)quadsPerFrame * frameCount / (seconds > 0.0 ? seconds : 1.0);
+}
+
+void compare(const char *name, void (*drawQuads)(void), int quadsPerFrame, int frameCount)
+{
+    double split = measure(drawQuads, quadsPerFrame, frameCount, FALSE);
+    double native = measure(drawQuads, quadsPerFrame, frameCount, TRUE);
+
+    printf("%s: %.0f quads/s split into triangles, %.0f quads/s native, %.2fx.\n",
+        name, split, native, native / (split > 0.0 ? split : 1.0));
+}
+
+int main(int argc, char *argv[])
+{
+    int frameCount = 100;
+    int width = 1024;
+    int height = 768;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-frames") && i + 1 < argc)
+        {
+            frameCount = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-size") && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &width, &height) == 2)
+        {
+            ++i;
+        }
+        else if(!strcmp(argv[i], "-threads") && i + 1 < argc && swglSetThreadCount(atoi(argv[i + 1])))
+        {
+            ++i;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-frames <count>] [-size <width>x<height>] [-threads <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    HSWGLRC context = swglCreateContext(width, height);
+
+    if(!context)
+    {
+        fprintf(stderr, "Failed to create software rendering context.\n");
+        return 1;
+    }
+
+    swglMakeCurrent(context);
+    // The quads are the same every frame, the draw cache would skip the setup this measures.
+    swglSetDrawCache(FALSE);
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    printf("%d frames at %dx%d with the %s rasterizer on %d threads.\n",
+        frameCount, width, height, swglGetInstructionSetName(swglGetInstructionSet()), swglGetThreadCount());
+    compare("Screen-filling quads", drawScreenQuads, SCREEN_QUADS, frameCount);
+    compare("Tiny quads", drawTinyQuads, TINY_GRID * TINY_GRID, frameCount);
+
+    swglMakeCurrent(NULL);
+    swglDeleteContext(context);
+    return 0;
+}
@@ -0,0 +1,208 @@
+// Scene loading benchmark of the headless software renderer.
+// Writes a scene file of 1000 objects with 1000 triangles each, then measures swglLoadScene(), which only maps the
+// file, the first swglDrawScene() after loading, which reads the vertices through page faults, a later draw, and
+// reading the whole file into memory with fread() for comparison. The file is in the page cache after writing it,
+// so the times do not include the disk. Draws cull every face, which leaves the geometry stage alone.
+//
+// compile command
+// g++ -O3 sceneLoad.cpp ../softwareRenderer/*.cpp -pthread -o sceneLoad
+// ./sceneLoad [-repeat <count>] [-file <file.scene>]
+//
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "../softwareRenderer/softwareRenderer.h"
+#include "../softwareRenderer/sceneFormat.h"
+
+#define OBJECTS 1000
+#define TRIANGLES_PER_OBJECT 1000
+#define OBJECT_COLUMNS 40 // Objects are laid out on a grid in front of the eye.
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static size_t alignedSize(size_t size)
+{
+    return (size + SW_SCENE_ALIGNMENT - 1) / SW_SCENE_ALIGNMENT * SW_SCENE_ALIGNMENT;
+}
+
+// Writes the scene: every object is a fan of thin triangles inside the unit circle, rotating at its own rate.
+static bool writeScene(const char *fileName)
+{
+    SWSceneHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SW_SCENE_MAGIC, sizeof(header.magic));
+    header.version = SW_SCENE_VERSION;
+    header.objectCount = OBJECTS;
+    header.vertexCount = (uint64_t)OBJECTS * TRIANGLES_PER_OBJECT * 3;
+    header.objectOffset = alignedSize(sizeof(header));
+    header.vertexOffset = header.objectOffset + alignedSize(OBJECTS * sizeof(SWSceneObject));
+
+    std::vector<unsigned char> data(header.vertexOffset + header.vertexCount * sizeof(SWSceneVertex));
+    memcpy(data.data(), &header, sizeof(header));
+    SWSceneObject *objects = (SWSceneObject *)&data[header.objectOffset];
+    SWSceneVertex *vertices = (SWSceneVertex *)&data[header.vertexOffset];
+
+    for(int i = 0; i < OBJECTS; ++i)
+    {
+        SWSceneObject *object = &objects[i];
+        object->mode = GL_TRIANGLES;
+        object->vertexCount = TRIANGLES_PER_OBJECT * 3;
+        object->firstVertex = (uint64_t)i * TRIANGLES_PER_OBJECT * 3;
+        object->translation[0] = (i % OBJECT_COLUMNS - (OBJECT_COLUMNS - 1) * 0.5f) * 2.5f;
+        object->translation[1] = (i / OBJECT_COLUMNS - (OBJECTS / OBJECT_COLUMNS - 1) * 0.5f) * 2.5f;
+        object->translation[2] = -80.0f;
+        object->axis[i % 2] = 1.0f;
+        object->rate = 0.1f + (i % 7) * 0.05f;
+        object->radius = 1.0f;
+
+        for(int triangle = 0; triangle < TRIANGLES_PER_OBJECT; ++triangle)
+        {
+            float angle = triangle * 6.2831853f / TRIANGLES_PER_OBJECT;
+            float next = (triangle + 1) * 6.2831853f / TRIANGLES_PER_OBJECT;
+            SWSceneVertex *vertex = &vertices[object->firstVertex + triangle * 3];
+            SWSceneVertex center = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+            SWSceneVertex first = {cosf(angle), sinf(angle), 0.0f, (float)(i % 3) * 0.5f, 0.5f, 1.0f};
+            SWSceneVertex second = {cosf(next), sinf(next), 0.0f, 1.0f, (float)(i % 5) * 0.25f, 0.5f};
+            vertex[0] = center;
+            vertex[1] = first;
+            vertex[2] = second;
+        }
+    }
+
+    FILE *file = fopen(fileName, "wb");
+
+    if(!file)
+    {
+        return false;
+    }
+
+    bool written = fwrite(data.data(), data.size(), 1, file) == 1;
+    return fclose(file) == 0 && written;
+}
+
+int main(int argc, char *argv[])
+{
+    int repeatCount = 10;
+    const char *fileName = "sceneLoad.scene";
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-repeat") && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            repeatCount = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-file") && i + 1 < argc)
+        {
+            fileName = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-repeat <count>] [-file <file.scene>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(!writeScene(fileName))
+    {
+        fprintf(stderr, "Failed to write '%s'.\n", fileName);
+        return 1;
+    }
+
+    HSWGLRC context = swglCreateContext(640, 480);
+
+    if(!context)
+    {
+        fprintf(stderr, "Failed to create software rendering context.\n");
+        remove(fileName);
+        return 1;
+    }
+
+    swglMakeCurrent(context);
+    // A scene drawn twice at the same frame would replay its objects instead of reading their vertices.
+    swglSetDrawCache(FALSE);
+    glViewport(0, 0, 640, 480);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluPerspective(45.0f, 640.0f / 480.0f, 0.1f, 100.0f);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT_AND_BACK);
+
+    double load = 0.0;
+    double firstDraw = 0.0;
+    double draw = 0.0;
+    double read = 0.0;
+    size_t fileSize = 0;
+    bool failed = false;
+
+    for(int repeat = 0; repeat < repeatCount && !failed; ++repeat)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        HSWGLSCENE scene = swglLoadScene(fileName);
+        load += millisecondsSince(start);
+
+        if(!scene)
+        {
+            failed = true;
+            break;
+        }
+
+        start = std::chrono::steady_clock::now();
+        swglDrawScene(scene, (GLfloat)repeat);
+        swglSwapBuffers();
+        firstDraw += millisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        swglDrawScene(scene, (GLfloat)repeat + 1.0f);
+        swglSwapBuffers();
+        draw += millisecondsSince(start);
+
+        swglDeleteScene(scene);
+
+        // Reading the file into memory is the least a loader copying the vertices has to do.
+        start = std::chrono::steady_clock::now();
+        FILE *file = fopen(fileName, "rb");
+
+        if(!file)
+        {
+            failed = true;
+            break;
+        }
+
+        fseek(file, 0, SEEK_END);
+        fileSize = (size_t)ftell(file);
+        fseek(file, 0, SEEK_SET);
+        unsigned char *data = (unsigned char *)malloc(fileSize);
+        failed = !data || fread(data, fileSize, 1, file) != 1;
+        fclose(file);
+        free(data);
+        read += millisecondsSince(start);
+    }
+
+    swglMakeCurrent(NULL);
+    swglDeleteContext(context);
+    remove(fileName);
+
+    if(failed)
+    {
+        fprintf(stderr, "Failed to load '%s'.\n", fileName);
+        return 1;
+    }
+
+    printf("Scene of %d objects and %d triangles, %.1f MB.\n", OBJECTS, OBJECTS * TRIANGLES_PER_OBJECT, fileSize / 1048576.0);
+    printf("swglLoadScene: %.3f ms.\n", load / repeatCount);
+    printf("First swglDrawScene after loading: %.3f ms.\n", firstDraw / repeatCount);
+    printf("Later swglDrawScene: %.3f ms.\n", draw / repeatCount);
+    printf("fread of the whole file: %.3f ms.\n", read / repeatCount);
+    return 0;
+}
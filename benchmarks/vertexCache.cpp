@@ -0,0 +1,195 @@
+// Post-transform vertex cache benchmark of the headless software renderer.
+// Draws a grid mesh of 100k triangles per frame with glDrawElements(), with the triangles in row order, shuffled,
+// and shuffled then reordered by swglOptimizeVertexCache(), each with the vertex cache on and off. Prints the
+// frames per second and the share of indices found in the cache. The mesh is drawn once rasterized and once with
+// every triangle culled, which leaves the geometry stage alone.
+//
+// compile command
+// g++ -O3 vertexCache.cpp ../softwareRenderer/*.cpp -pthread -o vertexCache
+// ./vertexCache [-frames <count>] [-size <width>x<height>] [-threads <count>]
+//
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "../softwareRenderer/softwareRenderer.h"
+
+#define GRID_COLUMNS 250 // The mesh is a grid of GRID_COLUMNS x GRID_ROWS cells, two triangles per cell.
+#define GRID_ROWS 200
+#define TRIANGLES (GRID_COLUMNS * GRID_ROWS * 2)
+#define VERTICES ((GRID_COLUMNS + 1) * (GRID_ROWS + 1))
+
+static GLfloat positions[VERTICES * 3];
+static GLfloat colors[VERTICES * 3];
+
+// Fills the vertex arrays and returns the triangles of the grid, row by row.
+static std::vector<GLuint> buildMesh(void)
+{
+    std::vector<GLuint> indices;
+
+    for(int row = 0; row <= GRID_ROWS; ++row)
+    {
+        for(int column = 0; column <= GRID_COLUMNS; ++column)
+        {
+            int vertex = row * (GRID_COLUMNS + 1) + column;
+            positions[vertex * 3] = -1.0f + 2.0f * column / GRID_COLUMNS;
+            positions[vertex * 3 + 1] = -1.0f + 2.0f * row / GRID_ROWS;
+            positions[vertex * 3 + 2] = 0.0f;
+            colors[vertex * 3] = (float)column / GRID_COLUMNS;
+            colors[vertex * 3 + 1] = (float)row / GRID_ROWS;
+            colors[vertex * 3 + 2] = 0.5f;
+        }
+    }
+
+    for(int row = 0; row < GRID_ROWS; ++row)
+    {
+        for(int column = 0; column < GRID_COLUMNS; ++column)
+        {
+            GLuint corner = row * (GRID_COLUMNS + 1) + column;
+            GLuint above = corner + GRID_COLUMNS + 1;
+            GLuint cell[6] = {corner, corner + 1, above + 1, corner, above + 1, above};
+            indices.insert(indices.end(), cell, cell + 6);
+        }
+    }
+
+    return indices;
+}
+
+// Renders frameCount frames of the mesh and returns the frames per second. Sets hitRate to the share of indices
+// found in the vertex cache.
+static double measure(int frameCount, const std::vector<GLuint> &indices, double *hitRate)
+{
+    // One untimed frame to warm up the caches.
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, indices.data());
+    swglSwapBuffers();
+
+    SWGLFrameStats stats;
+    swglGetFrameStats(&stats);
+    *hitRate = stats.vertexCacheLookups ? (double)stats.vertexCacheHits / stats.vertexCacheLookups : 0.0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for(int frame = 0; frame < frameCount; ++frame)
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, indices.data());
+        swglSwapBuffers();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return frameCount / (seconds > 0.0 ? seconds : 1.0);
+}
+
+static void compare(const char *name, int frameCount, const std::vector<GLuint> orders[3])
+{
+    static const char *orderNames[3] = {"row order", "shuffled", "optimized"};
+
+    for(int order = 0; order < 3; ++order)
+    {
+        double hitRate;
+        swglSetVertexCache(FALSE);
+        double uncached = measure(frameCount, orders[order], &hitRate);
+        swglSetVertexCache(TRUE);
+        double cached = measure(frameCount, orders[order], &hitRate);
+
+        printf("%s, %s: %.1f frames/s without the vertex cache, %.1f frames/s with it, %.2fx, %.1f%% hits.\n",
+            name, orderNames[order], uncached, cached, cached / (uncached > 0.0 ? uncached : 1.0), hitRate * 100.0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int frameCount = 20;
+    int width = 1024;
+    int height = 768;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-frames") && i + 1 < argc)
+        {
+            frameCount = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-size") && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &width, &height) == 2)
+        {
+            ++i;
+        }
+        else if(!strcmp(argv[i], "-threads") && i + 1 < argc && swglSetThreadCount(atoi(argv[i + 1])))
+        {
+            ++i;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-frames <count>] [-size <width>x<height>] [-threads <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    HSWGLRC context = swglCreateContext(width, height);
+
+    if(!context)
+    {
+        fprintf(stderr, "Failed to create software rendering context.\n");
+        return 1;
+    }
+
+    swglMakeCurrent(context);
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    printf("%d frames of %d triangles and %d vertices at %dx%d with the %s rasterizer on %d threads.\n",
+        frameCount, TRIANGLES, VERTICES, width, height, swglGetInstructionSetName(swglGetInstructionSet()), swglGetThreadCount());
+
+    std::vector<GLuint> orders[3];
+    orders[0] = buildMesh();
+    orders[1] = orders[0];
+
+    // Fisher-Yates shuffle of whole triangles with a fixed seed.
+    unsigned int seed = 12345;
+
+    for(int triangle = TRIANGLES - 1; triangle > 0; --triangle)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        int other = (int)((seed >> 8) % (unsigned int)(triangle + 1));
+
+        for(int corner = 0; corner < 3; ++corner)
+        {
+            GLuint index = orders[1][triangle * 3 + corner];
+            orders[1][triangle * 3 + corner] = orders[1][other * 3 + corner];
+            orders[1][other * 3 + corner] = index;
+        }
+    }
+
+    orders[2] = orders[1];
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if(!swglOptimizeVertexCache(orders[2].data(), (GLsizei)orders[2].size(), VERTICES))
+    {
+        fprintf(stderr, "Failed to optimize the mesh.\n");
+        return 1;
+    }
+
+    printf("swglOptimizeVertexCache: %.1f ms.\n", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, positions);
+    glColorPointer(3, GL_FLOAT, 0, colors);
+
+    compare("Rasterized", frameCount, orders);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT_AND_BACK);
+    compare("Geometry only", frameCount, orders);
+
+    swglMakeCurrent(NULL);
+    swglDeleteContext(context);
+    return 0;
+}
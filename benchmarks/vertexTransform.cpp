@@ -0,0 +1,114 @@
+// Geometry stage benchmark of the headless software renderer.
+// Runs the model-view-projection transform, clip codes, perspective divide, viewport transform and snapping of
+// swTransformVertices() over batches of random vertices, once with the scalar code and once with the widest
+// instruction set of the CPU, and prints the vertices transformed per second for both.
+//
+// compile command
+// g++ -O3 vertexTransform.cpp ../softwareRenderer/*.cpp -pthread -o vertexTransform
+// ./vertexTransform [-frames <count>] [-size <width>x<height>]
+//
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "../softwareRenderer/context.h"
+
+#define VERTICES 1000000 // Vertices transformed per frame.
+#define BATCH_VERTICES 768 // Vertices per call, the batch size of the immediate mode vertex recording.
+
+// Transforms the vertices frameCount times and returns the vertices transformed per second.
+double measure(const std::vector<SWRecordedVertex> &vertices, std::vector<SWTransformedVertex> &output, int frameCount, int instructionSet)
+{
+    swglSetInstructionSet(instructionSet);
+    SWGLContext *context = swglGetCurrentContext();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for(int frame = 0; frame < frameCount; ++frame)
+    {
+        for(int first = 0; first < VERTICES; first += BATCH_VERTICES)
+        {
+            int count = VERTICES - first < BATCH_VERTICES ? VERTICES - first : BATCH_VERTICES;
+            swTransformVertices(context, swGetModelviewProjection(context), context->guardBandX, context->guardBandY, &vertices[first], count, &output[0]);
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return (double)VERTICES * frameCount / (seconds > 0.0 ? seconds : 1.0);
+}
+
+int main(int argc, char *argv[])
+{
+    int frameCount = 100;
+    int width = 1024;
+    int height = 768;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-frames") && i + 1 < argc)
+        {
+            frameCount = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-size") && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &width, &height) == 2)
+        {
+            ++i;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-frames <count>] [-size <width>x<height>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    HSWGLRC context = swglCreateContext(width, height);
+
+    if(!context)
+    {
+        fprintf(stderr, "Failed to create software rendering context.\n");
+        return 1;
+    }
+
+    swglMakeCurrent(context);
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluPerspective(45.0, (GLdouble)width / height, 0.1, 100.0);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glTranslatef(0.0f, 0.0f, -6.0f);
+    glRotatef(30.0f, 0.0f, 1.0f, 0.0f);
+
+    // Random vertices in a cube around the origin, most of them visible.
+    std::vector<SWRecordedVertex> vertices(VERTICES);
+    std::vector<SWTransformedVertex> output(BATCH_VERTICES); // Reused by every batch, like the vertex recording does.
+    srand(1);
+
+    for(int i = 0; i < VERTICES; ++i)
+    {
+        vertices[i].x = (float)rand() / RAND_MAX * 4.0f - 2.0f;
+        vertices[i].y = (float)rand() / RAND_MAX * 4.0f - 2.0f;
+        vertices[i].z = (float)rand() / RAND_MAX * 4.0f - 2.0f;
+        vertices[i].r = (float)rand() / RAND_MAX;
+        vertices[i].g = (float)rand() / RAND_MAX;
+        vertices[i].b = (float)rand() / RAND_MAX;
+    }
+
+    int widest = swglGetInstructionSet();
+    printf("%d frames of %d vertices at %dx%d.\n", frameCount, VERTICES, width, height);
+
+    // One untimed frame to touch the output and warm up the caches.
+    measure(vertices, output, 1, widest);
+
+    double scalar = measure(vertices, output, frameCount, SWGL_INSTRUCTION_SET_SCALAR);
+    double vector = measure(vertices, output, frameCount, widest);
+
+    printf("scalar: %.1f million vertices/s.\n", scalar / 1000000.0);
+    printf("%s: %.1f million vertices/s, %.2fx.\n", swglGetInstructionSetName(widest), vector / 1000000.0, vector / (scalar > 0.0 ? scalar : 1.0));
+
+    swglMakeCurrent(NULL);
+    swglDeleteContext(context);
+    return 0;
+}
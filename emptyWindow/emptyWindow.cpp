@@ -1,17 +1,25 @@
+#ifdef SOFTWARE_RENDERER
+#include "../softwareRenderer/softwareRenderer.h"
+#else
 #include<windows.h>
 #include<gl\gl.h>
 #include<gl\glu.h>
+#include "../softwareRenderer/frameScheduler.h"
+#endif
 
+#ifndef SOFTWARE_RENDERER
 HGLRC hRenderingContext = NULL; // Permanent rendering context.
 HDC hDeviceContext = NULL; // Private GDI device context.
 HWND hWindow = NULL; // Window handle.
 HINSTANCE hInstance = NULL; // Application instance.
 TCHAR className[] = TEXT("OpenGlWindow");
 TCHAR windowTitle[] = TEXT("OpenGL Empty Window");
+#endif
 
 bool keys[256]; // Used for keyboard routine.
 bool active = TRUE; // Windows active flag. TRUE by default.
 bool fullScreen = TRUE; // Full screen flag. TRUE by default.
+bool sceneChanged = TRUE; // The next frame differs from the one presented, only then a frame is drawn.
 
 int windowWidth = 640;
 int windowHeight = 480;
@@ -23,8 +31,10 @@ GLfloat greenColor = 0.0f;
 GLfloat blueColor = 0.0f;
 GLfloat alpha = 0.0f;
 
+#ifndef SOFTWARE_RENDERER
 // Window event callback method.
 LRESULT CALLBACK WndProc(HWND hWindow, UINT iMessage, WPARAM wParam, LPARAM lParam);
+#endif
 
 // Resize and initialize GL window.
 GLvoid resizeGLScene(GLsizei width, GLsizei height)
@@ -65,6 +75,7 @@ int drawGLScene(GLvoid)
     return TRUE; // Everything is ok.
 }
 
+#ifndef SOFTWARE_RENDERER
 // Clean up.
 GLvoid killGLWindow(GLvoid)
 {
@@ -362,6 +373,7 @@ GLvoid updateRedColor()
             redColor += colorUpdateThreshold; // Increment redColor by 0.01f value.
             redColor = min(1.0f, max(redColor, 0.0f)); // keep redGolor value in range of 0.0f to 1.0f
             glClearColor(redColor, greenColor, blueColor, alpha); // Set background color.
+            sceneChanged = TRUE;
         }
         else if(keys[VK_DOWN])
         {
@@ -369,6 +381,7 @@ GLvoid updateRedColor()
             redColor -= colorUpdateThreshold; // Decrement redColor by 0.01f value.
             redColor = min(1.0f, max(redColor, 0.0f)); // keep redGolor value in range of 0.0f to 1.0f
             glClearColor(redColor, greenColor, blueColor, alpha); // Set background color.
+            sceneChanged = TRUE;
         }
     }
 }
@@ -383,6 +396,7 @@ GLvoid updateGreenColor()
             greenColor += colorUpdateThreshold; // Increment greenColor by 0.01f value.
             greenColor = min(1.0f, max(greenColor, 0.0f)); // keep greenColor value in range of 0.0f to 1.0f
             glClearColor(redColor, greenColor, blueColor, alpha); // Set background color.
+            sceneChanged = TRUE;
         }
         else if(keys[VK_DOWN])
         {
@@ -390,6 +404,7 @@ GLvoid updateGreenColor()
             greenColor -= colorUpdateThreshold; // Decrement greenColor by 0.01f value.
             greenColor = min(1.0f, max(greenColor, 0.0f)); // keep greenColor value in range of 0.0f to 1.0f
             glClearColor(redColor, greenColor, blueColor, alpha); // Set background color.
+            sceneChanged = TRUE;
         }
     }
 }
@@ -404,6 +419,7 @@ GLvoid updateBlueColor()
             blueColor += colorUpdateThreshold; // Increment blueColor by 0.01f value.
             blueColor = min(1.0f, max(blueColor, 0.0f)); // keep blueColor value in range of 0.0f to 1.0f
             glClearColor(redColor, greenColor, blueColor, alpha); // Set background color.
+            sceneChanged = TRUE;
         }
         else if(keys[VK_DOWN])
         {
@@ -411,6 +427,7 @@ GLvoid updateBlueColor()
             blueColor -= colorUpdateThreshold; // Decrement greenColor by 0.01f value.
             blueColor = min(1.0f, max(blueColor, 0.0f)); // keep blueColor value in range of 0.0f to 1.0f
             glClearColor(redColor, greenColor, blueColor, alpha); // Set background color.
+            sceneChanged = TRUE;
         }
     }
 }
@@ -425,6 +442,7 @@ GLvoid updateAlpha()
             alpha += colorUpdateThreshold; // Increment alpha by 0.01f value.
             alpha = min(1.0f, max(alpha, 0.0f)); // keep alpha value in range of 0.0f to 1.0f
             glClearColor(redColor, greenColor, blueColor, alpha); // Set background color.
+            sceneChanged = TRUE;
         }
         else if(keys[VK_DOWN])
         {
@@ -432,6 +450,7 @@ GLvoid updateAlpha()
             alpha -= colorUpdateThreshold; // Decrement alpha by 0.01f value.
             alpha = min(1.0f, max(alpha, 0.0f)); // keep alpha value in range of 0.0f to 1.0f
             glClearColor(redColor, greenColor, blueColor, alpha); // Set background color.
+            sceneChanged = TRUE;
         }
     }
 }
@@ -480,6 +499,7 @@ LRESULT CALLBACK WndProc(HWND hWindow, UINT iMessage,  WPARAM wParam, LPARAM lPa
 
     case WM_SIZE:
         resizeGLScene(LOWORD(lParam), HIWORD(lParam));
+        sceneChanged = TRUE;
         return 0;
 
     case WM_PAINT:
@@ -517,6 +537,18 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         return 0;
     }
 
+    // Frames are paced to the refresh rate of the display, unless the command line has -fps <rate|uncapped|vsync>.
+    SWFrameScheduler scheduler;
+    int pacing = SW_FRAME_PACING_VSYNC;
+    double frameRate = GetDeviceCaps(hDeviceContext, VREFRESH) > 1 ? GetDeviceCaps(hDeviceContext, VREFRESH) : 60.0;
+
+    if(!swParseFramePacingOption(lpCmdLine, &pacing, &frameRate) || !swInitFrameScheduler(&scheduler, pacing, frameRate))
+    {
+        killGLWindow();
+        MessageBox(NULL, TEXT("Invalid -fps option, expected a frame rate, uncapped or vsync."), TEXT("Error!"), MB_OK | MB_ICONEXCLAMATION);
+        return 0;
+    }
+
     while(!done)
     {
         if(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
@@ -531,33 +563,51 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
                 DispatchMessage(&msg);
             }
         }
+        else if(!active)
+        {
+            WaitMessage(); // Nothing is drawn while inactive, sleep until a message arrives.
+        }
         else
         {
-            if(active)
+            // The keys are the only input changing the scene.
+            updateRedColor();
+            updateGreenColor();
+            updateBlueColor();
+            updateAlpha();
+
+            if(keys[VK_ESCAPE])
+            {
+                done = TRUE;
+            }
+            else if(!sceneChanged)
+            {
+                WaitMessage(); // The presented frame is still current, sleep until a message arrives.
+            }
+            else if(swWaitForFrame(&scheduler)) // Returns early for messages arriving while waiting.
+            {
+                drawGLScene();
+                SwapBuffers(hDeviceContext);
+                sceneChanged = FALSE;
+            }
+
+            if(!toggleFullScreenMode())
             {
-                if(keys[VK_ESCAPE])
-                {
-                    done = TRUE;
-                }
-                else
-                {
-                    drawGLScene();
-                    SwapBuffers(hDeviceContext);
-                }
-
-                if(!toggleFullScreenMode())
-                {
-                    return 0;
-                }
-                
-                updateRedColor();
-                updateGreenColor();
-                updateBlueColor();
-                updateAlpha();
+                return 0;
             }
         }
     }
 
+    swDestroyFrameScheduler(&scheduler);
     killGLWindow();
     return((int)msg.wParam);
 }
+
+#else // SOFTWARE_RENDERER
+
+// Headless entry point, renders into the software framebuffer without a window.
+int main(int argc, char *argv[])
+{
+    return swglRunHeadless(argc, argv, windowWidth, windowHeight, resizeGLScene, initOpenGL, drawGLScene);
+}
+
+#endif // SOFTWARE_RENDERER
@@ -1,13 +1,19 @@
+#ifdef SOFTWARE_RENDERER
+#include "../softwareRenderer/softwareRenderer.h"
+#else
 #include<windows.h>
 #include<gl\gl.h>
 #include<gl\glu.h>
+#endif
 
+#ifndef SOFTWARE_RENDERER
 HGLRC hRenderingContext = NULL; // Permanent rendering context.
 HDC hDeviceContext = NULL; // Private GDI device context.
 HWND hWindow = NULL; // Window handle.
 HINSTANCE hInstance = NULL; // Application instance.
 TCHAR className[] = TEXT("OpenGlWindow");
 TCHAR windowTitle[] = TEXT("OpenGL Empty Window");
+#endif
 
 bool keys[256]; // Used for keyboard routine.
 bool active = TRUE; // Windows active flag. TRUE by default.
@@ -23,8 +29,10 @@ GLfloat greenColor = 0.0f;
 GLfloat blueColor = 0.0f;
 GLfloat alpha = 0.0f;
 
+#ifndef SOFTWARE_RENDERER
 // Window event callback method.
 LRESULT CALLBACK WndProc(HWND hWindow, UINT iMessage, WPARAM wParam, LPARAM lParam);
+#endif
 
 // Resize and initialize GL window.
 GLvoid resizeGLScene(GLsizei width, GLsizei height)
@@ -65,6 +73,7 @@ int drawGLScene(GLvoid)
     return TRUE; // Everything is ok.
 }
 
+#ifndef SOFTWARE_RENDERER
 // Clean up.
 GLvoid killGLWindow(GLvoid)
 {
@@ -447,6 +456,8 @@ BOOL toggleFullScreenMode()
 
 LRESULT CALLBACK WndProc(HWND hWindow, UINT iMessage, WPARAM wParam, LPARAM lParam)
 {
+    PAINTSTRUCT paint;
+
     switch(iMessage)
     {
         case WM_ACTIVATE:
@@ -470,24 +481,28 @@ LRESULT CALLBACK WndProc(HWND hWindow, UINT iMessage, WPARAM wParam, LPARAM lPar
                 case 'R':
                 case 'r':
                     updateRedColor();
+                    InvalidateRect(hWindow, NULL, FALSE); // The new color has to be painted.
                     UpdateWindow(hWindow);
                     return 0;
 
                 case 'G':
                 case 'g':
                     updateGreenColor();
+                    InvalidateRect(hWindow, NULL, FALSE); // The new color has to be painted.
                     UpdateWindow(hWindow);
                     return 0;
 
                 case 'B':
                 case 'b':
                     updateBlueColor();
+                    InvalidateRect(hWindow, NULL, FALSE); // The new color has to be painted.
                     UpdateWindow(hWindow);
                     return 0;
 
                 case 'A':
                 case 'a':
                     updateAlpha();
+                    InvalidateRect(hWindow, NULL, FALSE); // The new color has to be painted.
                     UpdateWindow(hWindow);
                     return 0;
 
@@ -516,8 +531,12 @@ LRESULT CALLBACK WndProc(HWND hWindow, UINT iMessage, WPARAM wParam, LPARAM lPar
             return 0;
 
         case WM_PAINT:
+            // Validate the window once painted, otherwise WM_PAINT keeps coming and the unchanged scene is drawn
+            // over and over. Only resizing, uncovering or a color change invalidates it again.
+            BeginPaint(hWindow, &paint);
             drawGLScene();
             SwapBuffers(hDeviceContext);
+            EndPaint(hWindow, &paint);
             return 0;
 
         case WM_CLOSE:
@@ -558,3 +577,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     killGLWindow();
     return((int)msg.wParam);
 }
+
+#else // SOFTWARE_RENDERER
+
+// Headless entry point, renders into the software framebuffer without a window.
+int main(int argc, char *argv[])
+{
+    return swglRunHeadless(argc, argv, windowWidth, windowHeight, resizeGLScene, initOpenGL, drawGLScene);
+}
+
+#endif // SOFTWARE_RENDERER
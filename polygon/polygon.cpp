@@ -1,21 +1,30 @@
 // compile command
 //cl.exe main.cpp /EHsc user32.lib kernel32.lib gdi32.lib opengl32.lib glu32.lib
+// g++ -O3 -DSOFTWARE_RENDERER polygon.cpp ../softwareRenderer/*.cpp -pthread -o polygon (headless)
 //
 
+#ifdef SOFTWARE_RENDERER
+#include "../softwareRenderer/softwareRenderer.h"
+#else
 #include<windows.h>
 #include<gl\gl.h>
 #include<gl\glu.h>
+#include "../softwareRenderer/frameScheduler.h"
+#endif
 
+#ifndef SOFTWARE_RENDERER
 HGLRC hRenderingContext = NULL; // Permanent rendering context.
 HDC hDeviceContext = NULL; // Private GDI device context.
 HWND hWindow = NULL; // Window handle.
 HINSTANCE hInstance = NULL; // Application instance.
 TCHAR className[] = TEXT("OpenGlWindow");
 TCHAR windowTitle[] = TEXT("OpenGL First Polygon");
+#endif
 
 bool keys[256]; // Used for keyboard routine.
 bool active = TRUE; // Windows active flag. TRUE by default.
 bool fullscreen = TRUE; // Full screen flag. TRUE by default.
+bool sceneChanged = TRUE; // The scene is static, a frame is only drawn when the window needs it.
 
 int windowWidth = 640;
 int windowHeight = 480;
@@ -23,8 +32,10 @@ int windowWidthFullscreen = 1366;
 int windowHeightFullscreen = 768;
 int bitsPerColor = 32;
 
+#ifndef SOFTWARE_RENDERER
 // Window event callback method.
 LRESULT CALLBACK WndProc(HWND hWindow, UINT iMessage, WPARAM wParam, LPARAM lParam);
+#endif
 
 // Resize and initialize GL window.
 GLvoid resizeGLScene(GLsizei width, GLsizei height)
@@ -89,6 +100,7 @@ int drawGLScene(GLvoid)
     return TRUE; // Everything is ok.
 }
 
+#ifndef SOFTWARE_RENDERER
 // Clean-up.
 GLvoid killGLWindow(GLvoid)
 {
@@ -426,8 +438,14 @@ LRESULT CALLBACK WndProc(HWND hWindow, UINT iMessage, WPARAM wParam, LPARAM lPar
 
         case WM_SIZE:
             resizeGLScene(LOWORD(lParam), HIWORD(lParam));
+            sceneChanged = TRUE;
             return 0;
 
+        case WM_PAINT:
+            // Parts of the window were uncovered, draw the frame again; the default processing validates them.
+            sceneChanged = TRUE;
+            break;
+
         case WM_CLOSE:
             PostQuitMessage(0);
             return 0;
@@ -456,6 +474,18 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         return 0;
     }
 
+    // Frames are paced to the refresh rate of the display, unless the command line has -fps <rate|uncapped|vsync>.
+    SWFrameScheduler scheduler;
+    int pacing = SW_FRAME_PACING_VSYNC;
+    double frameRate = GetDeviceCaps(hDeviceContext, VREFRESH) > 1 ? GetDeviceCaps(hDeviceContext, VREFRESH) : 60.0;
+
+    if(!swParseFramePacingOption(lpCmdLine, &pacing, &frameRate) || !swInitFrameScheduler(&scheduler, pacing, frameRate))
+    {
+        killGLWindow();
+        MessageBox(NULL, TEXT("Invalid -fps option, expected a frame rate, uncapped or vsync."), TEXT("Error!"), MB_OK | MB_ICONEXCLAMATION);
+        return 0;
+    }
+
     while(!done)
     {
         if(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
@@ -470,31 +500,44 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
                 DispatchMessage(&msg);
             }
         }
-        else
+        else if(!active)
         {
-            if(active)
+            WaitMessage(); // Nothing is drawn while inactive, sleep until a message arrives.
+        }
+        else if(keys[VK_ESCAPE])
+        {
+            done = TRUE;
+        }
+        else if(keys[VK_F11])
+        {
+            if(!toggleFullscreenMode())
             {
-                if(keys[VK_ESCAPE])
-                {
-                    done = TRUE;
-                }
-                else
-                {
-                    drawGLScene();
-                    SwapBuffers(hDeviceContext);
-                }
-
-                if(keys[VK_F11])
-                {
-                    if(!toggleFullscreenMode())
-                    {
-                        return 0;
-                    }
-                }
+                return 0;
             }
         }
+        else if(!sceneChanged)
+        {
+            WaitMessage(); // The presented frame is still current, sleep until a message arrives.
+        }
+        else if(swWaitForFrame(&scheduler)) // Returns early for messages arriving while waiting.
+        {
+            drawGLScene();
+            SwapBuffers(hDeviceContext);
+            sceneChanged = FALSE;
+        }
     }
 
+    swDestroyFrameScheduler(&scheduler);
     killGLWindow();
     return ((int)msg.wParam);
 }
+
+#else // SOFTWARE_RENDERER
+
+// Headless entry point, renders into the software framebuffer without a window.
+int main(int argc, char *argv[])
+{
+    return swglRunHeadless(argc, argv, windowWidth, windowHeight, resizeGLScene, initOpenGL, drawGLScene);
+}
+
+#endif // SOFTWARE_RENDERER
@@ -1,17 +1,25 @@
 // compile command
 // cl.exe polygon_color.cpp /EHsc user32.lib kernel32.lib gdi32.lib opengl32.lib glu32.lib
+// g++ -O3 -DSOFTWARE_RENDERER polygonColor.cpp ../softwareRenderer/*.cpp -pthread -o polygonColor (headless)
 //
 
+#ifdef SOFTWARE_RENDERER
+#include "../softwareRenderer/softwareRenderer.h"
+#else
 #include<windows.h>
 #include<gl/gl.h>
 #include<gl/glu.h>
+#include "../softwareRenderer/frameScheduler.h"
+#endif
 
+#ifndef SOFTWARE_RENDERER
 HGLRC hRenderingContext = NULL; // Permanent rendering context.
 HDC hDeviceContext = NULL; // Private GDI device context.
 HWND hWindow = NULL; // Window handle.
 HINSTANCE hInstance = NULL; // Application instance.
 TCHAR className[] = TEXT("OpenGlWindow");
 TCHAR windowTitle[] = TEXT("Polygon Color");
+#endif
 
 bool keys[256]; // Used for keyboard routine.
 bool active = TRUE; // Windows active flag. TRUE by default.
@@ -23,8 +31,10 @@ int windowWidthFullscreen = 1366;
 int windowHeightFullscreen = 768;
 int bitsPerColor = 32;
 
+#ifndef SOFTWARE_RENDERER
 // Window event callback method.
 LRESULT CALLBACK WndProc(HWND hWindow, UINT iMessage, WPARAM wParam, LPARAM lParam);
+#endif
 
 // Resize and initialize GL window.
 GLvoid resizeGLScene(GLsizei width, GLsizei height)
@@ -93,6 +103,7 @@ int drawGLScene()
     return TRUE; // Everything is ok.
 }
 
+#ifndef SOFTWARE_RENDERER
 // Clean-up
 GLvoid killGLWindow(GLvoid)
 {
@@ -461,6 +472,18 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         return 0;
     }
 
+    // Frames are paced to the refresh rate of the display, unless the command line has -fps <rate|uncapped|vsync>.
+    SWFrameScheduler scheduler;
+    int pacing = SW_FRAME_PACING_VSYNC;
+    double frameRate = GetDeviceCaps(hDeviceContext, VREFRESH) > 1 ? GetDeviceCaps(hDeviceContext, VREFRESH) : 60.0;
+
+    if(!swParseFramePacingOption(lpCmdLine, &pacing, &frameRate) || !swInitFrameScheduler(&scheduler, pacing, frameRate))
+    {
+        killGLWindow();
+        MessageBox(NULL, TEXT("Invalid -fps option, expected a frame rate, uncapped or vsync."), TEXT("Error!"), MB_OK | MB_ICONEXCLAMATION);
+        return 0;
+    }
+
     while(!done)
     {
         if(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
@@ -475,31 +498,43 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
                 DispatchMessage(&msg);
             }
         }
-        else
+        else if(!active)
         {
-            if(active)
+            WaitMessage(); // Nothing is drawn while inactive, sleep until a message arrives.
+        }
+        else if(swWaitForFrame(&scheduler)) // Returns early for messages arriving while waiting.
+        {
+            if(keys[VK_ESCAPE])
             {
-                if(keys[VK_ESCAPE])
-                {
-                    done = TRUE;
-                }
-                else
-                {
-                    drawGLScene();
-                    SwapBuffers(hDeviceContext);
-                }
+                done = TRUE;
+            }
+            else
+            {
+                drawGLScene();
+                SwapBuffers(hDeviceContext);
+            }
 
-                if(keys[VK_F11])
+            if(keys[VK_F11])
+            {
+                if(!toggleFullscreenMode())
                 {
-                    if(!toggleFullscreenMode())
-                    {
-                        return 0;
-                    }
+                    return 0;
                 }
             }
         }
     }
 
+    swDestroyFrameScheduler(&scheduler);
     killGLWindow();
     return ((int)msg.wParam);
 }
+
+#else // SOFTWARE_RENDERER
+
+// Headless entry point, renders into the software framebuffer without a window.
+int main(int argc, char *argv[])
+{
+    return swglRunHeadless(argc, argv, windowWidth, windowHeight, resizeGLScene, initOpenGL, drawGLScene);
+}
+
+#endif // SOFTWARE_RENDERER
@@ -1,17 +1,34 @@
 // compile command
 // cl.exe polygon_rotation.cpp /EHsc user32.lib kernel32.lib gdi32.lib opengl32.lib glu32.lib
+// g++ -O3 -DSOFTWARE_RENDERER polygonRotation.cpp ../softwareRenderer/*.cpp -pthread -o polygonRotation (headless)
 //
 
+#ifdef SOFTWARE_RENDERER
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../softwareRenderer/softwareRenderer.h"
+#else
 #include<windows.h>
 #include<gl/gl.h>
 #include<gl/glu.h>
-
+#include <stdio.h>
+#endif
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include "../softwareRenderer/frameScheduler.h"
+#include "../softwareRenderer/tripleBuffer.h"
+
+#ifndef SOFTWARE_RENDERER
 HGLRC hRenderingContext = NULL; // Permanent rendering context.
 HDC hDeviceContext = NULL; // Private GDI device context.
 HWND hWindow = NULL; // Window handle.
 HINSTANCE hInstance = NULL; // Application instance.
 TCHAR className[] = TEXT("OpenGlWindow");
 TCHAR windowTitle[] = TEXT("Polygon Rotation");
+#endif
 
 bool keys[256]; // Used for keyboard routine.
 bool active = TRUE; // Windows active flag. TRUE by default.
@@ -20,16 +37,82 @@ bool fullscreen = TRUE; // Full screen flag. TRUE by default.
 GLfloat rtri; // Rotation angle for triangle.
 GLfloat rquad; // Rotation angle for quad.
 
+// The animation runs in steps of SIMULATION_STEP seconds, whatever the frame rate. rtri and rquad are interpolated
+// between the last two steps when drawing.
+#define SIMULATION_STEP (1.0 / 60.0)
+#define SIMULATION_MAX_STEPS 5 // Below 12 frames per second the animation slows down.
+#define TRIANGLE_SPEED 12.0f // Degrees per second.
+#define QUAD_SPEED 9.0f
+#define SCENE_FRAME_RATE 60.0f // Scene frames per second.
+
+// Animation state of the previous and of the last step.
+struct SceneState
+{
+    GLfloat triangleAngles[2];
+    GLfloat quadAngles[2];
+    GLfloat sceneFrames[2];
+    float rotationDirection; // Rotation direction. 1: Clockwise, -1: anticlockwise.
+    double stepTime; // swFrameClock() of the last step, the render thread interpolates by the time since.
+    double inputTime; // swFrameClock() when the latest input reflected in the state arrived, 0 before any.
+};
+
+// Stepped by drawGLScene() on frameTimer, unless the simulation thread runs.
+SceneState sceneState = {{0.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f}, 1.0f, 0.0, 0.0};
+SWFrameTimer frameTimer;
+
+// Simulation thread, see startSimulation(). It steps its own copy of sceneState in real time and publishes every
+// update through sceneSnapshots; the render thread draws the latest one. Presses of T reach it through the atomics.
+std::thread simulationThread;
+std::atomic<bool> simulationRunning(false);
+SWTripleBuffer<SceneState> sceneSnapshots;
+std::atomic<int> pendingToggles(0); // Presses of T not seen by the simulation yet.
+std::atomic<double> pendingInputTime(0.0); // swFrameClock() at the first of them.
+double drawnInputTime = 0.0; // inputTime of the state drawn in the current frame.
+double presentedInputTime = 0.0; // inputTime of the latest state presented.
+
+// Each field is written by one thread only, and read once the simulation thread stopped.
+struct ThreadTimings
+{
+    double start;
+    double stop;
+    long long updates; // Wake-ups of the simulation thread.
+    long long steps;
+    double updateSeconds;
+    double updateMax;
+    long long frames;
+    long long freshFrames; // Frames drawing a snapshot published since the previous frame.
+    double frameSeconds; // Drawing until presented.
+    double frameMax;
+    long long latencies; // Inputs presented, and the time from their arrival until then.
+    double latencySeconds;
+    double latencyMax;
+};
+
+ThreadTimings timings;
+
 int windowWidth = 640;
 int windowHeight = 480;
 int windowWidthFullscreen = 1366;
 int windowHeightFullscreen = 768;
 int bitsPerColor = 32;
 
-float rotationDirection = 1.0f; // Rotation direction. 1: Clockwise, -1: anticlockwise.
-
+#ifdef SOFTWARE_RENDERER
+int instanceCount = 0; // Rotating triangles and quads drawn with swglDrawInstanced(), 0 draws the single triangle and quad.
+GLfloat *triangleMatrices = NULL; // Model matrix per triangle instance.
+GLfloat *squareMatrices = NULL; // Model matrix per quad instance.
+GLfloat *squareColors = NULL; // Color per quad instance.
+HSWGLSCENE scene = NULL; // Scene drawn instead of the triangle and quad, see swglLoadScene().
+GLfloat sceneFrame = 0.0f; // Frame the scene is animated to.
+double nextInput = 0.0; // swFrameClock() at which the headless run presses T next, with the simulation thread.
+HSWGLMESH mesh = NULL; // Mesh drawn instead of the triangle and quad, see swglLoadMesh().
+GLfloat meshCenter[3]; // Bounding sphere of the mesh vertices.
+GLfloat meshRadius;
+#endif
+
+#ifndef SOFTWARE_RENDERER
 // Window event callback method.
 LRESULT CALLBACK WndProc(HWND hWindow, UINT iMessage, WPARAM wParam, LPARAM lParam);
+#endif
 
 // Resize and initialize GL window.
 GLvoid resizeGLScene(GLsizei width, GLsizei height)
@@ -75,13 +158,6 @@ GLvoid drawTriangle(GLvoid)
     glColor3f(0.0f, 0.0f, 1.0f); // Blue color.
     glVertex3f(1.0f, -1.0f, 0.0f); // Bottom right point.
     glEnd();
-
-    if(rtri >= 360.0f)
-    {
-        rtri = 0.0f;
-    }
-
-    rtri += (0.2f * rotationDirection); // Increase the rotation variable;
 }
 
 GLvoid drawSquare(GLvoid)
@@ -96,24 +172,342 @@ GLvoid drawSquare(GLvoid)
     glVertex3f(1.0f, -1.0f, 0.0f); // Bottom right point.
     glVertex3f(-1.0f, -1.0f, 0.0f); // Bottom left point.
     glEnd();
+}
+
+#ifdef SOFTWARE_RENDERER
+// Column-major model matrix moving by (x, y, z), rotating by angle degrees around the X or Y axis and scaling by scale.
+GLvoid setModelMatrix(GLfloat *matrix, GLfloat x, GLfloat y, GLfloat z, GLfloat angle, bool aroundX, GLfloat scale)
+{
+    GLfloat c = cosf(angle * 3.14159265f / 180.0f) * scale;
+    GLfloat s = sinf(angle * 3.14159265f / 180.0f) * scale;
+
+    memset(matrix, 0, 16 * sizeof(GLfloat));
+    matrix[0] = aroundX ? scale : c;
+    matrix[2] = aroundX ? 0.0f : -s;
+    matrix[5] = aroundX ? c : scale;
+    matrix[6] = aroundX ? s : 0.0f;
+    matrix[8] = aroundX ? 0.0f : s;
+    matrix[9] = aroundX ? -s : 0.0f;
+    matrix[10] = c;
+    matrix[12] = x;
+    matrix[13] = y;
+    matrix[14] = z;
+    matrix[15] = 1.0f;
+}
+
+// Draws instanceCount triangles and quads on a grid, each rotating like the single ones with its own phase.
+GLvoid drawInstances(GLvoid)
+{
+    static const GLfloat trianglePositions[] = {0.0f, 1.0f, 0.0f, -1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f};
+    static const GLfloat triangleColors[] = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+    static const GLfloat squarePositions[] = {-1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, -1.0f, 0.0f, -1.0f, -1.0f, 0.0f};
+
+    // Objects are 2 units wide and 3 units apart, scaled down until the grid fits the 45 degree field of view at the
+    // depth of the single triangle and quad.
+    int columns = (int)ceilf(sqrtf((GLfloat)instanceCount));
+    int rows = (instanceCount + columns - 1) / columns;
+    GLfloat scale = 6.0f * tanf(22.5f * 3.14159265f / 180.0f) / (columns * 1.5f);
+    scale = scale < 1.0f ? scale : 1.0f;
+    int triangles = 0;
+    int squares = 0;
+
+    for(int i = 0; i < instanceCount; ++i)
+    {
+        GLfloat x = (i % columns - (columns - 1) * 0.5f) * 3.0f * scale;
+        GLfloat y = (i / columns - (rows - 1) * 0.5f) * 3.0f * scale;
+
+        // Alternate triangles and quads like a checkerboard.
+        if((i % columns + i / columns) % 2 == 0)
+        {
+            setModelMatrix(&triangleMatrices[triangles * 16], x, y, -6.0f, rtri + i * 7.0f, false, scale);
+            triangles++;
+        }
+        else
+        {
+            setModelMatrix(&squareMatrices[squares * 16], x, y, -6.0f, rquad + i * 7.0f, true, scale);
+            squareColors[squares * 3] = 0.5f;
+            squareColors[squares * 3 + 1] = (GLfloat)(i % 5) / 4.0f;
+            squareColors[squares * 3 + 2] = 1.0f;
+            squares++;
+        }
+    }
+
+    glLoadIdentity(); // Instances carry their own model matrix.
+    swglDrawInstanced(GL_TRIANGLES, 3, trianglePositions, triangleColors, triangles, triangleMatrices, NULL);
+    swglDrawInstanced(GL_QUADS, 4, squarePositions, NULL, squares, squareMatrices, squareColors);
+}
+
+// Sets meshCenter and meshRadius to a sphere around every vertex of mesh, centered on their bounding box.
+GLvoid measureMesh(GLvoid)
+{
+    GLsizei vertexCount;
+    const GLfloat *vertices;
+    GLfloat low[3] = {0.0f, 0.0f, 0.0f};
+    GLfloat high[3] = {0.0f, 0.0f, 0.0f};
+
+    swglGetMeshData(mesh, &vertexCount, &vertices, NULL, NULL);
+
+    for(GLsizei i = 0; i < vertexCount; ++i)
+    {
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            GLfloat value = vertices[i * 6 + axis];
+            low[axis] = i == 0 || value < low[axis] ? value : low[axis];
+            high[axis] = i == 0 || value > high[axis] ? value : high[axis];
+        }
+    }
+
+    meshRadius = 0.0f;
+
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        meshCenter[axis] = (low[axis] + high[axis]) * 0.5f;
+    }
+
+    for(GLsizei i = 0; i < vertexCount; ++i)
+    {
+        GLfloat x = vertices[i * 6] - meshCenter[0];
+        GLfloat y = vertices[i * 6 + 1] - meshCenter[1];
+        GLfloat z = vertices[i * 6 + 2] - meshCenter[2];
+        GLfloat radius = sqrtf(x * x + y * y + z * z);
+        meshRadius = radius > meshRadius ? radius : meshRadius;
+    }
+}
+
+// Draws the mesh turning around its center, moved back until its bounding sphere fits the 45 degree field of view.
+GLvoid drawMesh(GLvoid)
+{
+    glLoadIdentity();
+    glTranslatef(0.0f, 0.0f, -1.2f * meshRadius / sinf(22.5f * 3.14159265f / 180.0f) - 0.1f);
+    glRotatef(rtri, 0.0f, 1.0f, 0.0f);
+    glTranslatef(-meshCenter[0], -meshCenter[1], -meshCenter[2]);
+    glColor3f(1.0f, 1.0f, 1.0f); // Used when the file has no vertex colors.
+    swglDrawMesh(mesh);
+}
+#endif
+
+// Keeps the angles of the last two steps within a turn, moving both so that the interpolation does not spin back.
+GLvoid wrapAngles(GLfloat *angles)
+{
+    GLfloat turn = angles[1] >= 360.0f ? -360.0f : (angles[1] <= -360.0f ? 360.0f : 0.0f);
+    angles[0] += turn;
+    angles[1] += turn;
+}
+
+// Advances the animation by one step of SIMULATION_STEP seconds.
+GLvoid updateScene(SceneState *state)
+{
+    state->triangleAngles[0] = state->triangleAngles[1];
+    state->quadAngles[0] = state->quadAngles[1];
+    state->sceneFrames[0] = state->sceneFrames[1];
+    state->triangleAngles[1] += (GLfloat)(TRIANGLE_SPEED * SIMULATION_STEP) * state->rotationDirection;
+    state->quadAngles[1] -= (GLfloat)(QUAD_SPEED * SIMULATION_STEP) * state->rotationDirection;
+    state->sceneFrames[1] += (GLfloat)(SCENE_FRAME_RATE * SIMULATION_STEP) * state->rotationDirection;
+    wrapAngles(state->triangleAngles);
+    wrapAngles(state->quadAngles);
+}
+
+// Reverses the rotation, on the next update of the simulation thread when it runs.
+GLvoid toggleRotation(GLvoid)
+{
+    if(!simulationRunning.load())
+    {
+        sceneState.rotationDirection *= -1.0f;
+        return;
+    }
+
+    double expected = 0.0;
+    pendingInputTime.compare_exchange_strong(expected, swFrameClock());
+    pendingToggles.fetch_add(1);
+}
+
+// Body of the simulation thread. Wakes up every SIMULATION_STEP seconds, applies the input that arrived, runs the
+// steps that are due and publishes the state.
+GLvoid simulationMain(GLvoid)
+{
+    SWFrameScheduler scheduler;
+    SWFrameTimer timer;
+    SceneState state = sceneState;
+
+    swInitFrameScheduler(&scheduler, SW_FRAME_PACING_FIXED, 1.0 / SIMULATION_STEP);
+    swInitFrameTimer(&timer, SIMULATION_STEP, SIMULATION_MAX_STEPS, 0.0);
+
+    while(simulationRunning.load())
+    {
+        if(!swWaitForFrame(&scheduler))
+        {
+            continue;
+        }
+
+        double start = swFrameClock();
+        int toggles = pendingToggles.exchange(0);
+
+        if(toggles)
+        {
+            double inputTime = pendingInputTime.exchange(0.0);
+            state.rotationDirection *= toggles % 2 ? -1.0f : 1.0f;
+            state.inputTime = inputTime > 0.0 ? inputTime : state.inputTime;
+        }
+
+        int steps = swAdvanceFrameTimer(&timer);
+
+        for(int step = 0; step < steps; ++step)
+        {
+            updateScene(&state);
+        }
+
+        state.stepTime = start - timer.accumulator;
+        *swTripleBufferWriteSlot(&sceneSnapshots) = state;
+        swPublishTripleBuffer(&sceneSnapshots);
+
+        double seconds = swFrameClock() - start;
+        timings.updates++;
+        timings.steps += steps;
+        timings.updateSeconds += seconds;
+        timings.updateMax = seconds > timings.updateMax ? seconds : timings.updateMax;
+    }
+
+    swDestroyFrameScheduler(&scheduler);
+}
+
+// Moves the simulation to its own thread, continuing from sceneState. Returns FALSE when the thread can not start.
+int startSimulation(GLvoid)
+{
+    swInitTripleBuffer(&sceneSnapshots, sceneState);
+    memset(&timings, 0, sizeof(timings));
+    timings.start = swFrameClock();
+    simulationRunning.store(true);
+
+    try
+    {
+        simulationThread = std::thread(simulationMain);
+    }
+    catch(const std::system_error &)
+    {
+        simulationRunning.store(false);
+        return FALSE;
+    }
+
+    return TRUE;
+}
 
-    if(rquad <= -360.0f)
+GLvoid stopSimulation(GLvoid)
+{
+    if(simulationRunning.exchange(false))
     {
-        rquad = 0.0f;
+        simulationThread.join();
+        timings.stop = swFrameClock();
     }
+}
 
-    rquad -= (0.15f * rotationDirection); // Decrease the rotation variable.
+// Called on the render thread once a frame started at frameStart is presented.
+GLvoid framePresented(double frameStart)
+{
+    double now = swFrameClock();
+    timings.frames++;
+    timings.frameSeconds += now - frameStart;
+    timings.frameMax = now - frameStart > timings.frameMax ? now - frameStart : timings.frameMax;
+
+    if(drawnInputTime > presentedInputTime)
+    {
+        timings.latencies++;
+        timings.latencySeconds += now - drawnInputTime;
+        timings.latencyMax = now - drawnInputTime > timings.latencyMax ? now - drawnInputTime : timings.latencyMax;
+        presentedInputTime = drawnInputTime;
+    }
+}
+
+// Writes the timings of the simulation and render threads and the latency from input to presenting into text.
+GLvoid formatTimings(char *text, size_t size)
+{
+    double seconds = timings.stop > timings.start ? timings.stop - timings.start : 1.0;
+    double updates = timings.updates ? (double)timings.updates : 1.0;
+    double frames = timings.frames ? (double)timings.frames : 1.0;
+    double latencies = timings.latencies ? (double)timings.latencies : 1.0;
+
+    snprintf(text, size,
+        "Simulation thread: %.1f steps/s in %.1f updates/s, %.3f ms per update, at most %.3f ms.\n"
+        "Render thread: %.1f frames/s, %.3f ms per frame, at most %.3f ms, %.1f%% of the frames with a new snapshot.\n"
+        "Input to present: %lld inputs, %.3f ms on average, at most %.3f ms.\n",
+        timings.steps / seconds, timings.updates / seconds, timings.updateSeconds * 1000.0 / updates, timings.updateMax * 1000.0,
+        timings.frames / seconds, timings.frameSeconds * 1000.0 / frames, timings.frameMax * 1000.0, timings.freshFrames * 100.0 / frames,
+        timings.latencies, timings.latencySeconds * 1000.0 / latencies, timings.latencyMax * 1000.0);
 }
 
 // This is where we do drawing.
 int drawGLScene()
 {
+    const SceneState *state = &sceneState;
+    GLfloat alpha;
+
+    if(simulationRunning.load())
+    {
+        bool fresh;
+        double now = swFrameClock();
+
+#ifdef SOFTWARE_RENDERER
+        // Headless runs have no keyboard, they reverse the rotation twice a second to measure the latency.
+        if(now >= nextInput)
+        {
+            toggleRotation();
+            nextInput = now + 0.5;
+        }
+#endif
+
+        // Draw the latest state published, as far between its last two steps as the time since the last one.
+        state = swAcquireTripleBuffer(&sceneSnapshots, &fresh);
+        alpha = (GLfloat)((now - state->stepTime) / SIMULATION_STEP);
+        alpha = alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+        timings.freshFrames += fresh ? 1 : 0;
+    }
+    else
+    {
+        // Run the steps due since the last frame and draw the state in between the last two.
+        for(int steps = swAdvanceFrameTimer(&frameTimer); steps > 0; --steps)
+        {
+            updateScene(&sceneState);
+        }
+
+        alpha = (GLfloat)frameTimer.alpha;
+    }
+
+    rtri = state->triangleAngles[0] + (state->triangleAngles[1] - state->triangleAngles[0]) * alpha;
+    rquad = state->quadAngles[0] + (state->quadAngles[1] - state->quadAngles[0]) * alpha;
+    drawnInputTime = state->inputTime;
+
+#ifdef SOFTWARE_RENDERER
+    sceneFrame = state->sceneFrames[0] + (state->sceneFrames[1] - state->sceneFrames[0]) * alpha;
+#endif
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear screen and depth buffer.
+
+#ifdef SOFTWARE_RENDERER
+    if(instanceCount > 0)
+    {
+        drawInstances();
+        return TRUE;
+    }
+
+    if(scene)
+    {
+        glLoadIdentity(); // Objects carry their own translation and rotation.
+        swglDrawScene(scene, sceneFrame);
+        return TRUE;
+    }
+
+    if(mesh)
+    {
+        drawMesh();
+        return TRUE;
+    }
+#endif
+
     drawTriangle();
     drawSquare();
     return TRUE; // Everything is ok.
 }
 
+#ifndef SOFTWARE_RENDERER
 // Clean-up
 GLvoid killGLWindow(GLvoid)
 {
@@ -482,6 +876,26 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         return 0;
     }
 
+    // Frames are paced to the refresh rate of the display, unless the command line has -fps <rate|uncapped|vsync>.
+    SWFrameScheduler scheduler;
+    int pacing = SW_FRAME_PACING_VSYNC;
+    double frameRate = GetDeviceCaps(hDeviceContext, VREFRESH) > 1 ? GetDeviceCaps(hDeviceContext, VREFRESH) : 60.0;
+
+    if(!swParseFramePacingOption(lpCmdLine, &pacing, &frameRate) || !swInitFrameScheduler(&scheduler, pacing, frameRate))
+    {
+        killGLWindow();
+        MessageBox(NULL, TEXT("Invalid -fps option, expected a frame rate, uncapped or vsync."), TEXT("Error!"), MB_OK | MB_ICONEXCLAMATION);
+        return 0;
+    }
+
+    if(!startSimulation())
+    {
+        swDestroyFrameScheduler(&scheduler);
+        killGLWindow();
+        MessageBox(NULL, TEXT("Failed to start the simulation thread."), TEXT("Error!"), MB_OK | MB_ICONEXCLAMATION);
+        return 0;
+    }
+
     while(!done)
     {
         if(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
@@ -496,37 +910,188 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
                 DispatchMessage(&msg);
             }
         }
-        else
+        else if(!active)
+        {
+            WaitMessage(); // Nothing is drawn while inactive, sleep until a message arrives.
+        }
+        else if(swWaitForFrame(&scheduler)) // Returns early for messages arriving while waiting.
         {
-            if(active)
+            if(keys[VK_ESCAPE])
             {
-                if(keys[VK_ESCAPE])
-                {
-                    done = TRUE;
-                }
-                else
-                {
-                    drawGLScene();
-                    SwapBuffers(hDeviceContext);
-                }
+                done = TRUE;
+            }
+            else
+            {
+                double frameStart = swFrameClock();
+                drawGLScene();
+                SwapBuffers(hDeviceContext);
+                framePresented(frameStart);
+            }
 
-                if(keys[VK_F11])
+            if(keys[VK_F11])
+            {
+                if(!toggleFullscreenMode())
                 {
-                    if(!toggleFullscreenMode())
-                    {
-                        return 0;
-                    }
+                    stopSimulation();
+                    return 0;
                 }
+            }
 
-                if(keys['T'])
-                {
-                    keys['T'] = FALSE;
-                    rotationDirection *= -1.0f;
-                }
+            if(keys['T'])
+            {
+                keys['T'] = FALSE;
+                toggleRotation();
             }
         }
     }
 
+    // The timings go to the debugger output, the window has no console.
+    char timingText[512];
+    stopSimulation();
+    formatTimings(timingText, sizeof(timingText));
+    OutputDebugStringA(timingText);
+
+    swDestroyFrameScheduler(&scheduler);
     killGLWindow();
     return ((int)msg.wParam);
 }
+
+#else // SOFTWARE_RENDERER
+
+// Frame callback of the headless run. With the simulation thread the frame is finished here to take the time it is
+// presented at, the swap that follows has nothing left to rasterize.
+int drawHeadlessFrame(GLvoid)
+{
+    double frameStart = swFrameClock();
+    int result = drawGLScene();
+
+    if(simulationRunning.load())
+    {
+        glFinish();
+        framePresented(frameStart);
+    }
+
+    return result;
+}
+
+// Headless entry point, renders into the software framebuffer without a window.
+// -instances <count> draws count rotating triangles and quads with instancing, -scene <file> draws a scene file
+// made by sceneConverter, and -mesh <file> an OBJ or PLY mesh, instead of the hard-coded triangle and quad.
+// -dt <seconds|real> advances the animation by seconds per frame, 1/60 by default so that the frames are the same on
+// every run, or by the time measured between frames with real. -simulation thread steps the animation in real time on
+// a thread of its own instead, and prints the timings of both threads. Other options go to swglRunHeadless().
+int main(int argc, char *argv[])
+{
+    const char *sceneFileName = NULL;
+    const char *meshFileName = NULL;
+    double frameDelta = SIMULATION_STEP;
+    bool simulationOnThread = false;
+
+    for(int i = 1; i + 1 < argc;)
+    {
+        if(!strcmp(argv[i], "-instances"))
+        {
+            instanceCount = atoi(argv[i + 1]);
+        }
+        else if(!strcmp(argv[i], "-scene"))
+        {
+            sceneFileName = argv[i + 1];
+        }
+        else if(!strcmp(argv[i], "-mesh"))
+        {
+            meshFileName = argv[i + 1];
+        }
+        else if(!strcmp(argv[i], "-dt"))
+        {
+            char *end = NULL;
+            frameDelta = strcmp(argv[i + 1], "real") ? strtod(argv[i + 1], &end) : 0.0;
+
+            if(end && (end == argv[i + 1] || *end != '\0' || frameDelta <= 0.0))
+            {
+                fprintf(stderr, "Invalid time step '%s', expected seconds or real.\n", argv[i + 1]);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-simulation"))
+        {
+            if(strcmp(argv[i + 1], "inline") && strcmp(argv[i + 1], "thread"))
+            {
+                fprintf(stderr, "Invalid simulation '%s', expected inline or thread.\n", argv[i + 1]);
+                return 1;
+            }
+
+            simulationOnThread = !strcmp(argv[i + 1], "thread");
+        }
+        else
+        {
+            ++i;
+            continue;
+        }
+
+        // Remove the option, including moving the terminating NULL.
+        for(int j = i; j + 2 <= argc; ++j)
+        {
+            argv[j] = argv[j + 2];
+        }
+
+        argc -= 2;
+    }
+
+    if(sceneFileName && !(scene = swglLoadScene(sceneFileName)))
+    {
+        fprintf(stderr, "Failed to load scene '%s'.\n", sceneFileName);
+        return 1;
+    }
+
+    if(meshFileName)
+    {
+        if(!(mesh = swglLoadMesh(meshFileName)))
+        {
+            fprintf(stderr, "Failed to load mesh '%s'.\n", meshFileName);
+            swglDeleteScene(scene);
+            return 1;
+        }
+
+        measureMesh();
+    }
+
+    if(instanceCount > 0)
+    {
+        triangleMatrices = (GLfloat *)malloc((size_t)instanceCount * 16 * sizeof(GLfloat));
+        squareMatrices = (GLfloat *)malloc((size_t)instanceCount * 16 * sizeof(GLfloat));
+        squareColors = (GLfloat *)malloc((size_t)instanceCount * 3 * sizeof(GLfloat));
+
+        if(!triangleMatrices || !squareMatrices || !squareColors)
+        {
+            fprintf(stderr, "Failed to allocate %d instances.\n", instanceCount);
+            return 1;
+        }
+    }
+
+    swInitFrameTimer(&frameTimer, SIMULATION_STEP, SIMULATION_MAX_STEPS, frameDelta);
+
+    if(simulationOnThread && !startSimulation())
+    {
+        fprintf(stderr, "Failed to start the simulation thread.\n");
+        return 1;
+    }
+
+    int result = swglRunHeadless(argc, argv, windowWidth, windowHeight, resizeGLScene, initOpenGL, drawHeadlessFrame);
+
+    if(simulationOnThread)
+    {
+        char timingText[512];
+        stopSimulation();
+        formatTimings(timingText, sizeof(timingText));
+        fputs(timingText, stdout);
+    }
+
+    free(triangleMatrices);
+    free(squareMatrices);
+    free(squareColors);
+    swglDeleteScene(scene);
+    swglDeleteMesh(mesh);
+    return result;
+}
+
+#endif // SOFTWARE_RENDERER
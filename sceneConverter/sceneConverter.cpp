@@ -0,0 +1,268 @@
+// Converts a text scene description into the binary scene file drawn by swglDrawScene(), see sceneFormat.h.
+//
+// The text format mirrors the calls of drawTriangle() and drawSquare(), one command per line, # starts a comment:
+//
+//     object <triangles|quads>            starts an object, like glBegin()
+//     translate <x> <y> <z>               like glTranslatef(), before the rotation
+//     rotate <x> <y> <z> <angle> <rate>   like glRotatef() around x, y, z; angle grows by rate every frame
+//     color <r> <g> <b>                   like glColor3f(), for the following vertices
+//     vertex <x> <y> <z>                  like glVertex3f()
+//     end                                 ends the object, like glEnd()
+//
+// compile command
+// g++ -O3 sceneConverter.cpp -o sceneConverter
+// ./sceneConverter <input.txt> <output.scene>
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "../softwareRenderer/softwareRenderer.h"
+#include "../softwareRenderer/sceneFormat.h"
+
+// Bounding sphere of the vertices of object, centered on their bounding box.
+static void boundObject(SWSceneObject *object, const std::vector<SWSceneVertex> &vertices)
+{
+    const SWSceneVertex *first = &vertices[object->firstVertex];
+    float minimum[3] = {first->x, first->y, first->z};
+    float maximum[3] = {first->x, first->y, first->z};
+
+    for(uint32_t i = 1; i < object->vertexCount; ++i)
+    {
+        const SWSceneVertex *vertex = &first[i];
+        float position[3] = {vertex->x, vertex->y, vertex->z};
+
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            minimum[axis] = position[axis] < minimum[axis] ? position[axis] : minimum[axis];
+            maximum[axis] = position[axis] > maximum[axis] ? position[axis] : maximum[axis];
+        }
+    }
+
+    object->radius = 0.0f;
+
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        object->center[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+    }
+
+    for(uint32_t i = 0; i < object->vertexCount; ++i)
+    {
+        float x = first[i].x - object->center[0];
+        float y = first[i].y - object->center[1];
+        float z = first[i].z - object->center[2];
+        float distance = sqrtf(x * x + y * y + z * z);
+        object->radius = distance > object->radius ? distance : object->radius;
+    }
+}
+
+// Writes size bytes of data and zeros up to the next multiple of SW_SCENE_ALIGNMENT.
+static bool writeAligned(FILE *file, const void *data, size_t size)
+{
+    static const unsigned char zeros[SW_SCENE_ALIGNMENT] = {0};
+    size_t padding = (SW_SCENE_ALIGNMENT - size % SW_SCENE_ALIGNMENT) % SW_SCENE_ALIGNMENT;
+    return (size == 0 || fwrite(data, size, 1, file) == 1) && (padding == 0 || fwrite(zeros, padding, 1, file) == 1);
+}
+
+static size_t alignedSize(size_t size)
+{
+    return (size + SW_SCENE_ALIGNMENT - 1) / SW_SCENE_ALIGNMENT * SW_SCENE_ALIGNMENT;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc != 3)
+    {
+        fprintf(stderr, "Usage: %s <input.txt> <output.scene>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *input = fopen(argv[1], "r");
+
+    if(!input)
+    {
+        fprintf(stderr, "Failed to open '%s'.\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<SWSceneObject> objects;
+    std::vector<SWSceneVertex> vertices;
+    SWSceneObject object;
+    bool insideObject = false;
+    float color[3] = {1.0f, 1.0f, 1.0f};
+    char line[1024];
+    int lineNumber = 0;
+    const char *error = NULL;
+
+    while(!error && fgets(line, sizeof(line), input))
+    {
+        ++lineNumber;
+
+        char *comment = strchr(line, '#');
+
+        if(comment)
+        {
+            *comment = '\0';
+        }
+
+        char command[16];
+        char mode[16];
+        char extra;
+        float x, y, z, angle, rate;
+
+        if(sscanf(line, "%15s", command) != 1)
+        {
+            continue; // Empty line.
+        }
+
+        if(!strcmp(command, "object"))
+        {
+            if(insideObject)
+            {
+                error = "object inside an object";
+            }
+            else if(sscanf(line, "%*s %15s %c", mode, &extra) != 1 || (strcmp(mode, "triangles") && strcmp(mode, "quads")))
+            {
+                error = "expected object <triangles|quads>";
+            }
+            else
+            {
+                memset(&object, 0, sizeof(object));
+                object.mode = strcmp(mode, "quads") ? GL_TRIANGLES : GL_QUADS;
+                object.firstVertex = vertices.size();
+                insideObject = true;
+            }
+        }
+        else if(!strcmp(command, "end"))
+        {
+            if(!insideObject)
+            {
+                error = "end outside an object";
+            }
+            else if(vertices.size() - object.firstVertex > 0xFFFFFFFFu / 2)
+            {
+                error = "too many vertices in one object";
+            }
+            else
+            {
+                object.vertexCount = (uint32_t)(vertices.size() - object.firstVertex);
+
+                if(object.vertexCount > 0)
+                {
+                    boundObject(&object, vertices);
+                }
+
+                objects.push_back(object);
+                insideObject = false;
+            }
+        }
+        else if(!insideObject && strcmp(command, "color"))
+        {
+            error = "command outside an object";
+        }
+        else if(!strcmp(command, "translate"))
+        {
+            if(sscanf(line, "%*s %f %f %f %c", &x, &y, &z, &extra) != 3)
+            {
+                error = "expected translate <x> <y> <z>";
+            }
+            else
+            {
+                object.translation[0] = x;
+                object.translation[1] = y;
+                object.translation[2] = z;
+            }
+        }
+        else if(!strcmp(command, "rotate"))
+        {
+            if(sscanf(line, "%*s %f %f %f %f %f %c", &x, &y, &z, &angle, &rate, &extra) != 5)
+            {
+                error = "expected rotate <x> <y> <z> <angle> <rate>";
+            }
+            else
+            {
+                object.axis[0] = x;
+                object.axis[1] = y;
+                object.axis[2] = z;
+                object.angle = angle;
+                object.rate = rate;
+            }
+        }
+        else if(!strcmp(command, "color"))
+        {
+            if(sscanf(line, "%*s %f %f %f %c", &x, &y, &z, &extra) != 3)
+            {
+                error = "expected color <r> <g> <b>";
+            }
+            else
+            {
+                color[0] = x;
+                color[1] = y;
+                color[2] = z;
+            }
+        }
+        else if(!strcmp(command, "vertex"))
+        {
+            if(sscanf(line, "%*s %f %f %f %c", &x, &y, &z, &extra) != 3)
+            {
+                error = "expected vertex <x> <y> <z>";
+            }
+            else
+            {
+                SWSceneVertex vertex = {x, y, z, color[0], color[1], color[2]};
+                vertices.push_back(vertex);
+            }
+        }
+        else
+        {
+            error = "unknown command";
+        }
+    }
+
+    bool readFailed = ferror(input) != 0;
+    fclose(input);
+
+    if(!error && insideObject)
+    {
+        error = "missing end";
+    }
+
+    if(error || readFailed)
+    {
+        fprintf(stderr, "%s:%d: %s.\n", argv[1], lineNumber, readFailed ? "read error" : error);
+        return 1;
+    }
+
+    SWSceneHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SW_SCENE_MAGIC, sizeof(header.magic));
+    header.version = SW_SCENE_VERSION;
+    header.objectCount = (uint32_t)objects.size();
+    header.vertexCount = vertices.size();
+    header.objectOffset = alignedSize(sizeof(header));
+    header.vertexOffset = header.objectOffset + alignedSize(objects.size() * sizeof(SWSceneObject));
+
+    FILE *output = fopen(argv[2], "wb");
+
+    if(!output)
+    {
+        fprintf(stderr, "Failed to create '%s'.\n", argv[2]);
+        return 1;
+    }
+
+    bool written = writeAligned(output, &header, sizeof(header))
+        && writeAligned(output, objects.data(), objects.size() * sizeof(SWSceneObject))
+        && writeAligned(output, vertices.data(), vertices.size() * sizeof(SWSceneVertex));
+
+    if(fclose(output) != 0 || !written)
+    {
+        fprintf(stderr, "Failed to write '%s'.\n", argv[2]);
+        return 1;
+    }
+
+    printf("Wrote %zu objects and %zu vertices to '%s'.\n", objects.size(), vertices.size(), argv[2]);
+    return 0;
+}
@@ -0,0 +1,484 @@
+// Tile binning and parallel tile rendering of the software renderer.
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <new>
+
+#include "binner.h"
+#include "threadPool.h"
+
+SWBinner *swCreateBinner(const SWFramebuffer *framebuffer)
+{
+    SWBinner *binner = new(std::nothrow) SWBinner();
+
+    if(!binner)
+    {
+        return NULL;
+    }
+
+    binner->tilesX = framebuffer->tilesX;
+    binner->tilesY = framebuffer->tilesY;
+
+    try
+    {
+        binner->tiles.resize((size_t)binner->tilesX * binner->tilesY);
+    }
+    catch(const std::bad_alloc &)
+    {
+        delete binner;
+        return NULL;
+    }
+
+    return binner;
+}
+
+void swInitTiles(SWFramebuffer *framebuffer)
+{
+    for(int tileY = 0; tileY < framebuffer->tilesY; ++tileY)
+    {
+        for(int tileX = 0; tileX < framebuffer->tilesX; ++tileX)
+        {
+            SWTileState *tile = &framebuffer->tiles[(size_t)tileY * framebuffer->tilesX + tileX];
+            memset(tile, 0, sizeof(*tile));
+            tile->x0 = tileX * SW_TILE_SIZE;
+            tile->y0 = tileY * SW_TILE_SIZE;
+            tile->x1 = tile->x0 + SW_TILE_SIZE < framebuffer->stride ? tile->x0 + SW_TILE_SIZE : framebuffer->stride;
+            tile->y1 = tile->y0 + SW_TILE_SIZE < framebuffer->height ? tile->y0 + SW_TILE_SIZE : framebuffer->height;
+            tile->depth.min = 1.0f; // The depth buffer starts cleared to 1.0.
+            tile->depth.max = 1.0f;
+        }
+    }
+}
+
+void swDestroyBinner(SWBinner *binner)
+{
+    delete binner;
+}
+
+static bool swTrackDamage = true; // See swglSetDamageTracking().
+
+// Hash of a clear or a primitive for damage tracking, never 0; 0 when damage is not tracked.
+static unsigned long long hashCommand(const void *command, size_t size, unsigned long long seed)
+{
+    return swTrackDamage && !swValidateKernels ? swHashMemory(command, size, seed) | 1 : 0;
+}
+
+static void appendCommand(SWBinner *binner, SWTile *tile, int tileIndex, unsigned int command, unsigned long long hash)
+{
+    if(tile->bin.empty())
+    {
+        binner->activeTiles.push_back(tileIndex);
+    }
+
+    tile->bin.push_back(command);
+
+    // Order matters, rotate before mixing in the next command.
+    unsigned long long mixed = (tile->hash ^ hash) * 0x9E3779B185EBCA87ull;
+    tile->hash = tile->hash && hash ? ((mixed << 27) | (mixed >> 37)) | 1 : 0;
+}
+
+void swSubmitClear(SWGLContext *context, GLbitfield mask)
+{
+    swFlushVertices(context); // Keeps recorded primitives before the clear.
+
+    SWBinner *binner = context->binner;
+    SWClear clear;
+    clear.mask = mask;
+    clear.color = swPackColor(context->clearColor[0], context->clearColor[1], context->clearColor[2], context->clearColor[3]);
+    clear.depth = context->clearDepth;
+
+    unsigned int command = SW_BIN_CLEAR | (unsigned int)binner->clears.size();
+    unsigned long long hash = hashCommand(&clear, sizeof(clear), 0);
+    binner->clears.push_back(clear);
+
+    // Clearing both buffers hides everything recorded before, drop it.
+    bool clearsAll = (mask & (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT)) == (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    for(size_t tileIndex = 0; tileIndex < binner->tiles.size(); ++tileIndex)
+    {
+        SWTile *tile = &binner->tiles[tileIndex];
+
+        if(clearsAll)
+        {
+            tile->bin.clear();
+            tile->bin.push_back(command);
+            tile->hash = hash; // What the tile holds only depends on the bin from here on.
+        }
+        else
+        {
+            appendCommand(binner, tile, (int)tileIndex, command, hash);
+        }
+    }
+
+    if(clearsAll)
+    {
+        binner->activeTiles.resize(binner->tiles.size());
+
+        for(size_t tileIndex = 0; tileIndex < binner->tiles.size(); ++tileIndex)
+        {
+            binner->activeTiles[tileIndex] = (int)tileIndex;
+        }
+    }
+}
+
+static void binPrimitive(SWBinner *binner, const SWPrimitiveSetup *setup)
+{
+    unsigned int command = (unsigned int)binner->primitives.size();
+    binner->primitives.push_back(*setup);
+    unsigned long long hash = 0;
+
+    int firstTileX = setup->minX / SW_TILE_SIZE;
+    int lastTileX = setup->maxX / SW_TILE_SIZE;
+    int firstTileY = setup->minY / SW_TILE_SIZE;
+    int lastTileY = setup->maxY / SW_TILE_SIZE;
+
+    for(int tileY = firstTileY; tileY <= lastTileY; ++tileY)
+    {
+        for(int tileX = firstTileX; tileX <= lastTileX; ++tileX)
+        {
+            int tileIndex = tileY * binner->tilesX + tileX;
+            SWTile *tile = &binner->tiles[tileIndex];
+
+            // Only hashed for tiles whose damage is tracked. The fields up to depthTest have no padding, the depth
+            // function only matters with the depth test.
+            if(tile->hash && !hash)
+            {
+                hash = hashCommand(setup, offsetof(SWPrimitiveSetup, depthTest), setup->depthTest ? setup->depthFunc + 1ull : 0);
+            }
+
+            appendCommand(binner, tile, tileIndex, command, hash);
+        }
+    }
+}
+
+void swBinPrimitives(SWBinner *binner, const SWPrimitiveSetup *setups, size_t count)
+{
+    binner->primitives.reserve(binner->primitives.size() + count);
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        binPrimitive(binner, &setups[i]);
+    }
+}
+
+void swSubmitTriangle(SWGLContext *context, const SWScreenVertex *v0, const SWScreenVertex *v1, const SWScreenVertex *v2)
+{
+    SWPrimitiveSetup setup;
+
+    if(swSetupTriangle(context, v0, v1, v2, &setup))
+    {
+        binPrimitive(context->binner, &setup);
+        context->stats.trianglesRasterized++;
+    }
+}
+
+void swSubmitQuad(SWGLContext *context, const SWScreenVertex *v0, const SWScreenVertex *v1, const SWScreenVertex *v2, const SWScreenVertex *v3)
+{
+    SWPrimitiveSetup setup;
+
+    if(swSetupQuad(context, v0, v1, v2, v3, &setup))
+    {
+        binPrimitive(context->binner, &setup);
+        context->stats.quadsRasterized++;
+        return;
+    }
+
+    swSubmitTriangle(context, v0, v1, v2);
+    swSubmitTriangle(context, v0, v2, v3);
+}
+
+// Fast clear, only the tile metadata is written. The pixels are filled when first needed, see swResolveClear().
+static void clearTile(SWFramebuffer *framebuffer, SWTileState *tile, const SWClear *clear)
+{
+    if(clear->mask & GL_COLOR_BUFFER_BIT)
+    {
+        tile->colorClearMask = ~0ull;
+        tile->clearColor = clear->color;
+    }
+
+    if(clear->mask & GL_DEPTH_BUFFER_BIT)
+    {
+        tile->depthClearMask = ~0ull;
+        tile->clearDepth = clear->depth;
+
+        // glClearDepth() lets NaN through, no range is known for it.
+        SWDepthRange range;
+        range.min = clear->depth == clear->depth ? clear->depth : -INFINITY;
+        range.max = clear->depth == clear->depth ? clear->depth : INFINITY;
+        tile->depth = range;
+
+        for(int blockY = tile->y0 / SW_BLOCK_SIZE; blockY * SW_BLOCK_SIZE < tile->y1; ++blockY)
+        {
+            SWDepthRange *blockDepth = framebuffer->blockDepth + (size_t)blockY * framebuffer->blocksX;
+
+            for(int blockX = tile->x0 / SW_BLOCK_SIZE; blockX * SW_BLOCK_SIZE < tile->x1; ++blockX)
+            {
+                blockDepth[blockX] = range;
+            }
+        }
+    }
+}
+
+struct SWRenderJob
+{
+    SWFramebuffer *framebuffer;
+    SWBinner *binner;
+};
+
+// Replays the bin of one tile, runs on any rendering thread.
+static void renderTile(void *data, int index)
+{
+    SWRenderJob *job = (SWRenderJob *)data;
+    SWBinner *binner = job->binner;
+    int tileIndex = binner->activeTiles[index];
+    SWTile *tile = &binner->tiles[tileIndex];
+    SWTileState *state = &job->framebuffer->tiles[tileIndex];
+    SWGLFrameStats stats = tile->stats; // Local copy, tiles of other threads share cache lines.
+
+    for(size_t i = 0; i < tile->bin.size(); ++i)
+    {
+        unsigned int command = tile->bin[i];
+
+        if(command & SW_BIN_CLEAR)
+        {
+            clearTile(job->framebuffer, state, &binner->clears[command & ~SW_BIN_CLEAR]);
+        }
+        else
+        {
+            swRasterizePrimitiveTile(&binner->primitives[command], job->framebuffer, state, &stats);
+        }
+    }
+
+    if(binner->presenting && state->colorClearMask)
+    {
+        swResolveClear(job->framebuffer, state, state->colorClearMask, 0);
+    }
+
+    tile->stats = stats;
+}
+
+// Empties the bins of a tile that is not rendered.
+static void skipTile(SWTile *tile)
+{
+    tile->bin.clear();
+    tile->hash = 0;
+}
+
+// Damage tracking. A bin starting with a clear of both buffers fully determines what its tile holds once rendered,
+// its hash stands for that content. The framebuffer keeps the hashes of what its color and depth buffers hold:
+// a frame whose tiles all match the front buffer is neither rendered nor presented, and a tile matching the back
+// buffer is not rendered again.
+static bool unchangedFrame(const SWFramebuffer *framebuffer, const SWBinner *binner)
+{
+    for(size_t tileIndex = 0; tileIndex < binner->tiles.size(); ++tileIndex)
+    {
+        unsigned long long hash = binner->tiles[tileIndex].hash;
+        const SWTileState *state = &framebuffer->tiles[tileIndex];
+
+        if(!hash || hash != state->frontHash || hash != state->depthHash)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool unchangedTile(const SWTileState *state, const SWTile *tile)
+{
+    return tile->hash && tile->hash == state->backHash && tile->hash == state->depthHash && !state->colorClearMask;
+}
+
+// Sets the damage of the framebuffer to the tiles whose back buffer differs from the front buffer.
+static void computeDamage(SWFramebuffer *framebuffer)
+{
+    framebuffer->damageX0 = framebuffer->width;
+    framebuffer->damageY0 = framebuffer->height;
+    framebuffer->damageX1 = 0;
+    framebuffer->damageY1 = 0;
+
+    for(int tileIndex = 0; tileIndex < framebuffer->tilesX * framebuffer->tilesY; ++tileIndex)
+    {
+        const SWTileState *state = &framebuffer->tiles[tileIndex];
+
+        if(!state->backHash || state->backHash != state->frontHash)
+        {
+            framebuffer->damageX0 = state->x0 < framebuffer->damageX0 ? state->x0 : framebuffer->damageX0;
+            framebuffer->damageY0 = state->y0 < framebuffer->damageY0 ? state->y0 : framebuffer->damageY0;
+            framebuffer->damageX1 = state->x1 > framebuffer->damageX1 ? state->x1 : framebuffer->damageX1;
+            framebuffer->damageY1 = state->y1 > framebuffer->damageY1 ? state->y1 : framebuffer->damageY1;
+        }
+    }
+
+    framebuffer->damageX1 = framebuffer->damageX1 < framebuffer->width ? framebuffer->damageX1 : framebuffer->width;
+
+    if(framebuffer->damageX1 <= framebuffer->damageX0)
+    {
+        framebuffer->damageX0 = framebuffer->damageY0 = framebuffer->damageX1 = framebuffer->damageY1 = 0;
+    }
+}
+
+bool swRenderBins(SWFramebuffer *framebuffer, SWBinner *binner, bool present, SWGLFrameStats *stats)
+{
+    binner->presenting = present;
+    bool presented = true;
+
+    if(present && unchangedFrame(framebuffer, binner))
+    {
+        // Every tile is active, the clear of both buffers put them all in the list.
+        for(size_t i = 0; i < binner->activeTiles.size(); ++i)
+        {
+            skipTile(&binner->tiles[binner->activeTiles[i]]);
+        }
+
+        binner->activeTiles.clear();
+        framebuffer->damageX0 = framebuffer->damageY0 = framebuffer->damageX1 = framebuffer->damageY1 = 0;
+        stats->framesSkipped++;
+        presented = false;
+    }
+    else if(present)
+    {
+        // Tiles without commands still have to fill the color of a pending clear.
+        for(size_t tileIndex = 0; tileIndex < binner->tiles.size(); ++tileIndex)
+        {
+            if(binner->tiles[tileIndex].bin.empty() && framebuffer->tiles[tileIndex].colorClearMask)
+            {
+                binner->activeTiles.push_back((int)tileIndex);
+            }
+        }
+    }
+
+    // Keep the tiles whose buffers do not hold their bin yet.
+    size_t activeCount = 0;
+
+    for(size_t i = 0; i < binner->activeTiles.size(); ++i)
+    {
+        int tileIndex = binner->activeTiles[i];
+
+        if(!swValidateKernels && unchangedTile(&framebuffer->tiles[tileIndex], &binner->tiles[tileIndex]))
+        {
+            skipTile(&binner->tiles[tileIndex]);
+        }
+        else
+        {
+            binner->activeTiles[activeCount++] = tileIndex;
+        }
+    }
+
+    binner->activeTiles.resize(activeCount);
+
+    if(!binner->activeTiles.empty())
+    {
+        SWRenderJob job;
+        job.framebuffer = framebuffer;
+        job.binner = binner;
+        swParallelFor((int)binner->activeTiles.size(), renderTile, &job);
+    }
+
+    for(size_t i = 0; i < binner->activeTiles.size(); ++i)
+    {
+        SWTile *tile = &binner->tiles[binner->activeTiles[i]];
+        SWTileState *state = &framebuffer->tiles[binner->activeTiles[i]];
+        int x1 = state->x1 < framebuffer->width ? state->x1 : framebuffer->width;
+        stats->fragmentsTested += tile->stats.fragmentsTested;
+        stats->fragmentsWritten += tile->stats.fragmentsWritten;
+        stats->fragmentsHiZRejected += tile->stats.fragmentsHiZRejected;
+        stats->fragmentsHiZAccepted += tile->stats.fragmentsHiZAccepted;
+        stats->fragmentsFlatColor += tile->stats.fragmentsFlatColor;
+        stats->kernelMismatches += tile->stats.kernelMismatches;
+        stats->pixelsRendered += (unsigned long long)(x1 - state->x0) * (state->y1 - state->y0);
+        memset(&tile->stats, 0, sizeof(tile->stats));
+
+        // Resolving a pending clear does not change what the tile holds.
+        if(!tile->bin.empty())
+        {
+            state->backHash = tile->hash;
+            state->depthHash = tile->hash;
+        }
+
+        skipTile(tile);
+    }
+
+    if(present && presented)
+    {
+        computeDamage(framebuffer);
+    }
+
+    binner->activeTiles.clear();
+    binner->primitives.clear();
+    binner->clears.clear();
+    return presented;
+}
+
+void swPresentBackBuffer(SWFramebuffer *framebuffer)
+{
+    // The new back buffer content is undefined like after SwapBuffers, it is what was presented before.
+    unsigned int *presented = framebuffer->backBuffer;
+    framebuffer->backBuffer = framebuffer->frontBuffer;
+    framebuffer->frontBuffer = presented;
+
+    for(int tileIndex = 0; tileIndex < framebuffer->tilesX * framebuffer->tilesY; ++tileIndex)
+    {
+        SWTileState *state = &framebuffer->tiles[tileIndex];
+        unsigned long long hash = state->backHash;
+        state->backHash = state->frontHash;
+        state->frontHash = hash;
+    }
+}
+
+bool swFlush(SWGLContext *context, bool present)
+{
+    swFlushVertices(context);
+    swFinishFrames(context); // Earlier frames come first in the back buffer.
+    return swRenderBins(&context->framebuffer, context->binner, present, &context->stats);
+}
+
+int swglSetDamageTracking(int enable)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(context && context->insideBeginEnd)
+    {
+        return FALSE;
+    }
+
+    swTrackDamage = enable != FALSE;
+    return TRUE;
+}
+
+int swglGetDamageRect(int *x, int *y, int *width, int *height)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return FALSE;
+    }
+
+    swFinishFrames(context);
+    const SWFramebuffer *framebuffer = &context->framebuffer;
+
+    if(x)
+    {
+        *x = framebuffer->damageX0;
+    }
+
+    if(y)
+    {
+        *y = framebuffer->damageY0;
+    }
+
+    if(width)
+    {
+        *width = framebuffer->damageX1 - framebuffer->damageX0;
+    }
+
+    if(height)
+    {
+        *height = framebuffer->damageY1 - framebuffer->damageY0;
+    }
+
+    return TRUE;
+}
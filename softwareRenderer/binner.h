@@ -0,0 +1,49 @@
+// Screen tiles and the per-tile command bins of a frame.
+//
+// Clears and primitives submitted between two flushes are recorded into the bins of the tiles they touch,
+// in submission order. On flush every tile replays its bin on one thread. A tile owns its rectangle of the
+// color and depth buffers, so the pixel path needs no locking. The state of the tiles belongs to the framebuffer,
+// a binner only holds commands, so that one frame can be recorded while an earlier one is rendered.
+
+#ifndef SOFTWARE_RENDERER_BINNER_H
+#define SOFTWARE_RENDERER_BINNER_H
+
+#include <vector>
+
+#include "rasterizer.h"
+
+#define SW_BIN_CLEAR 0x80000000u // Bin entry refers to binner->clears instead of binner->primitives.
+
+struct SWClear
+{
+    GLbitfield mask;
+    unsigned int color;
+    float depth;
+};
+
+struct SWTile
+{
+    std::vector<unsigned int> bin; // Indices of the commands touching this tile.
+    unsigned long long hash; // Commands of the bin when it starts with a clear of both buffers, 0 otherwise.
+    SWGLFrameStats stats; // Fragment counters of the last flush.
+};
+
+struct SWBinner
+{
+    int tilesX;
+    int tilesY;
+    std::vector<SWTile> tiles;
+    std::vector<SWPrimitiveSetup> primitives;
+    std::vector<SWClear> clears;
+    std::vector<int> activeTiles; // Tiles with a non-empty bin.
+    bool presenting; // The flush is for presenting the frame, tiles resolve their pending clear color.
+    SWGLFrameStats stats; // Statistics of the frame, set when it is queued, see frameQueue.cpp.
+};
+
+SWBinner *swCreateBinner(const SWFramebuffer *framebuffer);
+void swDestroyBinner(SWBinner *binner);
+
+// Appends primitives already set up, like those recorded by the draw cache, to the bins of their tiles.
+void swBinPrimitives(SWBinner *binner, const SWPrimitiveSetup *setups, size_t count);
+
+#endif // SOFTWARE_RENDERER_BINNER_H
@@ -0,0 +1,533 @@
+// Context management and fixed-function state of the software renderer.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "binner.h"
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+SWGLContext *swCurrentContext = NULL; // Context used by the gl* entry points.
+
+void *swAlignedAlloc(size_t size)
+{
+#if defined(_MSC_VER)
+    return _aligned_malloc(size, 64);
+#else
+    void *memory = NULL;
+    return posix_memalign(&memory, 64, size) == 0 ? memory : NULL;
+#endif
+}
+
+void swAlignedFree(void *memory)
+{
+#if defined(_MSC_VER)
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+void swSetError(SWGLContext *context, GLenum error)
+{
+    if(context->error == GL_NO_ERROR)
+    {
+        context->error = error;
+    }
+}
+
+unsigned int swPackColor(float red, float green, float blue, float alpha)
+{
+    float channels[4] = {alpha, red, green, blue};
+    unsigned int pixel = 0;
+
+    for(int i = 0; i < 4; ++i)
+    {
+        float value = channels[i];
+
+        // Keep value in range of 0.0f to 1.0f, NaN ends up as 0.
+        if(!(value > 0.0f))
+        {
+            value = 0.0f;
+        }
+        else if(value > 1.0f)
+        {
+            value = 1.0f;
+        }
+
+        pixel = (pixel << 8) | (unsigned int)(value * 255.0f + 0.5f);
+    }
+
+    return pixel;
+}
+
+HSWGLRC swglCreateContext(int width, int height)
+{
+    if(width <= 0 || height <= 0)
+    {
+        return NULL;
+    }
+
+    // Aligned for the matrices, see SWGLContext.
+    SWGLContext *context = (SWGLContext *)swAlignedAlloc(sizeof(SWGLContext));
+
+    if(!context)
+    {
+        return NULL;
+    }
+
+    memset(context, 0, sizeof(SWGLContext));
+
+    // Rows are padded so that the kernels can always load and store whole blocks.
+    int stride = (width + SW_BLOCK_SIZE - 1) & ~(SW_BLOCK_SIZE - 1);
+    size_t pixelCount = (size_t)stride * (size_t)height;
+    context->framebuffer.width = width;
+    context->framebuffer.height = height;
+    context->framebuffer.stride = stride;
+    context->framebuffer.backBuffer = (unsigned int *)swAlignedAlloc(pixelCount * sizeof(unsigned int));
+    context->framebuffer.frontBuffer = (unsigned int *)swAlignedAlloc(pixelCount * sizeof(unsigned int));
+    context->framebuffer.depthBuffer = (float *)swAlignedAlloc(pixelCount * sizeof(float));
+
+    size_t blockCount = (size_t)(stride / SW_BLOCK_SIZE) * (size_t)((height + SW_BLOCK_SIZE - 1) / SW_BLOCK_SIZE);
+    context->framebuffer.blocksX = stride / SW_BLOCK_SIZE;
+    context->framebuffer.blockDepth = (SWDepthRange *)swAlignedAlloc(blockCount * sizeof(SWDepthRange));
+
+    context->framebuffer.tilesX = (stride + SW_TILE_SIZE - 1) / SW_TILE_SIZE;
+    context->framebuffer.tilesY = (height + SW_TILE_SIZE - 1) / SW_TILE_SIZE;
+    context->framebuffer.tiles = (SWTileState *)swAlignedAlloc((size_t)context->framebuffer.tilesX * context->framebuffer.tilesY * sizeof(SWTileState));
+
+    context->binner = swCreateBinner(&context->framebuffer);
+    context->frameQueue = swCreateFrameQueue();
+    context->commands = swCreateCommandBuffer();
+    context->drawCache = swCreateDrawCache();
+    context->lists = swCreateDisplayLists();
+
+    if(!context->framebuffer.backBuffer || !context->framebuffer.frontBuffer || !context->framebuffer.depthBuffer
+        || !context->framebuffer.blockDepth || !context->framebuffer.tiles || !context->binner || !context->frameQueue
+        || !context->commands || !context->drawCache || !context->lists)
+    {
+        swglDeleteContext(context);
+        return NULL;
+    }
+
+    // Initial values as defined by the OpenGL specification.
+    context->clearDepth = 1.0f;
+    context->depthTest = false;
+    context->depthFunc = GL_LESS;
+    context->cullFace = false;
+    context->cullFaceMode = GL_BACK;
+    context->frontFace = GL_CCW;
+    context->shadeModel = GL_SMOOTH;
+    context->perspectiveHint = GL_DONT_CARE;
+    context->viewportWidth = width;
+    context->viewportHeight = height;
+    swUpdateGuardBand(context);
+    context->error = GL_NO_ERROR;
+    context->matrixMode = GL_MODELVIEW;
+    swMatrixIdentity(context->modelview);
+    swMatrixIdentity(context->projection);
+    context->modelviewProjectionDirty = true;
+    context->currentColor[0] = 1.0f;
+    context->currentColor[1] = 1.0f;
+    context->currentColor[2] = 1.0f;
+
+    for(size_t i = 0; i < pixelCount; ++i)
+    {
+        context->framebuffer.backBuffer[i] = 0;
+        context->framebuffer.frontBuffer[i] = 0;
+        context->framebuffer.depthBuffer[i] = 1.0f;
+    }
+
+    for(size_t i = 0; i < blockCount; ++i)
+    {
+        context->framebuffer.blockDepth[i].min = 1.0f;
+        context->framebuffer.blockDepth[i].max = 1.0f;
+    }
+
+    swInitTiles(&context->framebuffer);
+    return context;
+}
+
+int swglMakeCurrent(HSWGLRC context)
+{
+    swCurrentContext = context;
+    return TRUE;
+}
+
+int swglDeleteContext(HSWGLRC context)
+{
+    if(!context)
+    {
+        return FALSE;
+    }
+
+    if(swCurrentContext == context)
+    {
+        swCurrentContext = NULL;
+    }
+
+    swDestroyFrameQueue(context); // Before anything its thread renders with.
+    swDestroyBinner(context->binner);
+    swDestroyCommandBuffer(context->commands);
+    swDestroyDrawCache(context->drawCache);
+    swAbortList(context);
+    swReleaseDisplayLists(context->lists);
+    swAlignedFree(context->framebuffer.backBuffer);
+    swAlignedFree(context->framebuffer.frontBuffer);
+    swAlignedFree(context->framebuffer.depthBuffer);
+    swAlignedFree(context->framebuffer.blockDepth);
+    swAlignedFree(context->framebuffer.tiles);
+    swAlignedFree(context);
+    return TRUE;
+}
+
+HSWGLRC swglGetCurrentContext(void)
+{
+    return swCurrentContext;
+}
+
+int swglSwapBuffers(void)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return FALSE;
+    }
+
+    swPresentFrame(context);
+    swEndDrawCacheFrame(context);
+    memset(&context->stats, 0, sizeof(context->stats));
+    return TRUE;
+}
+
+const unsigned int *swglGetFrontBuffer(int *width, int *height, int *stride)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return NULL;
+    }
+
+    swFinishFrames(context);
+
+    if(width)
+    {
+        *width = context->framebuffer.width;
+    }
+
+    if(height)
+    {
+        *height = context->framebuffer.height;
+    }
+
+    if(stride)
+    {
+        *stride = context->framebuffer.stride;
+    }
+
+    return context->framebuffer.frontBuffer;
+}
+
+int swglGetFrameStats(SWGLFrameStats *stats)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context || !stats)
+    {
+        return FALSE;
+    }
+
+    *stats = context->presentedStats;
+    return TRUE;
+}
+
+GLvoid glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    context->clearColor[0] = red;
+    context->clearColor[1] = green;
+    context->clearColor[2] = blue;
+    context->clearColor[3] = alpha;
+}
+
+GLvoid glClearDepth(GLclampd depth)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    // Keep depth in range of 0.0 to 1.0.
+    context->clearDepth = (float)(depth < 0.0 ? 0.0 : (depth > 1.0 ? 1.0 : depth));
+}
+
+GLvoid glClear(GLbitfield mask)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return;
+    }
+
+    if(mask & ~(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT))
+    {
+        swSetError(context, GL_INVALID_VALUE);
+        return;
+    }
+
+    swSubmitClear(context, mask);
+}
+
+GLvoid glEnable(GLenum cap)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    swFlushVertices(context);
+
+    switch(cap)
+    {
+        case GL_CULL_FACE:
+            context->cullFace = true;
+            break;
+
+        case GL_DEPTH_TEST:
+            context->depthTest = true;
+            break;
+
+        default:
+            swSetError(context, GL_INVALID_ENUM);
+            break;
+    }
+}
+
+GLvoid glDisable(GLenum cap)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    swFlushVertices(context);
+
+    switch(cap)
+    {
+        case GL_CULL_FACE:
+            context->cullFace = false;
+            break;
+
+        case GL_DEPTH_TEST:
+            context->depthTest = false;
+            break;
+
+        default:
+            swSetError(context, GL_INVALID_ENUM);
+            break;
+    }
+}
+
+GLboolean glIsEnabled(GLenum cap)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return GL_FALSE;
+    }
+
+    switch(cap)
+    {
+        case GL_CULL_FACE:
+            return context->cullFace ? GL_TRUE : GL_FALSE;
+
+        case GL_DEPTH_TEST:
+            return context->depthTest ? GL_TRUE : GL_FALSE;
+
+        default:
+            swSetError(context, GL_INVALID_ENUM);
+            return GL_FALSE;
+    }
+}
+
+GLvoid glDepthFunc(GLenum func)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    swFlushVertices(context);
+
+    if(func < GL_NEVER || func > GL_ALWAYS)
+    {
+        swSetError(context, GL_INVALID_ENUM);
+        return;
+    }
+
+    context->depthFunc = func;
+}
+
+GLvoid glCullFace(GLenum mode)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    swFlushVertices(context);
+
+    if(mode != GL_FRONT && mode != GL_BACK && mode != GL_FRONT_AND_BACK)
+    {
+        swSetError(context, GL_INVALID_ENUM);
+        return;
+    }
+
+    context->cullFaceMode = mode;
+}
+
+GLvoid glFrontFace(GLenum mode)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    swFlushVertices(context);
+
+    if(mode != GL_CW && mode != GL_CCW)
+    {
+        swSetError(context, GL_INVALID_ENUM);
+        return;
+    }
+
+    context->frontFace = mode;
+}
+
+GLvoid glShadeModel(GLenum mode)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    swFlushVertices(context);
+
+    if(mode != GL_FLAT && mode != GL_SMOOTH)
+    {
+        swSetError(context, GL_INVALID_ENUM);
+        return;
+    }
+
+    context->shadeModel = mode;
+}
+
+GLvoid glHint(GLenum target, GLenum mode)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    swFlushVertices(context);
+
+    if(target != GL_PERSPECTIVE_CORRECTION_HINT || mode < GL_DONT_CARE || mode > GL_NICEST)
+    {
+        swSetError(context, GL_INVALID_ENUM);
+        return;
+    }
+
+    context->perspectiveHint = mode;
+}
+
+GLvoid glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    swFlushVertices(context);
+
+    if(width < 0 || height < 0)
+    {
+        swSetError(context, GL_INVALID_VALUE);
+        return;
+    }
+
+    context->viewportX = x;
+    context->viewportY = y;
+    context->viewportWidth = width < SW_MAX_VIEWPORT_DIMENSION ? width : SW_MAX_VIEWPORT_DIMENSION;
+    context->viewportHeight = height < SW_MAX_VIEWPORT_DIMENSION ? height : SW_MAX_VIEWPORT_DIMENSION;
+    swUpdateGuardBand(context);
+}
+
+GLvoid glFlush(GLvoid)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(context)
+    {
+        swFlush(context, false);
+    }
+}
+
+GLvoid glFinish(GLvoid)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(context)
+    {
+        swFlush(context, false);
+    }
+}
+
+GLenum glGetError(GLvoid)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return GL_NO_ERROR;
+    }
+
+    GLenum error = context->error;
+    context->error = GL_NO_ERROR;
+    return error;
+}
@@ -0,0 +1,321 @@
+// Internal state of the software renderer, shared between its translation units.
+
+#ifndef SOFTWARE_RENDERER_CONTEXT_H
+#define SOFTWARE_RENDERER_CONTEXT_H
+
+#include <limits.h>
+#include <stddef.h>
+
+#include "softwareRenderer.h"
+
+#define SW_SUBPIXEL_BITS 4 // Window coordinates are snapped to 1/16th of a pixel.
+#define SW_SUBPIXEL_SCALE (1 << SW_SUBPIXEL_BITS)
+#define SW_MAX_VIEWPORT_DIMENSION 16384 // Like GL_MAX_VIEWPORT_DIMS, keeps window coordinates in fixed-point range.
+#define SW_MAX_WINDOW_COORDINATE 65536.0f // Keeps the edge functions of an 8x8 block in 32-bit range.
+#define SW_GUARD_BAND (SW_MAX_WINDOW_COORDINATE * 0.5f) // Window coordinates primitives are clipped to, with room for rounding.
+#define SW_MAX_CLIP_VERTICES 16 // 4 input vertices plus one per clip plane, with room to spare.
+#define SW_INVALID_COORDINATE INT_MIN // Snapped window coordinate of a vertex the rasterizer can not handle.
+#define SW_MODELVIEW_STACK_DEPTH 32 // Like GL_MAX_MODELVIEW_STACK_DEPTH, including the current matrix.
+#define SW_PROJECTION_STACK_DEPTH 4 // Like GL_MAX_PROJECTION_STACK_DEPTH, including the current matrix.
+
+// Object space vertex, as recorded by glVertex3f() for later transformation.
+struct SWRecordedVertex
+{
+    float x, y, z;
+    float r, g, b;
+};
+
+// Vertex in clip space, as produced by the model-view-projection transform.
+struct SWVertex
+{
+    float x, y, z, w; // Clip coordinates.
+    float r, g, b; // Color.
+};
+
+// Vertex in window space, ready for triangle setup.
+struct SWScreenVertex
+{
+    float x, y; // Window coordinates, origin at the bottom-left corner.
+    float z; // Depth in range 0.0 to 1.0.
+    float inverseW; // 1 / clip w, for perspective-correct interpolation.
+    float r, g, b; // Color.
+    int fixedX, fixedY; // x and y snapped to the sub-pixel grid, SW_INVALID_COORDINATE when out of range or not a number.
+};
+
+// Bits of a clip code, set for the planes a clip space vertex is outside of. Primitives are clipped against the
+// guard band (0x01 to 0x08) and the near and far planes (0x10, 0x20); the sides of the view frustum (0x40 to 0x200)
+// are only used to reject them. Anything between the sides and the guard band is scissored by the rasterizer.
+#define SW_CLIP_PLANES 0x3F // Clip code bits of the planes primitives are clipped against.
+
+// Vertex after the geometry stage.
+struct SWTransformedVertex
+{
+    SWVertex clip;
+    SWScreenVertex window; // Only meaningful when clipCode has none of the SW_CLIP_PLANES bits.
+    unsigned int clipCode;
+};
+
+// Conservative range of the values in a region of the depth buffer.
+// Regions whose values are not known to be finite hold -INFINITY to INFINITY.
+struct SWDepthRange
+{
+    float min;
+    float max;
+};
+
+struct SWFramebuffer
+{
+    int width;
+    int height;
+    int stride; // Pixels between two rows, width rounded up to a whole number of blocks.
+    unsigned int *backBuffer; // Color buffer being rendered, 0xAARRGGBB bottom-up.
+    unsigned int *frontBuffer; // Color buffer last presented by swglSwapBuffers().
+    float *depthBuffer; // Full-precision depth buffer.
+    int blocksX; // Blocks per row of blockDepth.
+    SWDepthRange *blockDepth; // Hierarchical-Z, depth range of every 8x8 block of the depth buffer.
+    int tilesX; // Tiles per row of tiles.
+    int tilesY;
+    struct SWTileState *tiles; // Rectangle, hierarchical-Z and pending clears of every tile, see rasterizer.h.
+    int damageX0, damageY0, damageX1, damageY1; // Pixels of the front buffer changed by the last present.
+};
+
+// Array set by glVertexPointer() or glColorPointer().
+struct SWClientArray
+{
+    bool enabled;
+    int size; // Floats per vertex.
+    int stride; // Bytes between vertices.
+    const unsigned char *pointer;
+};
+
+struct SWBinner;
+struct SWCommandBuffer;
+struct SWDisplayLists;
+struct SWDrawCache;
+struct SWFrameQueue;
+struct SWListBuilder;
+
+struct SWGLContext
+{
+    SWFramebuffer framebuffer;
+    SWBinner *binner; // Commands of the frame not rendered yet, see binner.h.
+    SWFrameQueue *frameQueue; // Frames presented but still being rendered, see frameQueue.cpp.
+    SWCommandBuffer *commands; // Immediate mode vertices not transformed yet, see primitive.cpp.
+    SWDrawCache *drawCache; // Primitive setups of the draws of the previous frame, see drawCache.cpp.
+
+    // Fixed-function state.
+    float clearColor[4];
+    float clearDepth;
+    bool depthTest;
+    GLenum depthFunc;
+    bool cullFace;
+    GLenum cullFaceMode;
+    GLenum frontFace;
+    GLenum shadeModel;
+    GLenum perspectiveHint;
+    int viewportX;
+    int viewportY;
+    int viewportWidth;
+    int viewportHeight;
+    float guardBandX; // Guard band in normalized device coordinates, |x| <= guardBandX keeps x within SW_GUARD_BAND.
+    float guardBandY;
+    GLenum error; // First error recorded since the last glGetError().
+
+    // Matrices, column-major like OpenGL. Columns are 16-byte aligned for the SSE code of matrix.cpp.
+    GLenum matrixMode;
+    alignas(16) float modelview[16];
+    alignas(16) float projection[16];
+    alignas(16) float modelviewProjection[16]; // Cached projection * model-view.
+    bool modelviewProjectionDirty; // Set whenever one of the two matrices changes.
+    alignas(16) float modelviewStack[SW_MODELVIEW_STACK_DEPTH - 1][16]; // Matrices saved by glPushMatrix().
+    alignas(16) float projectionStack[SW_PROJECTION_STACK_DEPTH - 1][16];
+    int modelviewStackDepth; // Saved matrices.
+    int projectionStackDepth;
+
+    // Immediate mode.
+    bool insideBeginEnd;
+    GLenum primitiveMode;
+    float currentColor[3];
+    SWRecordedVertex primitiveVertices[4]; // Vertices of the primitive being assembled, without vertex batching.
+    int primitiveVertexCount; // Vertices of the incomplete primitive since glBegin().
+
+    // Vertex arrays.
+    SWClientArray vertexArray;
+    SWClientArray colorArray;
+
+    // Display lists.
+    SWDisplayLists *lists; // Names and contents, shared with other contexts by swglShareLists().
+    SWListBuilder *listBuilder; // List being compiled between glNewList() and glEndList(), NULL otherwise.
+    int listNesting; // glCallList() calls being executed.
+
+    SWGLFrameStats stats; // Statistics of the frame being rendered.
+    SWGLFrameStats presentedStats; // Statistics of the last presented frame.
+};
+
+extern SWGLContext *swCurrentContext;
+
+// Allocation aligned for vector loads and stores.
+void *swAlignedAlloc(size_t size);
+void swAlignedFree(void *memory);
+
+// Read-only mapping of a whole file, see mappedFile.cpp. swMapFile() fails for empty files.
+struct SWMappedFile
+{
+    const unsigned char *data;
+    size_t size;
+    void *mapping; // File mapping handle on Windows.
+};
+
+bool swMapFile(const char *fileName, SWMappedFile *file);
+void swUnmapFile(SWMappedFile *file);
+
+// Records an error unless an earlier one is still pending, like OpenGL does.
+void swSetError(SWGLContext *context, GLenum error);
+
+// Packs a floating point color into a 0xAARRGGBB pixel.
+unsigned int swPackColor(float red, float green, float blue, float alpha);
+
+// Matrix helpers, see matrix.cpp. Matrices are 16-byte aligned.
+void swMatrixIdentity(float *matrix);
+void swMatrixMultiply(float *result, const float *a, const float *b);
+// Multiply matrix by a translation or a rotation of angle degrees around x, y and z, like glTranslatef() and glRotatef().
+void swMatrixTranslate(float *matrix, float x, float y, float z);
+void swMatrixRotate(float *matrix, float angle, float x, float y, float z);
+const float *swGetModelviewProjection(SWGLContext *context);
+
+// Recording of immediate mode vertices, see primitive.cpp.
+// swFlushVertices() runs the geometry stage over the recorded vertices. It has to be called before anything
+// that changes how they are drawn: the matrices, the render state, and commands entering the tile bins.
+SWCommandBuffer *swCreateCommandBuffer(void);
+void swDestroyCommandBuffer(SWCommandBuffer *commands);
+void swFlushVertices(SWGLContext *context);
+
+// Vertices read by indexed draws: vertex i has positionSize floats at positions + i * positionStride and 3 color
+// floats at colors + i * colorStride. Without colors every vertex takes the current color.
+struct SWVertexSource
+{
+    const unsigned char *positions;
+    size_t positionStride;
+    int positionSize; // 2 or 3, z is 0 for 2.
+    const unsigned char *colors;
+    size_t colorStride;
+};
+
+// Transforms and draws indexed primitives of one mode through the post-transform vertex cache, see primitive.cpp.
+// indexType is GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+void swDrawElements(SWGLContext *context, GLenum mode, const SWVertexSource *source, GLenum indexType, const void *indices,
+    int indexCount);
+
+// Transforms and draws indexed primitives of one mode, see primitive.cpp. The first currentColorVertices
+// vertices take the current color instead of their own. All vertices are transformed, without the vertex cache.
+void swDrawIndexed(SWGLContext *context, GLenum mode, const SWRecordedVertex *vertices, int vertexCount, int currentColorVertices,
+    const unsigned int *indices, int indexCount);
+
+// Transforms vertexCount vertices by matrix and draws them as primitives of mode, see primitive.cpp. Unlike
+// swDrawIndexed() the vertices are read in place, they are not copied.
+void swDrawVertices(SWGLContext *context, const float *matrix, GLenum mode, const SWRecordedVertex *vertices, int vertexCount);
+
+// Cross-frame cache of static draws, see drawCache.cpp.
+// The key of a draw holds everything its primitive setups depend on. It is hashed and compared bytewise, so it has
+// to be zeroed before it is filled in.
+struct SWDrawKey
+{
+    unsigned long long geometryHash; // Vertices and indices, see swHashMemory().
+    GLenum mode;
+    int vertexCount;
+    int indexCount;
+    int currentColorVertices;
+    float currentColor[3]; // Only set with currentColorVertices.
+    float matrix[16];
+    int viewport[4];
+    float guardBandX; // Guard band the primitives are clipped to, 1.0 when swglSetGuardBand() disabled it.
+    float guardBandY;
+    bool nativeQuads; // See swglSetNativeQuads().
+    bool cullFace;
+    GLenum cullFaceMode;
+    GLenum frontFace;
+    GLenum shadeModel;
+    GLenum perspectiveHint;
+    bool depthTest;
+    GLenum depthFunc;
+};
+
+extern bool swCacheDraws; // See swglSetDrawCache().
+
+SWDrawCache *swCreateDrawCache(void);
+void swDestroyDrawCache(SWDrawCache *cache);
+unsigned long long swHashMemory(const void *data, size_t size, unsigned long long seed);
+// Bins the primitive setups recorded for key in an earlier frame and returns true. Otherwise returns false, and the
+// draw has to run the geometry stage and call swRecordDraw() when done, which records it when it is worth it.
+bool swReplayDraw(SWGLContext *context, const SWDrawKey *key);
+void swRecordDraw(SWGLContext *context);
+// Drops the draws that were not drawn in the frame being presented.
+void swEndDrawCacheFrame(SWGLContext *context);
+
+// Display lists, see displayList.cpp.
+// While a list is compiled, the immediate mode and matrix functions hand their command to swCompileCommand(),
+// which records it and returns whether it has to be executed as well.
+#define SW_LIST_BEGIN 0
+#define SW_LIST_END 1
+#define SW_LIST_VERTEX 2
+#define SW_LIST_COLOR 3
+#define SW_LIST_MATRIX_MODE 4
+#define SW_LIST_LOAD_IDENTITY 5
+#define SW_LIST_TRANSLATE 6
+#define SW_LIST_ROTATE 7
+#define SW_LIST_PERSPECTIVE 8
+#define SW_LIST_CALL 9
+#define SW_LIST_DRAW 10 // Primitives of consecutive glBegin()/glEnd() pairs, only found in compiled lists.
+#define SW_LIST_PUSH_MATRIX 11
+#define SW_LIST_POP_MATRIX 12
+
+SWDisplayLists *swCreateDisplayLists(void);
+void swReleaseDisplayLists(SWDisplayLists *lists);
+bool swCompileCommand(SWGLContext *context, int command, double argument0, double argument1, double argument2, double argument3);
+void swAbortList(SWGLContext *context);
+
+// Geometry stage, see geometry.cpp. Transforms object space vertices by matrix, usually the model-view-projection
+// matrix, computes their clip codes against the given guard band and their window coordinates.
+void swTransformVertices(SWGLContext *context, const float *matrix, float guardBandX, float guardBandY, const SWRecordedVertex *source, int count, SWTransformedVertex *output);
+// Perspective divide and viewport transform of a single clip space vertex.
+void swToWindow(const SWGLContext *context, const SWVertex *vertex, SWScreenVertex *screen);
+
+// Frustum culling of instances, see culling.cpp. bounds holds the center and radius of the bounding sphere of the
+// first instance, those of the next ones follow every boundsStride floats; 0 shares one sphere. Writes the indices
+// of the instances whose sphere moved by their model matrix may intersect the view frustum of modelviewProjection
+// to visible, in order, and returns their number.
+int swCullInstances(SWGLContext *context, const float *modelviewProjection, const float *bounds, int boundsStride,
+    const float *matrices, int count, int *visible);
+
+// Clips a triangle against the guard band and the near and far planes and hands the pieces to the rasterizer, see primitive.cpp.
+void swDrawTriangle(SWGLContext *context, const SWTransformedVertex *v0, const SWTransformedVertex *v1, const SWTransformedVertex *v2);
+// Hands a quad inside the guard band to the rasterizer as a whole, splits and clips any other.
+void swDrawQuad(SWGLContext *context, const SWTransformedVertex *v0, const SWTransformedVertex *v1, const SWTransformedVertex *v2, const SWTransformedVertex *v3);
+// Recomputes the guard band after the viewport changed.
+void swUpdateGuardBand(SWGLContext *context);
+
+// Deferred rendering through the tile bins, see binner.cpp.
+// Clears, triangles and quads are recorded, swFlush() renders them into the back buffer.
+// When present is set, pending fast clears of the color buffer are resolved as well.
+// swRenderBins() renders the commands of any binner into a framebuffer and empties the binner, adding the fragment
+// counters to stats; swFlush() calls it for the binner of the context, after the frames still queued. When present
+// is set and the frame is identical to the front buffer, it renders nothing and returns false: the frame is not
+// presented. swPresentBackBuffer() presents by exchanging the color buffers.
+void swSubmitClear(SWGLContext *context, GLbitfield mask);
+void swSubmitTriangle(SWGLContext *context, const SWScreenVertex *v0, const SWScreenVertex *v1, const SWScreenVertex *v2);
+void swSubmitQuad(SWGLContext *context, const SWScreenVertex *v0, const SWScreenVertex *v1, const SWScreenVertex *v2, const SWScreenVertex *v3);
+bool swRenderBins(SWFramebuffer *framebuffer, SWBinner *binner, bool present, SWGLFrameStats *stats);
+bool swFlush(SWGLContext *context, bool present);
+void swPresentBackBuffer(SWFramebuffer *framebuffer);
+void swInitTiles(SWFramebuffer *framebuffer);
+
+// Pipelined frames, see frameQueue.cpp and swglSetFrameQueueDepth().
+// swPresentFrame() renders the frame of the context and presents it, or queues it for the rendering thread of the
+// context and gives the context an empty binner. swFinishFrames() waits until the queued frames are presented, it
+// has to be called before anything reads the framebuffer or changes how the queued frames are rendered.
+SWFrameQueue *swCreateFrameQueue(void);
+void swDestroyFrameQueue(SWGLContext *context);
+void swPresentFrame(SWGLContext *context);
+void swFinishFrames(SWGLContext *context);
+
+#endif // SOFTWARE_RENDERER_CONTEXT_H
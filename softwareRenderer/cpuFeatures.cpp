@@ -0,0 +1,138 @@
+// Runtime instruction set detection and rasterizer kernel dispatch.
+
+#include "rasterizer.h"
+
+#ifdef SW_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef SW_X86
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int *registers)
+{
+#if defined(_MSC_VER)
+    int values[4];
+    __cpuidex(values, (int)leaf, (int)subleaf);
+
+    for(int i = 0; i < 4; ++i)
+    {
+        registers[i] = (unsigned int)values[i];
+    }
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// Returns the register state enabled by the operating system for XSAVE.
+static unsigned long long xgetbv(void)
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int low;
+    unsigned int high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((unsigned long long)high << 32) | low;
+#endif
+}
+#endif
+
+int swDetectInstructionSet(void)
+{
+#ifdef SW_X86
+    unsigned int registers[4]; // eax, ebx, ecx, edx.
+    cpuid(0, 0, registers);
+    unsigned int maxLeaf = registers[0];
+
+    cpuid(1, 0, registers);
+    bool sse41 = (registers[2] & (1u << 19)) != 0;
+    bool osxsave = (registers[2] & (1u << 27)) != 0;
+    bool avx = (registers[2] & (1u << 28)) != 0;
+
+    // AVX2 also needs the operating system to save the YMM registers on context switch.
+    if(maxLeaf >= 7 && osxsave && avx && (xgetbv() & 0x6) == 0x6)
+    {
+        cpuid(7, 0, registers);
+
+        if(registers[1] & (1u << 5))
+        {
+            return SWGL_INSTRUCTION_SET_AVX2;
+        }
+    }
+
+    if(sse41)
+    {
+        return SWGL_INSTRUCTION_SET_SSE41;
+    }
+#endif
+
+    return SWGL_INSTRUCTION_SET_SCALAR;
+}
+
+SWBlockKernel swGetBlockKernel(int instructionSet)
+{
+    switch(instructionSet)
+    {
+#ifdef SW_X86
+        case SWGL_INSTRUCTION_SET_AVX2:
+            return swRasterizeBlockAVX2;
+
+        case SWGL_INSTRUCTION_SET_SSE41:
+            return swRasterizeBlockSSE41;
+#endif
+
+        default:
+            return swRasterizeBlockScalar;
+    }
+}
+
+static const int swSupportedInstructionSet = swDetectInstructionSet(); // Widest instruction set of this CPU.
+static int swInstructionSet = swSupportedInstructionSet; // Instruction set used by the rasterizer.
+bool swValidateKernels = false;
+
+int swglGetInstructionSet(void)
+{
+    return swInstructionSet;
+}
+
+int swglSetInstructionSet(int instructionSet)
+{
+    if(instructionSet < SWGL_INSTRUCTION_SET_SCALAR || instructionSet > swSupportedInstructionSet)
+    {
+        return FALSE; // Not available on this CPU.
+    }
+
+    // Frames still queued were recorded for the old kernels.
+    if(swCurrentContext)
+    {
+        swFinishFrames(swCurrentContext);
+    }
+
+    swInstructionSet = instructionSet;
+    return TRUE;
+}
+
+const char *swglGetInstructionSetName(int instructionSet)
+{
+    switch(instructionSet)
+    {
+        case SWGL_INSTRUCTION_SET_SCALAR: return "scalar";
+        case SWGL_INSTRUCTION_SET_SSE41: return "sse4.1";
+        case SWGL_INSTRUCTION_SET_AVX2: return "avx2";
+        default: return NULL;
+    }
+}
+
+int swglSetKernelValidation(int enable)
+{
+    if(swCurrentContext)
+    {
+        swFinishFrames(swCurrentContext);
+    }
+
+    swValidateKernels = enable != FALSE;
+    return TRUE;
+}
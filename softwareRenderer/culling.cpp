@@ -0,0 +1,346 @@
+// Bounding-sphere frustum culling of instanced objects, see swglDrawInstanced(), swglDrawScene() and
+// swglSetInstanceCulling().
+//
+// The six planes of the view frustum are extracted from the model-view-projection matrix, so they live in the space
+// the model matrices of the instances map to. Every instance is reduced to the bounding sphere of the geometry moved
+// by its model matrix, and the spheres are tested against the planes in structure of arrays form. The scalar code
+// is the reference implementation; the SSE4.1 and AVX2 code test 4 and 8 spheres at a time with the same operations
+// in the same order, so all of them make the same decisions.
+//
+// Instances are processed in groups of SW_CULL_GROUP_SIZE consecutive ones. With SWGL_INSTANCE_CULLING_GROUPS, a
+// sphere around the whole group is tested first: a group outside one plane is culled and a group inside all of them
+// is visible without testing its instances. This pays off when consecutive instances are close to each other.
+
+#include <math.h>
+#include <string.h>
+
+#include "rasterizer.h"
+
+#ifdef SW_X86
+#include <immintrin.h>
+#endif
+
+#define SW_CULL_GROUP_SIZE 64 // Instances whose bounds are computed and tested together.
+
+// Frustum planes a * x + b * y + c * z + d >= 0 in structure of arrays form, normalized so that the left side is
+// the distance of a point to the plane: left, right, bottom, top, near and far.
+struct SWFrustum
+{
+    float a[6];
+    float b[6];
+    float c[6];
+    float d[6];
+};
+
+// Bounding spheres of a group of instances.
+struct SWSpheres
+{
+    alignas(32) float x[SW_CULL_GROUP_SIZE];
+    alignas(32) float y[SW_CULL_GROUP_SIZE];
+    alignas(32) float z[SW_CULL_GROUP_SIZE];
+    alignas(32) float radius[SW_CULL_GROUP_SIZE];
+};
+
+static int swInstanceCulling = SWGL_INSTANCE_CULLING_SPHERES; // See swglSetInstanceCulling().
+
+// Planes of the clip volume -w <= x, y, z <= w, taken back through matrix: the last row plus or minus another one.
+static void extractFrustum(const float *matrix, SWFrustum *frustum)
+{
+    for(int plane = 0; plane < 6; ++plane)
+    {
+        int row = plane / 2;
+        float sign = (plane & 1) ? -1.0f : 1.0f;
+        float a = matrix[3] + sign * matrix[row];
+        float b = matrix[7] + sign * matrix[4 + row];
+        float c = matrix[11] + sign * matrix[8 + row];
+        float d = matrix[15] + sign * matrix[12 + row];
+        float length = sqrtf(a * a + b * b + c * c);
+
+        // Degenerate planes, like those of a singular matrix, are kept as is and only compare d.
+        if(length > 0.0f)
+        {
+            a /= length;
+            b /= length;
+            c /= length;
+            d /= length;
+        }
+
+        frustum->a[plane] = a;
+        frustum->b[plane] = b;
+        frustum->c[plane] = c;
+        frustum->d[plane] = d;
+    }
+}
+
+// Spheres of count instances starting at matrices and bounds: center moved by the model matrix, radius scaled by
+// its largest axis. The radius is widened a little to cover the rounding of the plane distances.
+static void computeSpheres(const float *matrices, const float *bounds, int boundsStride, int count, SWSpheres *spheres)
+{
+    for(int i = 0; i < count; ++i)
+    {
+        const float *m = &matrices[i * 16];
+        const float *center = &bounds[i * boundsStride];
+        float radius = center[3];
+        float x = m[0] * center[0] + m[4] * center[1] + m[8] * center[2] + m[12];
+        float y = m[1] * center[0] + m[5] * center[1] + m[9] * center[2] + m[13];
+        float z = m[2] * center[0] + m[6] * center[1] + m[10] * center[2] + m[14];
+        float scaleX = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+        float scaleY = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+        float scaleZ = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+        float scale = scaleX > scaleY ? scaleX : scaleY;
+        scale = scale > scaleZ ? scale : scaleZ;
+
+        spheres->x[i] = x;
+        spheres->y[i] = y;
+        spheres->z[i] = z;
+        spheres->radius[i] = radius * sqrtf(scale) * (1.0f + 1.0f / 1024.0f) + (fabsf(x) + fabsf(y) + fabsf(z)) * (1.0f / 65536.0f);
+    }
+}
+
+// Whether a sphere is outside one of the planes (-1), inside all of them (1) or crosses some (0).
+static int classifySphere(const SWFrustum *frustum, float x, float y, float z, float radius)
+{
+    int result = 1;
+
+    for(int plane = 0; plane < 6; ++plane)
+    {
+        float distance = frustum->a[plane] * x + frustum->b[plane] * y + frustum->c[plane] * z + frustum->d[plane];
+
+        if(distance < -radius)
+        {
+            return -1;
+        }
+
+        if(distance < radius)
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+// Sets visible[i] for the spheres from begin to end that are not outside any plane.
+static void testScalar(const SWFrustum *frustum, const SWSpheres *spheres, int begin, int end, unsigned char *visible)
+{
+    for(int i = begin; i < end; ++i)
+    {
+        bool inside = true;
+
+        for(int plane = 0; plane < 6; ++plane)
+        {
+            float distance = frustum->a[plane] * spheres->x[i] + frustum->b[plane] * spheres->y[i]
+                + frustum->c[plane] * spheres->z[i] + frustum->d[plane];
+            inside = inside && !(distance < -spheres->radius[i]);
+        }
+
+        visible[i] = inside;
+    }
+}
+
+#ifdef SW_X86
+// Same as testScalar() for 4 spheres per iteration, returns the number of spheres tested.
+SW_TARGET_SSE41 static int testSSE41(const SWFrustum *frustum, const SWSpheres *spheres, int count, unsigned char *visible)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    int i = 0;
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_load_ps(&spheres->x[i]);
+        __m128 y = _mm_load_ps(&spheres->y[i]);
+        __m128 z = _mm_load_ps(&spheres->z[i]);
+        __m128 negativeRadius = _mm_xor_ps(_mm_load_ps(&spheres->radius[i]), sign);
+        __m128 outside = _mm_setzero_ps();
+
+        for(int plane = 0; plane < 6; ++plane)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(frustum->a[plane]), x),
+                _mm_mul_ps(_mm_set1_ps(frustum->b[plane]), y)),
+                _mm_mul_ps(_mm_set1_ps(frustum->c[plane]), z)),
+                _mm_set1_ps(frustum->d[plane]));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+
+        for(int lane = 0; lane < 4; ++lane)
+        {
+            visible[i + lane] = !(mask & (1 << lane));
+        }
+    }
+
+    return i;
+}
+
+// Same as testScalar() for 8 spheres per iteration, returns the number of spheres tested.
+SW_TARGET_AVX2 static int testAVX2(const SWFrustum *frustum, const SWSpheres *spheres, int count, unsigned char *visible)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    int i = 0;
+
+    for(; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_load_ps(&spheres->x[i]);
+        __m256 y = _mm256_load_ps(&spheres->y[i]);
+        __m256 z = _mm256_load_ps(&spheres->z[i]);
+        __m256 negativeRadius = _mm256_xor_ps(_mm256_load_ps(&spheres->radius[i]), sign);
+        __m256 outside = _mm256_setzero_ps();
+
+        for(int plane = 0; plane < 6; ++plane)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(_mm256_set1_ps(frustum->a[plane]), x),
+                _mm256_mul_ps(_mm256_set1_ps(frustum->b[plane]), y)),
+                _mm256_mul_ps(_mm256_set1_ps(frustum->c[plane]), z)),
+                _mm256_set1_ps(frustum->d[plane]));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negativeRadius, _CMP_LT_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(outside);
+
+        for(int lane = 0; lane < 8; ++lane)
+        {
+            visible[i + lane] = !(mask & (1 << lane));
+        }
+    }
+
+    return i;
+}
+#endif
+
+// Tests count spheres with the code of the selected instruction set.
+static void testSpheres(SWGLContext *context, const SWFrustum *frustum, const SWSpheres *spheres, int count, unsigned char *visible)
+{
+    int tested = 0;
+
+#ifdef SW_X86
+    int instructionSet = swglGetInstructionSet();
+
+    if(instructionSet != SWGL_INSTRUCTION_SET_SCALAR)
+    {
+        tested = instructionSet == SWGL_INSTRUCTION_SET_AVX2 ? testAVX2(frustum, spheres, count, visible) : testSSE41(frustum, spheres, count, visible);
+
+        // Compares every decision with the scalar reference, see swglSetKernelValidation().
+        if(swValidateKernels)
+        {
+            unsigned char reference[SW_CULL_GROUP_SIZE];
+            testScalar(frustum, spheres, 0, tested, reference);
+
+            for(int i = 0; i < tested; ++i)
+            {
+                context->stats.kernelMismatches += reference[i] != visible[i];
+            }
+        }
+    }
+#else
+    (void)context;
+#endif
+
+    // Spheres left over from the vector code.
+    testScalar(frustum, spheres, tested, count, visible);
+}
+
+// Sphere around all spheres of a group: the center of their bounding box and the distance to its corners.
+static void groupSphere(const SWSpheres *spheres, int count, float *x, float *y, float *z, float *radius)
+{
+    float minimum[3] = {INFINITY, INFINITY, INFINITY};
+    float maximum[3] = {-INFINITY, -INFINITY, -INFINITY};
+
+    // Spheres that are not a number make the comparisons fail, which leaves the group at infinite size.
+    for(int i = 0; i < count; ++i)
+    {
+        float r = spheres->radius[i];
+        float low[3] = {spheres->x[i] - r, spheres->y[i] - r, spheres->z[i] - r};
+        float high[3] = {spheres->x[i] + r, spheres->y[i] + r, spheres->z[i] + r};
+
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            minimum[axis] = low[axis] >= minimum[axis] ? minimum[axis] : low[axis];
+            maximum[axis] = high[axis] <= maximum[axis] ? maximum[axis] : high[axis];
+        }
+    }
+
+    float halfX = (maximum[0] - minimum[0]) * 0.5f;
+    float halfY = (maximum[1] - minimum[1]) * 0.5f;
+    float halfZ = (maximum[2] - minimum[2]) * 0.5f;
+
+    *x = minimum[0] + halfX;
+    *y = minimum[1] + halfY;
+    *z = minimum[2] + halfZ;
+    *radius = sqrtf(halfX * halfX + halfY * halfY + halfZ * halfZ) * (1.0f + 1.0f / 1024.0f);
+}
+
+int swCullInstances(SWGLContext *context, const float *modelviewProjection, const float *bounds, int boundsStride,
+    const float *matrices, int count, int *visible)
+{
+    int visibleCount = 0;
+
+    if(swInstanceCulling == SWGL_INSTANCE_CULLING_NONE)
+    {
+        for(int i = 0; i < count; ++i)
+        {
+            visible[visibleCount++] = i;
+        }
+
+        context->stats.objectsVisible += count;
+        return count;
+    }
+
+    SWFrustum frustum;
+    extractFrustum(modelviewProjection, &frustum);
+
+    SWSpheres spheres;
+    unsigned char inside[SW_CULL_GROUP_SIZE];
+
+    for(int first = 0; first < count; first += SW_CULL_GROUP_SIZE)
+    {
+        int groupCount = count - first < SW_CULL_GROUP_SIZE ? count - first : SW_CULL_GROUP_SIZE;
+        computeSpheres(&matrices[first * 16], &bounds[first * boundsStride], boundsStride, groupCount, &spheres);
+
+        int group = 0;
+
+        if(swInstanceCulling == SWGL_INSTANCE_CULLING_GROUPS)
+        {
+            float x, y, z, groupRadius;
+            groupSphere(&spheres, groupCount, &x, &y, &z, &groupRadius);
+            group = classifySphere(&frustum, x, y, z, groupRadius);
+        }
+
+        if(group < 0)
+        {
+            continue;
+        }
+
+        if(group > 0)
+        {
+            memset(inside, 1, groupCount);
+        }
+        else
+        {
+            testSpheres(context, &frustum, &spheres, groupCount, inside);
+        }
+
+        for(int i = 0; i < groupCount; ++i)
+        {
+            visible[visibleCount] = first + i;
+            visibleCount += inside[i];
+        }
+    }
+
+    context->stats.objectsVisible += visibleCount;
+    context->stats.objectsCulled += count - visibleCount;
+    return visibleCount;
+}
+
+int swglSetInstanceCulling(int mode)
+{
+    if(mode != SWGL_INSTANCE_CULLING_NONE && mode != SWGL_INSTANCE_CULLING_SPHERES && mode != SWGL_INSTANCE_CULLING_GROUPS)
+    {
+        return FALSE;
+    }
+
+    swInstanceCulling = mode;
+    return TRUE;
+}
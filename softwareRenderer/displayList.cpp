@@ -0,0 +1,537 @@
+// Display lists of the software renderer.
+//
+// Consecutive glBegin()/glEnd() pairs of the same mode compiled into a list are packed into one draw: a vertex
+// array holding every distinct vertex once, and the primitives as indices into it. glCallList() transforms each
+// stored vertex once and assembles the primitives from the indices. Matrix commands and calls of other lists
+// are stored as they are; other commands are not compiled and execute right away.
+
+#include <limits.h>
+#include <string.h>
+
+#include <map>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#include "context.h"
+
+#define SW_MAX_LIST_NESTING 64 // Like GL_MAX_LIST_NESTING.
+
+struct SWListCommand
+{
+    int type; // One of SW_LIST_*.
+    double arguments[4]; // Arguments of the function, the primitive mode for SW_LIST_DRAW.
+
+    // Ranges of a SW_LIST_DRAW in the vertices and indices of the list.
+    int firstVertex;
+    int vertexCount;
+    int currentColorVertices; // Leading vertices compiled before any glColor3f(), they take the current color.
+    int firstIndex;
+    int indexCount;
+};
+
+struct SWDisplayList
+{
+    std::vector<SWListCommand> commands;
+    std::vector<SWRecordedVertex> vertices;
+    std::vector<unsigned int> indices; // Relative to the first vertex of their draw.
+};
+
+struct SWDisplayLists
+{
+    int referenceCount; // Contexts sharing the lists.
+    std::map<GLuint, SWDisplayList> lists;
+};
+
+// Compiled vertex, the color is 0 when the vertex takes the current color.
+struct SWVertexKey
+{
+    SWRecordedVertex vertex;
+    bool currentColor;
+};
+
+struct SWVertexKeyHash
+{
+    size_t operator()(const SWVertexKey &key) const
+    {
+        // FNV-1a over the bits of the coordinates and the color.
+        unsigned int words[6];
+        memcpy(words, &key.vertex, sizeof(words));
+        size_t hash = key.currentColor ? 1469598103934665603ull : 1099511628211ull;
+
+        for(int i = 0; i < 6; ++i)
+        {
+            hash = (hash ^ words[i]) * 1099511628211ull;
+        }
+
+        return hash;
+    }
+};
+
+struct SWVertexKeyEqual
+{
+    bool operator()(const SWVertexKey &a, const SWVertexKey &b) const
+    {
+        return a.currentColor == b.currentColor && !memcmp(&a.vertex, &b.vertex, sizeof(SWRecordedVertex));
+    }
+};
+
+struct SWListBuilder
+{
+    GLuint name;
+    GLenum mode; // GL_COMPILE or GL_COMPILE_AND_EXECUTE.
+    SWDisplayList list;
+
+    bool drawOpen; // The last command is a draw that the next glBegin() of the same mode continues.
+    bool insideBeginEnd;
+    int primitiveSize;
+    int primitiveIndexCount; // Indices of the incomplete primitive.
+    std::unordered_map<SWVertexKey, unsigned int, SWVertexKeyHash, SWVertexKeyEqual> vertexIndices; // Vertices of the open draw.
+
+    bool colorSet; // A glColor3f() has been compiled, later vertices have their own color.
+    bool colorPending; // The last compiled color has not been stored as a command yet.
+    float color[3];
+};
+
+SWDisplayLists *swCreateDisplayLists(void)
+{
+    SWDisplayLists *lists = new(std::nothrow) SWDisplayLists();
+
+    if(lists)
+    {
+        lists->referenceCount = 1;
+    }
+
+    return lists;
+}
+
+void swReleaseDisplayLists(SWDisplayLists *lists)
+{
+    if(lists && --lists->referenceCount == 0)
+    {
+        delete lists;
+    }
+}
+
+void swAbortList(SWGLContext *context)
+{
+    delete context->listBuilder;
+    context->listBuilder = NULL;
+}
+
+static SWListCommand *appendCommand(SWListBuilder *builder, int type, double argument0, double argument1, double argument2, double argument3)
+{
+    SWListCommand command;
+    memset(&command, 0, sizeof(command));
+    command.type = type;
+    command.arguments[0] = argument0;
+    command.arguments[1] = argument1;
+    command.arguments[2] = argument2;
+    command.arguments[3] = argument3;
+
+    builder->list.commands.push_back(command);
+    builder->drawOpen = type == SW_LIST_DRAW;
+    return &builder->list.commands.back();
+}
+
+// Stores the color set by the compiled glColor3f() calls, for the current color after the list and for the
+// lists it calls.
+static void storePendingColor(SWListBuilder *builder)
+{
+    if(builder->colorPending)
+    {
+        appendCommand(builder, SW_LIST_COLOR, builder->color[0], builder->color[1], builder->color[2], 0.0);
+        builder->colorPending = false;
+    }
+}
+
+static void compileBegin(SWListBuilder *builder, GLenum mode)
+{
+    if(builder->insideBeginEnd || (mode != GL_TRIANGLES && mode != GL_QUADS))
+    {
+        return;
+    }
+
+    SWDisplayList *list = &builder->list;
+
+    if(!builder->drawOpen || list->commands.back().arguments[0] != mode)
+    {
+        SWListCommand *draw = appendCommand(builder, SW_LIST_DRAW, mode, 0.0, 0.0, 0.0);
+        draw->firstVertex = (int)list->vertices.size();
+        draw->firstIndex = (int)list->indices.size();
+        builder->vertexIndices.clear();
+    }
+
+    builder->insideBeginEnd = true;
+    builder->primitiveSize = mode == GL_QUADS ? 4 : 3;
+    builder->primitiveIndexCount = 0;
+}
+
+static void compileVertex(SWListBuilder *builder, float x, float y, float z)
+{
+    if(!builder->insideBeginEnd)
+    {
+        return;
+    }
+
+    SWDisplayList *list = &builder->list;
+    SWListCommand *draw = &list->commands.back();
+
+    SWVertexKey key;
+    key.vertex.x = x;
+    key.vertex.y = y;
+    key.vertex.z = z;
+    key.vertex.r = builder->colorSet ? builder->color[0] : 0.0f;
+    key.vertex.g = builder->colorSet ? builder->color[1] : 0.0f;
+    key.vertex.b = builder->colorSet ? builder->color[2] : 0.0f;
+    key.currentColor = !builder->colorSet;
+
+    // Vertices taking the current color are all compiled before the first color, they come first in the draw.
+    std::pair<std::unordered_map<SWVertexKey, unsigned int, SWVertexKeyHash, SWVertexKeyEqual>::iterator, bool> entry =
+        builder->vertexIndices.insert(std::make_pair(key, (unsigned int)(list->vertices.size() - draw->firstVertex)));
+
+    if(entry.second)
+    {
+        list->vertices.push_back(key.vertex);
+        draw->currentColorVertices += key.currentColor ? 1 : 0;
+    }
+
+    list->indices.push_back(entry.first->second);
+    builder->primitiveIndexCount = (builder->primitiveIndexCount + 1) % builder->primitiveSize;
+}
+
+static void compileEnd(SWListBuilder *builder)
+{
+    if(!builder->insideBeginEnd)
+    {
+        return;
+    }
+
+    // Vertices of an incomplete primitive are ignored.
+    SWDisplayList *list = &builder->list;
+    list->indices.resize(list->indices.size() - builder->primitiveIndexCount);
+    builder->insideBeginEnd = false;
+
+    SWListCommand *draw = &list->commands.back();
+    draw->vertexCount = (int)list->vertices.size() - draw->firstVertex;
+    draw->indexCount = (int)list->indices.size() - draw->firstIndex;
+}
+
+bool swCompileCommand(SWGLContext *context, int command, double argument0, double argument1, double argument2, double argument3)
+{
+    SWListBuilder *builder = context->listBuilder;
+
+    switch(command)
+    {
+        case SW_LIST_BEGIN:
+            compileBegin(builder, (GLenum)argument0);
+            break;
+
+        case SW_LIST_END:
+            compileEnd(builder);
+            break;
+
+        case SW_LIST_VERTEX:
+            compileVertex(builder, (float)argument0, (float)argument1, (float)argument2);
+            break;
+
+        case SW_LIST_COLOR:
+            builder->color[0] = (float)argument0;
+            builder->color[1] = (float)argument1;
+            builder->color[2] = (float)argument2;
+            builder->colorSet = true;
+            builder->colorPending = true;
+            break;
+
+        case SW_LIST_CALL:
+            storePendingColor(builder);
+            appendCommand(builder, command, argument0, argument1, argument2, argument3);
+            break;
+
+        default:
+            appendCommand(builder, command, argument0, argument1, argument2, argument3);
+            break;
+    }
+
+    return builder->mode == GL_COMPILE_AND_EXECUTE;
+}
+
+static void executeList(SWGLContext *context, const SWDisplayList *list)
+{
+    for(size_t i = 0; i < list->commands.size(); ++i)
+    {
+        const SWListCommand *command = &list->commands[i];
+        const double *arguments = command->arguments;
+
+        switch(command->type)
+        {
+            case SW_LIST_DRAW:
+                swDrawIndexed(context, (GLenum)arguments[0], &list->vertices[command->firstVertex], command->vertexCount,
+                    command->currentColorVertices, &list->indices[command->firstIndex], command->indexCount);
+                break;
+
+            case SW_LIST_COLOR:
+                glColor3f((GLfloat)arguments[0], (GLfloat)arguments[1], (GLfloat)arguments[2]);
+                break;
+
+            case SW_LIST_MATRIX_MODE:
+                glMatrixMode((GLenum)arguments[0]);
+                break;
+
+            case SW_LIST_LOAD_IDENTITY:
+                glLoadIdentity();
+                break;
+
+            case SW_LIST_PUSH_MATRIX:
+                glPushMatrix();
+                break;
+
+            case SW_LIST_POP_MATRIX:
+                glPopMatrix();
+                break;
+
+            case SW_LIST_TRANSLATE:
+                glTranslatef((GLfloat)arguments[0], (GLfloat)arguments[1], (GLfloat)arguments[2]);
+                break;
+
+            case SW_LIST_ROTATE:
+                glRotatef((GLfloat)arguments[0], (GLfloat)arguments[1], (GLfloat)arguments[2], (GLfloat)arguments[3]);
+                break;
+
+            case SW_LIST_PERSPECTIVE:
+                gluPerspective(arguments[0], arguments[1], arguments[2], arguments[3]);
+                break;
+
+            case SW_LIST_CALL:
+                glCallList((GLuint)arguments[0]);
+                break;
+        }
+    }
+}
+
+GLuint glGenLists(GLsizei range)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return 0;
+    }
+
+    if(range < 0)
+    {
+        swSetError(context, GL_INVALID_VALUE);
+        return 0;
+    }
+
+    if(context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return 0;
+    }
+
+    if(range == 0)
+    {
+        return 0;
+    }
+
+    // First gap of range unused names.
+    std::map<GLuint, SWDisplayList> *lists = &context->lists->lists;
+    GLuint first = 1;
+
+    for(std::map<GLuint, SWDisplayList>::iterator list = lists->begin(); list != lists->end(); ++list)
+    {
+        if(list->first - first >= (GLuint)range)
+        {
+            break;
+        }
+
+        first = list->first + 1;
+    }
+
+    if(first == 0 || first - 1 > UINT_MAX - (GLuint)range)
+    {
+        return 0;
+    }
+
+    // The names become empty lists.
+    for(GLuint name = first; name - first < (GLuint)range; ++name)
+    {
+        (*lists)[name];
+    }
+
+    return first;
+}
+
+GLvoid glDeleteLists(GLuint list, GLsizei range)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(range < 0)
+    {
+        swSetError(context, GL_INVALID_VALUE);
+        return;
+    }
+
+    if(context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return;
+    }
+
+    std::map<GLuint, SWDisplayList> *lists = &context->lists->lists;
+    std::map<GLuint, SWDisplayList>::iterator last = lists->lower_bound(list);
+
+    while(last != lists->end() && last->first - list < (GLuint)range)
+    {
+        ++last;
+    }
+
+    lists->erase(lists->lower_bound(list), last);
+}
+
+GLboolean glIsList(GLuint list)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return GL_FALSE;
+    }
+
+    return context->lists->lists.count(list) ? GL_TRUE : GL_FALSE;
+}
+
+GLvoid glNewList(GLuint list, GLenum mode)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(list == 0)
+    {
+        swSetError(context, GL_INVALID_VALUE);
+        return;
+    }
+
+    if(mode != GL_COMPILE && mode != GL_COMPILE_AND_EXECUTE)
+    {
+        swSetError(context, GL_INVALID_ENUM);
+        return;
+    }
+
+    if(context->listBuilder || context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return;
+    }
+
+    SWListBuilder *builder = new(std::nothrow) SWListBuilder();
+
+    if(!builder)
+    {
+        swSetError(context, GL_OUT_OF_MEMORY);
+        return;
+    }
+
+    builder->name = list;
+    builder->mode = mode;
+    context->listBuilder = builder;
+}
+
+GLvoid glEndList(GLvoid)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    SWListBuilder *builder = context->listBuilder;
+
+    if(!builder || context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return;
+    }
+
+    compileEnd(builder);
+    storePendingColor(builder);
+
+    // Replaces the previous contents of the list, without spare capacity.
+    SWDisplayList *list = &context->lists->lists[builder->name];
+    list->commands.assign(builder->list.commands.begin(), builder->list.commands.end());
+    list->vertices.assign(builder->list.vertices.begin(), builder->list.vertices.end());
+    list->indices.assign(builder->list.indices.begin(), builder->list.indices.end());
+    swAbortList(context);
+}
+
+GLvoid glCallList(GLuint list)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(context->listBuilder && !swCompileCommand(context, SW_LIST_CALL, list, 0.0, 0.0, 0.0))
+    {
+        return;
+    }
+
+    if(context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return;
+    }
+
+    std::map<GLuint, SWDisplayList>::const_iterator entry = context->lists->lists.find(list);
+
+    // Undefined lists and calls nested too deeply are ignored.
+    if(entry == context->lists->lists.end() || context->listNesting >= SW_MAX_LIST_NESTING)
+    {
+        return;
+    }
+
+    // With GL_COMPILE_AND_EXECUTE the commands of the called list are executed, not compiled again.
+    SWListBuilder *builder = context->listBuilder;
+    context->listBuilder = NULL;
+    context->listNesting++;
+    executeList(context, &entry->second);
+    context->listNesting--;
+    context->listBuilder = builder;
+}
+
+int swglShareLists(HSWGLRC source, HSWGLRC target)
+{
+    if(!source || !target)
+    {
+        return FALSE;
+    }
+
+    if(source->lists == target->lists)
+    {
+        return TRUE;
+    }
+
+    // Like wglShareLists(), the target must not have lists of its own yet.
+    if(!target->lists->lists.empty() || target->listBuilder)
+    {
+        return FALSE;
+    }
+
+    swReleaseDisplayLists(target->lists);
+    target->lists = source->lists;
+    target->lists->referenceCount++;
+    return TRUE;
+}
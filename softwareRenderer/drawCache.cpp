@@ -0,0 +1,227 @@
+// Cross-frame cache of static draws of the software renderer, see swglSetDrawCache().
+//
+// Every draw reaching the geometry stage through swReplayDraw() is identified by a key: a hash of its vertices
+// and indices, and the matrix and render state its primitive setups depend on. A key seen in the previous frame
+// is recorded the next time it is drawn: the setups the draw appends to the tile bins are copied. From then on
+// the draw bins the copies, skipping transform, clipping and setup. Keys not drawn in a frame are dropped when it
+// is presented, so a moving object costs one hash and one lookup per frame and is never recorded.
+
+#include <string.h>
+
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#include "binner.h"
+
+struct SWCachedDraw
+{
+    SWDrawKey key;
+    unsigned int frame; // Last frame the draw was seen in.
+    bool recorded;
+    std::vector<SWPrimitiveSetup> setups;
+    SWGLFrameStats stats; // Geometry counters of the recorded draw.
+};
+
+struct SWDrawCache
+{
+    std::unordered_map<unsigned long long, SWCachedDraw> draws;
+    unsigned int frame;
+    SWCachedDraw *recording; // Draw being recorded between swReplayDraw() and swRecordDraw(), NULL otherwise.
+    size_t firstPrimitive; // Primitives of the binner before the recorded draw.
+    SWGLFrameStats statsBefore;
+};
+
+bool swCacheDraws = true;
+
+SWDrawCache *swCreateDrawCache(void)
+{
+    SWDrawCache *cache = new(std::nothrow) SWDrawCache();
+
+    if(cache)
+    {
+        cache->frame = 0;
+        cache->recording = NULL;
+    }
+
+    return cache;
+}
+
+void swDestroyDrawCache(SWDrawCache *cache)
+{
+    delete cache;
+}
+
+static inline unsigned long long rotateLeft(unsigned long long value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Rounds and finalization of xxHash64, over four independent lanes so that the multiplications overlap.
+static const unsigned long long swPrime1 = 0x9E3779B185EBCA87ull;
+static const unsigned long long swPrime2 = 0xC2B2AE3D27D4EB4Full;
+static const unsigned long long swPrime3 = 0x165667B19E3779F9ull;
+
+static inline unsigned long long hashRound(unsigned long long lane, unsigned long long word)
+{
+    return rotateLeft(lane + word * swPrime2, 31) * swPrime1;
+}
+
+unsigned long long swHashMemory(const void *data, size_t size, unsigned long long seed)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    unsigned long long lanes[4] = {seed + swPrime1 + swPrime2, seed + swPrime2, seed, seed - swPrime1};
+    size_t position = 0;
+
+    for(; position + 32 <= size; position += 32)
+    {
+        for(int lane = 0; lane < 4; ++lane)
+        {
+            unsigned long long word;
+            memcpy(&word, bytes + position + lane * 8, sizeof(word));
+            lanes[lane] = hashRound(lanes[lane], word);
+        }
+    }
+
+    unsigned long long hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+    hash += size;
+
+    for(; position + 8 <= size; position += 8)
+    {
+        unsigned long long word;
+        memcpy(&word, bytes + position, sizeof(word));
+        hash = rotateLeft(hash ^ hashRound(0, word), 27) * swPrime1 + swPrime3;
+    }
+
+    for(; position < size; ++position)
+    {
+        hash = rotateLeft(hash ^ (bytes[position] * swPrime3), 11) * swPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= swPrime2;
+    hash ^= hash >> 29;
+    hash *= swPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+bool swReplayDraw(SWGLContext *context, const SWDrawKey *key)
+{
+    SWDrawCache *cache = context->drawCache;
+
+    // Validation compares the vector geometry stage with the scalar one, it has to run.
+    if(!swCacheDraws || swValidateKernels)
+    {
+        return false;
+    }
+
+    context->stats.drawCacheLookups++;
+
+    unsigned long long hash = swHashMemory(key, sizeof(*key), 0);
+    std::unordered_map<unsigned long long, SWCachedDraw>::iterator found = cache->draws.find(hash);
+
+    // New keys, and keys of other draws with the same hash, start over. Found keys were drawn in this frame or the
+    // previous one, older ones are gone.
+    if(found == cache->draws.end() || memcmp(&found->second.key, key, sizeof(*key)) != 0)
+    {
+        SWCachedDraw *draw;
+
+        try
+        {
+            draw = &cache->draws[hash];
+        }
+        catch(const std::bad_alloc &)
+        {
+            return false;
+        }
+
+        draw->key = *key;
+        draw->frame = cache->frame;
+        draw->recorded = false;
+        draw->setups.clear();
+        return false;
+    }
+
+    SWCachedDraw *draw = &found->second;
+    draw->frame = cache->frame;
+
+    if(!draw->recorded)
+    {
+        cache->recording = draw;
+        cache->firstPrimitive = context->binner->primitives.size();
+        cache->statsBefore = context->stats;
+        return false;
+    }
+
+    swBinPrimitives(context->binner, draw->setups.data(), draw->setups.size());
+    context->stats.drawCacheHits++;
+    context->stats.primitivesSubmitted += draw->stats.primitivesSubmitted;
+    context->stats.primitivesCulled += draw->stats.primitivesCulled;
+    context->stats.trianglesClipped += draw->stats.trianglesClipped;
+    context->stats.trianglesRasterized += draw->stats.trianglesRasterized;
+    context->stats.quadsRasterized += draw->stats.quadsRasterized;
+    return true;
+}
+
+void swRecordDraw(SWGLContext *context)
+{
+    SWDrawCache *cache = context->drawCache;
+    SWCachedDraw *draw = cache->recording;
+
+    if(!draw)
+    {
+        return;
+    }
+
+    cache->recording = NULL;
+    const std::vector<SWPrimitiveSetup> &primitives = context->binner->primitives;
+
+    try
+    {
+        draw->setups.assign(primitives.begin() + cache->firstPrimitive, primitives.end());
+    }
+    catch(const std::bad_alloc &)
+    {
+        return; // Recorded again the next frame.
+    }
+
+    draw->recorded = true;
+    draw->stats.primitivesSubmitted = context->stats.primitivesSubmitted - cache->statsBefore.primitivesSubmitted;
+    draw->stats.primitivesCulled = context->stats.primitivesCulled - cache->statsBefore.primitivesCulled;
+    draw->stats.trianglesClipped = context->stats.trianglesClipped - cache->statsBefore.trianglesClipped;
+    draw->stats.trianglesRasterized = context->stats.trianglesRasterized - cache->statsBefore.trianglesRasterized;
+    draw->stats.quadsRasterized = context->stats.quadsRasterized - cache->statsBefore.quadsRasterized;
+}
+
+void swEndDrawCacheFrame(SWGLContext *context)
+{
+    SWDrawCache *cache = context->drawCache;
+
+    for(std::unordered_map<unsigned long long, SWCachedDraw>::iterator draw = cache->draws.begin(); draw != cache->draws.end();)
+    {
+        if(draw->second.frame == cache->frame)
+        {
+            ++draw;
+        }
+        else
+        {
+            draw = cache->draws.erase(draw);
+        }
+    }
+
+    cache->frame++;
+}
+
+int swglSetDrawCache(int enable)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(context && context->insideBeginEnd)
+    {
+        return FALSE;
+    }
+
+    swCacheDraws = enable != FALSE;
+    return TRUE;
+}
@@ -0,0 +1,262 @@
+// Pipelined frames of the software renderer, see swglSetFrameQueueDepth().
+//
+// With a queue depth above 0, swglSwapBuffers() hands the binner of the frame to a rendering thread of the context
+// and records the next frame into another one: the application thread runs the front end (commands, transform,
+// clipping, setup and binning) of frame N+1 while the rendering thread rasterizes frame N on the worker threads.
+// The rendering thread renders and presents the queued frames in order; the depth bounds how many frames it holds
+// when swglSwapBuffers() returns, which trades latency for smoothing out frames of different cost.
+
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "binner.h"
+
+#define SW_MAX_FRAME_QUEUE_DEPTH 3
+
+struct SWFrameQueue
+{
+    std::thread thread; // Started with the first queued frame.
+    std::mutex mutex;
+    std::condition_variable frameQueued; // Signalled when a frame is queued or the thread has to stop.
+    std::condition_variable framePresented; // Signalled when the thread presented a frame.
+    bool stopping;
+
+    std::deque<SWBinner *> frames; // Queued frames, oldest first; the first one is being rendered.
+    std::vector<SWBinner *> spareBinners; // Binners of presented frames, to record the next ones into.
+    std::deque<SWGLFrameStats> presented; // Statistics of presented frames not reported by swglGetFrameStats() yet.
+    unsigned long long queuedFrames; // Frames queued since the depth last changed.
+};
+
+static int swFrameQueueDepth = 0;
+
+SWFrameQueue *swCreateFrameQueue(void)
+{
+    SWFrameQueue *queue = new(std::nothrow) SWFrameQueue();
+
+    if(queue)
+    {
+        queue->stopping = false;
+        queue->queuedFrames = 0;
+    }
+
+    return queue;
+}
+
+// Body of the rendering thread of a context.
+static void renderFrames(SWGLContext *context)
+{
+    SWFrameQueue *queue = context->frameQueue;
+    std::unique_lock<std::mutex> lock(queue->mutex);
+
+    for(;;)
+    {
+        while(!queue->stopping && queue->frames.empty())
+        {
+            queue->frameQueued.wait(lock);
+        }
+
+        if(queue->frames.empty())
+        {
+            return;
+        }
+
+        // The application thread does not touch queued frames nor the color buffers, render without the lock.
+        SWBinner *binner = queue->frames.front();
+        lock.unlock();
+        bool changed = swRenderBins(&context->framebuffer, binner, true, &binner->stats);
+        lock.lock();
+
+        if(changed)
+        {
+            swPresentBackBuffer(&context->framebuffer);
+        }
+
+        queue->frames.pop_front();
+        queue->presented.push_back(binner->stats);
+        queue->spareBinners.push_back(binner);
+        queue->framePresented.notify_all();
+    }
+}
+
+void swDestroyFrameQueue(SWGLContext *context)
+{
+    SWFrameQueue *queue = context->frameQueue;
+
+    if(!queue)
+    {
+        return;
+    }
+
+    if(queue->thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->stopping = true;
+        }
+
+        queue->frameQueued.notify_all();
+        queue->thread.join(); // Renders the frames still queued first.
+    }
+
+    for(size_t i = 0; i < queue->spareBinners.size(); ++i)
+    {
+        swDestroyBinner(queue->spareBinners[i]);
+    }
+
+    delete queue;
+    context->frameQueue = NULL;
+}
+
+// Waits while more than count frames are queued, and adds the time waited to the statistics of the frame being
+// recorded. Called with the lock held.
+static void waitForFrames(SWGLContext *context, std::unique_lock<std::mutex> &lock, size_t count)
+{
+    SWFrameQueue *queue = context->frameQueue;
+
+    if(queue->frames.size() <= count)
+    {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    while(queue->frames.size() > count)
+    {
+        queue->framePresented.wait(lock);
+    }
+
+    context->stats.queueStallMicroseconds += (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void swFinishFrames(SWGLContext *context)
+{
+    SWFrameQueue *queue = context->frameQueue;
+
+    if(queue->thread.joinable())
+    {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        waitForFrames(context, lock, 0);
+    }
+}
+
+// Renders and presents the frame on the calling thread.
+static void presentNow(SWGLContext *context)
+{
+    if(swFlush(context, true))
+    {
+        swPresentBackBuffer(&context->framebuffer);
+    }
+
+    context->presentedStats = context->stats;
+}
+
+void swPresentFrame(SWGLContext *context)
+{
+    SWFrameQueue *queue = context->frameQueue;
+    size_t depth = (size_t)swFrameQueueDepth;
+
+    if(depth == 0)
+    {
+        presentNow(context);
+        return;
+    }
+
+    swFlushVertices(context);
+
+    // Take a binner for the next frame and start the rendering thread. Without them the frame is rendered here.
+    SWBinner *next = NULL;
+
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+
+        if(!queue->spareBinners.empty())
+        {
+            next = queue->spareBinners.back();
+            queue->spareBinners.pop_back();
+        }
+    }
+
+    if(!next && !(next = swCreateBinner(&context->framebuffer)))
+    {
+        presentNow(context);
+        return;
+    }
+
+    if(!queue->thread.joinable())
+    {
+        try
+        {
+            queue->thread = std::thread(renderFrames, context);
+        }
+        catch(const std::system_error &)
+        {
+            swDestroyBinner(next);
+            presentNow(context);
+            return;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(queue->mutex);
+
+    // Make room first, so that the frame queued carries the time waited for it.
+    waitForFrames(context, lock, depth - 1);
+    context->stats.framesQueued = queue->frames.size();
+
+    SWBinner *binner = context->binner;
+    binner->stats = context->stats;
+    queue->frames.push_back(binner);
+    queue->queuedFrames++;
+    context->binner = next;
+
+    // Frame N - depth is presented by now, it is the one reported until the next swap. The statistics of another
+    // context changing the depth may be missing, see swglSetFrameQueueDepth().
+    if(queue->queuedFrames > depth && !queue->presented.empty())
+    {
+        context->presentedStats = queue->presented.front();
+        queue->presented.pop_front();
+    }
+    else if(queue->queuedFrames <= depth)
+    {
+        memset(&context->presentedStats, 0, sizeof(context->presentedStats));
+    }
+
+    lock.unlock();
+    queue->frameQueued.notify_one();
+}
+
+int swglSetFrameQueueDepth(int depth)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(depth < 0 || depth > SW_MAX_FRAME_QUEUE_DEPTH || (context && context->insideBeginEnd))
+    {
+        return FALSE;
+    }
+
+    // Report the last presented frame, and restart counting with the new depth.
+    if(context)
+    {
+        swFinishFrames(context);
+        std::lock_guard<std::mutex> lock(context->frameQueue->mutex);
+
+        if(!context->frameQueue->presented.empty())
+        {
+            context->presentedStats = context->frameQueue->presented.back();
+        }
+
+        context->frameQueue->presented.clear();
+        context->frameQueue->queuedFrames = 0;
+    }
+
+    swFrameQueueDepth = depth;
+    return TRUE;
+}
@@ -0,0 +1,362 @@
+// Frame pacing for the frame loops of the samples and of swglRunHeadless(), and the fixed-step clock of their
+// animations.
+//
+// Header only, so that the Windows builds of the samples can use it without the rest of the software renderer.
+// swWaitForFrame() sleeps until shortly before the next frame is due and spins for the rest: the operating system
+// wakes threads late by an amount that varies, so the margin left for spinning follows the mean and deviation of
+// the lateness seen so far. Samples far above them are clamped: a thread preempted once says little about the next
+// sleep, and spinning longer for every frame after it would waste a core. On Windows the sleep is a high-resolution
+// waitable timer when available, and it ends early when a window message arrives, so input is handled while waiting.
+//
+// swAdvanceFrameTimer() turns the time between rendered frames into a number of simulation steps of a fixed length,
+// so that animations run at the same speed at any frame rate and are rendered interpolated between their last two
+// steps. When rendering falls behind, a frame runs several steps, up to a limit beyond which the backlog is dropped
+// and the animation slows down instead of spending ever more time catching up.
+
+#ifndef SOFTWARE_RENDERER_FRAME_SCHEDULER_H
+#define SOFTWARE_RENDERER_FRAME_SCHEDULER_H
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define SW_FRAME_PACING_UNCAPPED 0 // Frames start as soon as the previous one is done.
+#define SW_FRAME_PACING_FIXED 1 // Frames start rate times per second; after a late frame the next one starts a whole period later.
+#define SW_FRAME_PACING_VSYNC 2 // Frames start on a grid of rate lines per second, like vertical blanks; a late frame waits for the next line.
+
+#define SW_FRAME_SLEEP_MIN_MARGIN 0.0002 // Seconds always left for spinning before a deadline.
+#define SW_FRAME_SLEEP_MAX_MARGIN 0.02
+
+struct SWFrameScheduler
+{
+    int pacing; // One of SW_FRAME_PACING_*.
+    double period; // Seconds between frames, 0 when uncapped.
+    double origin; // First frame, the grid of SW_FRAME_PACING_VSYNC starts there.
+    double deadline; // Start of the next frame.
+    double lastFrame; // Start of the last frame, negative before the first one.
+
+    // Lateness of the operating system sleep, as exponential moving averages of its value and its absolute deviation.
+    double lateness;
+    double latenessDeviation;
+
+    // Statistics since swInitFrameScheduler().
+    long long frames;
+    double intervalSum; // Times between consecutive frame starts.
+    double intervalSquareSum;
+    double intervalMax;
+    double startTime;
+    double startCpuTime;
+
+#if defined(_WIN32)
+    HANDLE timer;
+#endif
+};
+
+struct SWFrameTimer
+{
+    double step; // Seconds of simulation per step.
+    double fixedDelta; // Seconds every frame advances by in the deterministic mode, 0 follows swFrameClock().
+    int maxSteps; // Steps a frame runs at most, the time beyond them is dropped.
+    double lastTime; // Clock at the last frame, negative before the first one.
+    double delta; // Seconds the last frame advanced by, including dropped time.
+    double accumulator; // Seconds not simulated yet, less than a step between frames.
+    double alpha; // accumulator / step, the position of the rendered frame between the last two steps.
+    long long steps; // Steps run so far.
+    double droppedTime; // Seconds dropped so far.
+};
+
+struct SWFramePacingStats
+{
+    long long frames;
+    double framesPerSecond;
+    double interval; // Mean time between frame starts, in seconds.
+    double jitter; // Standard deviation of the time between frame starts.
+    double intervalMax;
+    double cpuUtilization; // Process CPU time over elapsed time, 1.0 for one busy core.
+};
+
+// Seconds of a monotonic clock.
+static inline double swFrameClock(void)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Seconds of CPU time used by all threads of the process.
+static inline double swProcessCpuTime(void)
+{
+#if defined(_WIN32)
+    FILETIME creation, exitTime, kernel, user;
+
+    if(!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user))
+    {
+        return 0.0;
+    }
+
+    ULARGE_INTEGER kernelTime, userTime;
+    kernelTime.LowPart = kernel.dwLowDateTime;
+    kernelTime.HighPart = kernel.dwHighDateTime;
+    userTime.LowPart = user.dwLowDateTime;
+    userTime.HighPart = user.dwHighDateTime;
+    return (double)(kernelTime.QuadPart + userTime.QuadPart) * 1e-7;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#endif
+}
+
+// Reads "uncapped", "vsync" or a frame rate. Returns false for anything else.
+static inline bool swParseFramePacing(const char *text, int *pacing, double *rate)
+{
+    char *end = NULL;
+    double value = strtod(text, &end);
+
+    if(!strcmp(text, "uncapped"))
+    {
+        *pacing = SW_FRAME_PACING_UNCAPPED;
+    }
+    else if(!strcmp(text, "vsync"))
+    {
+        *pacing = SW_FRAME_PACING_VSYNC;
+    }
+    else if(end != text && *end == '\0' && value > 0.0 && value <= 10000.0)
+    {
+        *pacing = SW_FRAME_PACING_FIXED;
+        *rate = value;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Looks for "-fps <rate|uncapped|vsync>" in a command line like the one WinMain() receives and reads its value with
+// swParseFramePacing(). Leaves pacing and rate alone when there is no such option, returns false when its value is
+// invalid.
+static inline bool swParseFramePacingOption(const char *commandLine, int *pacing, double *rate)
+{
+    const char *option = commandLine ? strstr(commandLine, "-fps ") : NULL;
+    char value[32];
+    size_t length = 0;
+
+    if(!option)
+    {
+        return true;
+    }
+
+    for(option += 5; *option == ' '; ++option)
+    {
+    }
+
+    while(option[length] && option[length] != ' ' && length + 1 < sizeof(value))
+    {
+        value[length] = option[length];
+        length++;
+    }
+
+    value[length] = '\0';
+    return swParseFramePacing(value, pacing, rate);
+}
+
+// rate is ignored when uncapped. Returns false when the timer can not be created.
+static inline bool swInitFrameScheduler(SWFrameScheduler *scheduler, int pacing, double rate)
+{
+    memset(scheduler, 0, sizeof(*scheduler));
+    scheduler->pacing = pacing;
+    scheduler->period = pacing == SW_FRAME_PACING_UNCAPPED || rate <= 0.0 ? 0.0 : 1.0 / rate;
+    scheduler->lastFrame = -1.0;
+    scheduler->lateness = 0.001;
+    scheduler->latenessDeviation = 0.0005;
+    scheduler->startTime = swFrameClock();
+    scheduler->startCpuTime = swProcessCpuTime();
+    scheduler->origin = scheduler->startTime;
+    scheduler->deadline = scheduler->startTime;
+
+#if defined(_WIN32)
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+    // High-resolution timers need Windows 10 1803, older versions get a timer of the scheduler tick.
+    scheduler->timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+    if(!scheduler->timer)
+    {
+        scheduler->timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+        scheduler->lateness = 0.016;
+    }
+
+    return scheduler->timer != NULL;
+#else
+    return true;
+#endif
+}
+
+static inline void swDestroyFrameScheduler(SWFrameScheduler *scheduler)
+{
+#if defined(_WIN32)
+    if(scheduler->timer)
+    {
+        CloseHandle(scheduler->timer);
+        scheduler->timer = NULL;
+    }
+#else
+    (void)scheduler;
+#endif
+}
+
+// Sleeps until wakeTime, or on Windows until a window message arrives. Returns false in that case.
+static inline bool swFrameSleep(SWFrameScheduler *scheduler, double wakeTime)
+{
+    double before = swFrameClock();
+
+    if(wakeTime <= before)
+    {
+        return true;
+    }
+
+#if defined(_WIN32)
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -(LONGLONG)((wakeTime - before) * 1e7); // Relative, in 100 ns units.
+
+    if(SetWaitableTimer(scheduler->timer, &dueTime, 0, NULL, NULL, FALSE)
+        && MsgWaitForMultipleObjects(1, &scheduler->timer, FALSE, INFINITE, QS_ALLINPUT) == WAIT_OBJECT_0 + 1)
+    {
+        CancelWaitableTimer(scheduler->timer);
+        return false;
+    }
+#else
+    std::this_thread::sleep_for(std::chrono::duration<double>(wakeTime - before));
+#endif
+
+    double lateness = swFrameClock() - wakeTime;
+    double limit = scheduler->lateness + 4.0 * scheduler->latenessDeviation + SW_FRAME_SLEEP_MIN_MARGIN;
+    double difference = (lateness < limit ? lateness : limit) - scheduler->lateness;
+    scheduler->lateness += 0.1 * difference;
+    scheduler->latenessDeviation += 0.1 * (fabs(difference) - scheduler->latenessDeviation);
+    return true;
+}
+
+// Waits until the next frame is due and returns true, after which the caller renders the frame. Returns false
+// before that when a window message arrives on Windows; the caller handles it and calls again.
+static inline bool swWaitForFrame(SWFrameScheduler *scheduler)
+{
+    if(scheduler->period > 0.0)
+    {
+        double margin = scheduler->lateness + 2.0 * scheduler->latenessDeviation;
+        margin = margin > SW_FRAME_SLEEP_MIN_MARGIN ? margin : SW_FRAME_SLEEP_MIN_MARGIN;
+        margin = margin < SW_FRAME_SLEEP_MAX_MARGIN ? margin : SW_FRAME_SLEEP_MAX_MARGIN;
+
+        if(!swFrameSleep(scheduler, scheduler->deadline - margin))
+        {
+            return false;
+        }
+
+        while(swFrameClock() < scheduler->deadline)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    double now = swFrameClock();
+
+    if(scheduler->lastFrame >= 0.0)
+    {
+        double interval = now - scheduler->lastFrame;
+        scheduler->intervalSum += interval;
+        scheduler->intervalSquareSum += interval * interval;
+        scheduler->intervalMax = interval > scheduler->intervalMax ? interval : scheduler->intervalMax;
+    }
+
+    scheduler->lastFrame = now;
+    scheduler->frames++;
+
+    if(scheduler->pacing == SW_FRAME_PACING_VSYNC)
+    {
+        // The next grid line after now; a frame that took longer than a period skips the lines it missed.
+        scheduler->deadline = scheduler->origin + (floor((now - scheduler->origin) / scheduler->period) + 1.0) * scheduler->period;
+    }
+    else if(scheduler->pacing == SW_FRAME_PACING_FIXED)
+    {
+        // Late frames do not make the next ones come faster to catch up.
+        scheduler->deadline += scheduler->period;
+        scheduler->deadline = scheduler->deadline > now ? scheduler->deadline : now + scheduler->period;
+    }
+
+    return true;
+}
+
+static inline void swGetFramePacingStats(const SWFrameScheduler *scheduler, SWFramePacingStats *stats)
+{
+    double elapsed = swFrameClock() - scheduler->startTime;
+    long long intervals = scheduler->frames > 1 ? scheduler->frames - 1 : 0;
+    double mean = intervals ? scheduler->intervalSum / intervals : 0.0;
+    double variance = intervals ? scheduler->intervalSquareSum / intervals - mean * mean : 0.0;
+
+    stats->frames = scheduler->frames;
+    stats->framesPerSecond = mean > 0.0 ? 1.0 / mean : 0.0;
+    stats->interval = mean;
+    stats->jitter = variance > 0.0 ? sqrt(variance) : 0.0;
+    stats->intervalMax = scheduler->intervalMax;
+    stats->cpuUtilization = elapsed > 0.0 ? (swProcessCpuTime() - scheduler->startCpuTime) / elapsed : 0.0;
+}
+
+// A fixedDelta above 0 makes every frame advance by exactly that many seconds regardless of the clock, for
+// benchmarks and images that have to be reproducible. maxSteps is at least 1.
+static inline void swInitFrameTimer(SWFrameTimer *timer, double step, int maxSteps, double fixedDelta)
+{
+    memset(timer, 0, sizeof(*timer));
+    timer->step = step;
+    timer->fixedDelta = fixedDelta > 0.0 ? fixedDelta : 0.0;
+    timer->maxSteps = maxSteps > 1 ? maxSteps : 1;
+    timer->lastTime = -1.0;
+}
+
+// Called once per rendered frame, returns the number of simulation steps to run before rendering it. The first frame
+// on the clock runs none.
+static inline int swAdvanceFrameTimer(SWFrameTimer *timer)
+{
+    if(timer->fixedDelta > 0.0)
+    {
+        timer->delta = timer->fixedDelta;
+    }
+    else
+    {
+        double now = swFrameClock();
+        timer->delta = timer->lastTime >= 0.0 ? now - timer->lastTime : 0.0;
+        timer->lastTime = now;
+    }
+
+    timer->accumulator += timer->delta;
+    double steps = floor(timer->accumulator / timer->step);
+
+    if(steps > timer->maxSteps)
+    {
+        double dropped = (steps - timer->maxSteps) * timer->step;
+        timer->accumulator -= dropped;
+        timer->droppedTime += dropped;
+        steps = timer->maxSteps;
+    }
+
+    timer->accumulator -= steps * timer->step;
+    timer->accumulator = timer->accumulator > 0.0 ? timer->accumulator : 0.0;
+    timer->alpha = timer->accumulator / timer->step;
+    timer->alpha = timer->alpha < 1.0 ? timer->alpha : 1.0;
+    timer->steps += (long long)steps;
+    return (int)steps;
+}
+
+#endif // SOFTWARE_RENDERER_FRAME_SCHEDULER_H
@@ -0,0 +1,243 @@
+// Geometry stage of the software renderer: model-view-projection transform, clip codes, perspective divide,
+// viewport transform and snapping to the sub-pixel grid, for a whole run of vertices at once.
+//
+// The scalar code is the reference implementation. The AVX2 code transforms 8 vertices per iteration in structure
+// of arrays form and performs the same operations in the same order, so both produce bit-identical results, like
+// the pixel kernels.
+
+#include <math.h>
+#include <string.h>
+
+#include "rasterizer.h"
+
+#ifdef SW_X86
+#include <immintrin.h>
+#endif
+
+#define SW_GEOMETRY_LANES 8 // Vertices transformed per iteration of the AVX2 code.
+
+// Bit mask of the planes a clip space vertex is outside of, see SW_CLIP_PLANES.
+static inline unsigned int clipCode(const SWVertex *vertex, float guardBandX, float guardBandY)
+{
+    unsigned int code = 0;
+    float guardX = guardBandX * vertex->w;
+    float guardY = guardBandY * vertex->w;
+
+    code |= (vertex->x < -guardX) ? 0x01 : 0;
+    code |= (vertex->x > guardX) ? 0x02 : 0;
+    code |= (vertex->y < -guardY) ? 0x04 : 0;
+    code |= (vertex->y > guardY) ? 0x08 : 0;
+    code |= (vertex->z < -vertex->w) ? 0x10 : 0;
+    code |= (vertex->z > vertex->w) ? 0x20 : 0;
+    code |= (vertex->x < -vertex->w) ? 0x40 : 0;
+    code |= (vertex->x > vertex->w) ? 0x80 : 0;
+    code |= (vertex->y < -vertex->w) ? 0x100 : 0;
+    code |= (vertex->y > vertex->w) ? 0x200 : 0;
+    return code;
+}
+
+// Window coordinate snapped to the sub-pixel grid, SW_INVALID_COORDINATE when it is too far outside the
+// framebuffer for the edge functions, or not a number.
+static inline int snapCoordinate(float coordinate)
+{
+    if(!(fabsf(coordinate) < SW_MAX_WINDOW_COORDINATE))
+    {
+        return SW_INVALID_COORDINATE;
+    }
+
+    return (int)floorf(coordinate * SW_SUBPIXEL_SCALE + 0.5f);
+}
+
+void swToWindow(const SWGLContext *context, const SWVertex *vertex, SWScreenVertex *screen)
+{
+    float inverseW = 1.0f / vertex->w;
+    float halfWidth = context->viewportWidth * 0.5f;
+    float halfHeight = context->viewportHeight * 0.5f;
+
+    screen->x = context->viewportX + (vertex->x * inverseW + 1.0f) * halfWidth;
+    screen->y = context->viewportY + (vertex->y * inverseW + 1.0f) * halfHeight;
+    screen->z = (vertex->z * inverseW + 1.0f) * 0.5f;
+    screen->inverseW = inverseW;
+    screen->r = vertex->r;
+    screen->g = vertex->g;
+    screen->b = vertex->b;
+    screen->fixedX = snapCoordinate(screen->x);
+    screen->fixedY = snapCoordinate(screen->y);
+}
+
+static void transformScalar(const SWGLContext *context, const float *m, float guardBandX, float guardBandY,
+    const SWRecordedVertex *source, int count, SWTransformedVertex *output)
+{
+    for(int i = 0; i < count; ++i)
+    {
+        SWVertex *clip = &output[i].clip;
+        clip->x = m[0] * source[i].x + m[4] * source[i].y + m[8] * source[i].z + m[12];
+        clip->y = m[1] * source[i].x + m[5] * source[i].y + m[9] * source[i].z + m[13];
+        clip->z = m[2] * source[i].x + m[6] * source[i].y + m[10] * source[i].z + m[14];
+        clip->w = m[3] * source[i].x + m[7] * source[i].y + m[11] * source[i].z + m[15];
+        clip->r = source[i].r;
+        clip->g = source[i].g;
+        clip->b = source[i].b;
+        output[i].clipCode = clipCode(clip, guardBandX, guardBandY);
+        swToWindow(context, clip, &output[i].window);
+    }
+}
+
+#ifdef SW_X86
+// Sets bit in the lanes of code where mask is set.
+SW_TARGET_AVX2 static inline __m256i addClipBit(__m256i code, __m256 mask, int bit)
+{
+    return _mm256_or_si256(code, _mm256_and_si256(_mm256_castps_si256(mask), _mm256_set1_epi32(bit)));
+}
+
+SW_TARGET_AVX2 static inline __m256i snapCoordinates(__m256 coordinate)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    __m256 valid = _mm256_cmp_ps(_mm256_andnot_ps(signMask, coordinate), _mm256_set1_ps(SW_MAX_WINDOW_COORDINATE), _CMP_LT_OQ);
+    __m256 snapped = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(coordinate, _mm256_set1_ps((float)SW_SUBPIXEL_SCALE)), _mm256_set1_ps(0.5f)));
+    __m256i fixed = _mm256_cvttps_epi32(_mm256_and_ps(snapped, valid));
+    return _mm256_blendv_epi8(_mm256_set1_epi32(SW_INVALID_COORDINATE), fixed, _mm256_castps_si256(valid));
+}
+
+// Turns four attributes of 8 vertices into the four attributes of each vertex.
+SW_TARGET_AVX2 static inline void transpose(__m256 a, __m256 b, __m256 c, __m256 d, __m128 *vertices)
+{
+    __m256 ab0 = _mm256_unpacklo_ps(a, b); // Vertices 0, 1 and 4, 5.
+    __m256 ab1 = _mm256_unpackhi_ps(a, b); // Vertices 2, 3 and 6, 7.
+    __m256 cd0 = _mm256_unpacklo_ps(c, d);
+    __m256 cd1 = _mm256_unpackhi_ps(c, d);
+    __m256 vertices04 = _mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 vertices15 = _mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 vertices26 = _mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 vertices37 = _mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(3, 2, 3, 2));
+    vertices[0] = _mm256_castps256_ps128(vertices04);
+    vertices[1] = _mm256_castps256_ps128(vertices15);
+    vertices[2] = _mm256_castps256_ps128(vertices26);
+    vertices[3] = _mm256_castps256_ps128(vertices37);
+    vertices[4] = _mm256_extractf128_ps(vertices04, 1);
+    vertices[5] = _mm256_extractf128_ps(vertices15, 1);
+    vertices[6] = _mm256_extractf128_ps(vertices26, 1);
+    vertices[7] = _mm256_extractf128_ps(vertices37, 1);
+}
+
+SW_TARGET_AVX2 static int transformAVX2(const SWGLContext *context, const float *m, float guardBandX, float guardBandY,
+    const SWRecordedVertex *source, int count, SWTransformedVertex *output)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256i stride = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42); // Floats between recorded vertices.
+    const __m256 viewportX = _mm256_set1_ps((float)context->viewportX);
+    const __m256 viewportY = _mm256_set1_ps((float)context->viewportY);
+    const __m256 halfWidth = _mm256_set1_ps(context->viewportWidth * 0.5f);
+    const __m256 halfHeight = _mm256_set1_ps(context->viewportHeight * 0.5f);
+    const __m256 bandX = _mm256_set1_ps(guardBandX);
+    const __m256 bandY = _mm256_set1_ps(guardBandY);
+
+    __m256 matrix[16];
+
+    for(int i = 0; i < 16; ++i)
+    {
+        matrix[i] = _mm256_set1_ps(m[i]);
+    }
+
+    alignas(32) int fixed[2][SW_GEOMETRY_LANES];
+    alignas(32) unsigned int codes[SW_GEOMETRY_LANES];
+    int blockEnd = count - count % SW_GEOMETRY_LANES;
+
+    for(int first = 0; first < blockEnd; first += SW_GEOMETRY_LANES)
+    {
+        const float *base = &source[first].x;
+        __m256 x = _mm256_i32gather_ps(base, stride, 4);
+        __m256 y = _mm256_i32gather_ps(base + 1, stride, 4);
+        __m256 z = _mm256_i32gather_ps(base + 2, stride, 4);
+
+        __m256 clip[4];
+
+        for(int row = 0; row < 4; ++row)
+        {
+            clip[row] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(matrix[row], x),
+                _mm256_mul_ps(matrix[4 + row], y)),
+                _mm256_mul_ps(matrix[8 + row], z)),
+                matrix[12 + row]);
+        }
+
+        __m256 w = clip[3];
+        __m256 guardX = _mm256_mul_ps(bandX, w);
+        __m256 guardY = _mm256_mul_ps(bandY, w);
+        __m256 negativeW = _mm256_xor_ps(w, signMask);
+        __m256i code = _mm256_setzero_si256();
+        code = addClipBit(code, _mm256_cmp_ps(clip[0], _mm256_xor_ps(guardX, signMask), _CMP_LT_OQ), 0x01);
+        code = addClipBit(code, _mm256_cmp_ps(clip[0], guardX, _CMP_GT_OQ), 0x02);
+        code = addClipBit(code, _mm256_cmp_ps(clip[1], _mm256_xor_ps(guardY, signMask), _CMP_LT_OQ), 0x04);
+        code = addClipBit(code, _mm256_cmp_ps(clip[1], guardY, _CMP_GT_OQ), 0x08);
+        code = addClipBit(code, _mm256_cmp_ps(clip[2], negativeW, _CMP_LT_OQ), 0x10);
+        code = addClipBit(code, _mm256_cmp_ps(clip[2], w, _CMP_GT_OQ), 0x20);
+        code = addClipBit(code, _mm256_cmp_ps(clip[0], negativeW, _CMP_LT_OQ), 0x40);
+        code = addClipBit(code, _mm256_cmp_ps(clip[0], w, _CMP_GT_OQ), 0x80);
+        code = addClipBit(code, _mm256_cmp_ps(clip[1], negativeW, _CMP_LT_OQ), 0x100);
+        code = addClipBit(code, _mm256_cmp_ps(clip[1], w, _CMP_GT_OQ), 0x200);
+
+        // A true division rather than an approximate reciprocal keeps the result identical to the scalar code.
+        __m256 inverseW = _mm256_div_ps(one, w);
+        __m256 windowX = _mm256_add_ps(viewportX, _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(clip[0], inverseW), one), halfWidth));
+        __m256 windowY = _mm256_add_ps(viewportY, _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(clip[1], inverseW), one), halfHeight));
+        __m256 windowZ = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(clip[2], inverseW), one), half);
+
+        __m128 clipVertices[SW_GEOMETRY_LANES];
+        __m128 windowVertices[SW_GEOMETRY_LANES];
+        transpose(clip[0], clip[1], clip[2], w, clipVertices);
+        transpose(windowX, windowY, windowZ, inverseW, windowVertices);
+        _mm256_store_si256((__m256i *)fixed[0], snapCoordinates(windowX));
+        _mm256_store_si256((__m256i *)fixed[1], snapCoordinates(windowY));
+        _mm256_store_si256((__m256i *)codes, code);
+
+        // Back to one structure per vertex for clipping and setup.
+        for(int lane = 0; lane < SW_GEOMETRY_LANES; ++lane)
+        {
+            const SWRecordedVertex *vertex = &source[first + lane];
+            SWTransformedVertex *transformed = &output[first + lane];
+            _mm_storeu_ps(&transformed->clip.x, clipVertices[lane]);
+            _mm_storeu_ps(&transformed->window.x, windowVertices[lane]);
+            memcpy(&transformed->clip.r, &vertex->r, 3 * sizeof(float));
+            memcpy(&transformed->window.r, &vertex->r, 3 * sizeof(float));
+            transformed->window.fixedX = fixed[0][lane];
+            transformed->window.fixedY = fixed[1][lane];
+            transformed->clipCode = codes[lane];
+        }
+    }
+
+    return blockEnd;
+}
+#endif
+
+void swTransformVertices(SWGLContext *context, const float *m, float guardBandX, float guardBandY, const SWRecordedVertex *source, int count, SWTransformedVertex *output)
+{
+    int transformed = 0;
+
+#ifdef SW_X86
+    if(swglGetInstructionSet() == SWGL_INSTRUCTION_SET_AVX2)
+    {
+        transformed = transformAVX2(context, m, guardBandX, guardBandY, source, count, output);
+
+        // Compares every vertex with the scalar reference, see swglSetKernelValidation().
+        if(swValidateKernels)
+        {
+            for(int i = 0; i < transformed; ++i)
+            {
+                SWTransformedVertex reference;
+                transformScalar(context, m, guardBandX, guardBandY, &source[i], 1, &reference);
+
+                if(memcmp(&reference, &output[i], sizeof(SWTransformedVertex)))
+                {
+                    context->stats.kernelMismatches++;
+                }
+            }
+        }
+    }
+#endif
+
+    // Vertices left over from the vector code.
+    transformScalar(context, m, guardBandX, guardBandY, source + transformed, count - transformed, output + transformed);
+}
@@ -0,0 +1,416 @@
+// Headless frame loop and image output of the software renderer.
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "context.h"
+#include "frameScheduler.h"
+
+int swglWriteFrontBuffer(const char *fileName)
+{
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    const unsigned int *pixels = swglGetFrontBuffer(&width, &height, &stride);
+
+    if(!pixels || !fileName)
+    {
+        return FALSE;
+    }
+
+    FILE *file = fopen(fileName, "wb");
+
+    if(!file)
+    {
+        return FALSE;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+    unsigned char *row = (unsigned char *)malloc((size_t)width * 3);
+    bool written = row != NULL;
+
+    // PPM rows go top to bottom, the framebuffer is stored bottom-up.
+    for(int y = height - 1; y >= 0 && written; --y)
+    {
+        const unsigned int *source = pixels + (size_t)y * stride;
+
+        for(int x = 0; x < width; ++x)
+        {
+            row[x * 3] = (unsigned char)(source[x] >> 16);
+            row[x * 3 + 1] = (unsigned char)(source[x] >> 8);
+            row[x * 3 + 2] = (unsigned char)source[x];
+        }
+
+        written = fwrite(row, 3, width, file) == (size_t)width;
+    }
+
+    free(row);
+    return (fclose(file) == 0 && written) ? TRUE : FALSE;
+}
+
+int swglRunHeadless(int argc, char *argv[], int width, int height,
+    GLvoid (*resizeScene)(GLsizei, GLsizei), int (*initScene)(GLvoid), int (*drawScene)(GLvoid))
+{
+    int frameCount = 1000;
+    const char *outputFileName = NULL;
+    GLenum perspectiveHint = GL_DONT_CARE; // GL_DONT_CARE keeps the hint set by the sample.
+    bool overrideCullFace = false;
+    GLenum cullFaceMode = 0; // 0 disables face culling when overriding it.
+    int pacing = SW_FRAME_PACING_UNCAPPED;
+    double frameRate = 60.0; // Also the refresh rate emulated by vsync pacing.
+    bool reportPacing = false;
+    int queueDepth = 0;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-frames") && i + 1 < argc)
+        {
+            frameCount = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-size") && i + 1 < argc)
+        {
+            if(sscanf(argv[++i], "%dx%d", &width, &height) != 2)
+            {
+                fprintf(stderr, "Invalid size '%s', expected <width>x<height>.\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-output") && i + 1 < argc)
+        {
+            outputFileName = argv[++i];
+        }
+        else if(!strcmp(argv[i], "-isa") && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+            int instructionSet = SWGL_INSTRUCTION_SET_SCALAR;
+
+            while(swglGetInstructionSetName(instructionSet) && strcmp(swglGetInstructionSetName(instructionSet), name))
+            {
+                instructionSet++;
+            }
+
+            if(!swglSetInstructionSet(instructionSet))
+            {
+                fprintf(stderr, "Instruction set '%s' is not supported on this CPU.\n", name);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-threads") && i + 1 < argc)
+        {
+            if(!swglSetThreadCount(atoi(argv[++i])))
+            {
+                fprintf(stderr, "Invalid thread count '%s'.\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-hint") && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+
+            if(!strcmp(name, "fastest"))
+            {
+                perspectiveHint = GL_FASTEST;
+            }
+            else if(!strcmp(name, "nicest"))
+            {
+                perspectiveHint = GL_NICEST;
+            }
+            else
+            {
+                fprintf(stderr, "Invalid hint '%s', expected fastest or nicest.\n", name);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-quads") && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+
+            if(!strcmp(name, "native") || !strcmp(name, "split"))
+            {
+                swglSetNativeQuads(!strcmp(name, "native"));
+            }
+            else
+            {
+                fprintf(stderr, "Invalid quad setup '%s', expected native or split.\n", name);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-clip") && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+
+            if(!strcmp(name, "guardband") || !strcmp(name, "frustum"))
+            {
+                swglSetGuardBand(!strcmp(name, "guardband"));
+            }
+            else
+            {
+                fprintf(stderr, "Invalid clipping '%s', expected guardband or frustum.\n", name);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-vertices") && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+
+            if(!strcmp(name, "batched") || !strcmp(name, "immediate"))
+            {
+                swglSetVertexBatching(!strcmp(name, "batched"));
+            }
+            else
+            {
+                fprintf(stderr, "Invalid vertex processing '%s', expected batched or immediate.\n", name);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-vertexcache") && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+
+            if(!strcmp(name, "on") || !strcmp(name, "off"))
+            {
+                swglSetVertexCache(!strcmp(name, "on"));
+            }
+            else
+            {
+                fprintf(stderr, "Invalid vertex cache '%s', expected on or off.\n", name);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-drawcache") && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+
+            if(!strcmp(name, "on") || !strcmp(name, "off"))
+            {
+                swglSetDrawCache(!strcmp(name, "on"));
+            }
+            else
+            {
+                fprintf(stderr, "Invalid draw cache '%s', expected on or off.\n", name);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-instancecull") && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+
+            if(!strcmp(name, "none") || !strcmp(name, "spheres") || !strcmp(name, "groups"))
+            {
+                swglSetInstanceCulling(!strcmp(name, "none") ? SWGL_INSTANCE_CULLING_NONE
+                    : !strcmp(name, "spheres") ? SWGL_INSTANCE_CULLING_SPHERES : SWGL_INSTANCE_CULLING_GROUPS);
+            }
+            else
+            {
+                fprintf(stderr, "Invalid instance culling '%s', expected none, spheres or groups.\n", name);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-cull") && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+            overrideCullFace = true;
+
+            if(!strcmp(name, "front"))
+            {
+                cullFaceMode = GL_FRONT;
+            }
+            else if(!strcmp(name, "back"))
+            {
+                cullFaceMode = GL_BACK;
+            }
+            else if(strcmp(name, "none"))
+            {
+                fprintf(stderr, "Invalid face culling '%s', expected front, back or none.\n", name);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-fps") && i + 1 < argc)
+        {
+            if(!swParseFramePacing(argv[++i], &pacing, &frameRate))
+            {
+                fprintf(stderr, "Invalid frame rate '%s', expected a number of frames per second, uncapped or vsync.\n", argv[i]);
+                return 1;
+            }
+
+            reportPacing = true;
+        }
+        else if(!strcmp(argv[i], "-queue") && i + 1 < argc)
+        {
+            queueDepth = atoi(argv[++i]);
+
+            if(!swglSetFrameQueueDepth(queueDepth))
+            {
+                fprintf(stderr, "Invalid frame queue depth '%s', expected 0 to 3.\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-damage") && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+
+            if(!strcmp(name, "on") || !strcmp(name, "off"))
+            {
+                swglSetDamageTracking(!strcmp(name, "on"));
+            }
+            else
+            {
+                fprintf(stderr, "Invalid damage tracking '%s', expected on or off.\n", name);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-validate"))
+        {
+            swglSetKernelValidation(TRUE);
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-frames <count>] [-size <width>x<height>] [-output <file.ppm>] [-isa <scalar|sse4.1|avx2>] [-validate] [-threads <count>] [-hint <fastest|nicest>] [-quads <native|split>] [-cull <front|back|none>] [-clip <guardband|frustum>] [-vertices <batched|immediate>] [-vertexcache <on|off>] [-drawcache <on|off>] [-instancecull <none|spheres|groups>] [-fps <rate|uncapped|vsync>] [-queue <depth>] [-damage <on|off>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    HSWGLRC context = swglCreateContext(width, height);
+
+    if(!context)
+    {
+        fprintf(stderr, "Failed to create software rendering context.\n");
+        return 1;
+    }
+
+    swglMakeCurrent(context);
+    resizeScene(width, height); // Setup perspective view.
+
+    if(!initScene())
+    {
+        fprintf(stderr, "Initialization failed.\n");
+        swglDeleteContext(context);
+        return 1;
+    }
+
+    if(perspectiveHint != GL_DONT_CARE)
+    {
+        glHint(GL_PERSPECTIVE_CORRECTION_HINT, perspectiveHint);
+    }
+
+    if(overrideCullFace && cullFaceMode)
+    {
+        glCullFace(cullFaceMode);
+        glEnable(GL_CULL_FACE);
+    }
+    else if(overrideCullFace)
+    {
+        glDisable(GL_CULL_FACE);
+    }
+
+    int result = 0;
+    SWGLFrameStats totals;
+    memset(&totals, 0, sizeof(totals));
+
+    SWFrameScheduler scheduler;
+    swInitFrameScheduler(&scheduler, pacing, frameRate);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for(int frame = 0; frame < frameCount; ++frame)
+    {
+        swWaitForFrame(&scheduler);
+        drawScene();
+        swglSwapBuffers();
+
+        SWGLFrameStats stats;
+        swglGetFrameStats(&stats);
+        totals.primitivesSubmitted += stats.primitivesSubmitted;
+        totals.primitivesCulled += stats.primitivesCulled;
+        totals.trianglesClipped += stats.trianglesClipped;
+        totals.trianglesRasterized += stats.trianglesRasterized;
+        totals.quadsRasterized += stats.quadsRasterized;
+        totals.fragmentsTested += stats.fragmentsTested;
+        totals.fragmentsWritten += stats.fragmentsWritten;
+        totals.fragmentsHiZRejected += stats.fragmentsHiZRejected;
+        totals.fragmentsHiZAccepted += stats.fragmentsHiZAccepted;
+        totals.fragmentsFlatColor += stats.fragmentsFlatColor;
+        totals.kernelMismatches += stats.kernelMismatches;
+        totals.objectsVisible += stats.objectsVisible;
+        totals.objectsCulled += stats.objectsCulled;
+        totals.vertexCacheLookups += stats.vertexCacheLookups;
+        totals.vertexCacheHits += stats.vertexCacheHits;
+        totals.drawCacheLookups += stats.drawCacheLookups;
+        totals.drawCacheHits += stats.drawCacheHits;
+        totals.framesQueued += stats.framesQueued;
+        totals.queueStallMicroseconds += stats.queueStallMicroseconds;
+        totals.framesSkipped += stats.framesSkipped;
+        totals.pixelsRendered += stats.pixelsRendered;
+    }
+
+    glFinish(); // The time includes rendering the frames still queued.
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double frames = frameCount > 0 ? (double)frameCount : 1.0;
+
+    // The statistics of the frames left queued by the last swaps are never reported, see swglGetFrameStats().
+    double reportedFrames = frameCount - queueDepth > 0 ? (double)(frameCount - queueDepth) : 1.0;
+
+    printf("Rendered %d frames at %dx%d with the %s rasterizer on %d threads in %.3f s, %.1f frames/s, %.3f ms/frame.\n",
+        frameCount, width, height, swglGetInstructionSetName(swglGetInstructionSet()), swglGetThreadCount(), seconds, frameCount / (seconds > 0.0 ? seconds : 1.0), seconds * 1000.0 / frames);
+    printf("Per frame: %.1f primitives, %.1f culled, %.1f triangles clipped, %.1f triangles and %.1f quads rasterized, %.0f fragments tested, %.0f fragments written, %.0f of them flat color.\n",
+        totals.primitivesSubmitted / reportedFrames, totals.primitivesCulled / reportedFrames, totals.trianglesClipped / reportedFrames, totals.trianglesRasterized / reportedFrames, totals.quadsRasterized / reportedFrames,
+        totals.fragmentsTested / reportedFrames, totals.fragmentsWritten / reportedFrames, totals.fragmentsFlatColor / reportedFrames);
+    printf("Fill rate: %.1f million fragments written per second.\n", totals.fragmentsWritten / (seconds > 0.0 ? seconds : 1.0) / 1000000.0);
+    printf("Hierarchical-Z per frame: %.0f fragments rejected, %.0f fragments accepted without a depth comparison.\n",
+        totals.fragmentsHiZRejected / reportedFrames, totals.fragmentsHiZAccepted / reportedFrames);
+
+    if(totals.objectsVisible || totals.objectsCulled)
+    {
+        printf("Instances per frame: %.1f visible, %.1f culled by the view frustum.\n", totals.objectsVisible / reportedFrames, totals.objectsCulled / reportedFrames);
+    }
+
+    if(totals.vertexCacheLookups)
+    {
+        printf("Vertex cache per frame: %.0f indices, %.1f%% of them hits.\n", totals.vertexCacheLookups / reportedFrames,
+            100.0 * totals.vertexCacheHits / totals.vertexCacheLookups);
+    }
+
+    if(totals.drawCacheLookups)
+    {
+        printf("Draw cache per frame: %.1f draws, %.1f%% of them replayed.\n", totals.drawCacheLookups / reportedFrames,
+            100.0 * totals.drawCacheHits / totals.drawCacheLookups);
+    }
+
+    if(totals.framesQueued || totals.queueStallMicroseconds)
+    {
+        printf("Frame queue: %.2f frames queued ahead on average, %.3f ms per frame waiting for them.\n",
+            totals.framesQueued / reportedFrames, totals.queueStallMicroseconds / 1000.0 / reportedFrames);
+    }
+
+    printf("Damage tracking: %llu frames skipped, %.0f pixels rendered per frame, %.1f%% of the framebuffer.\n",
+        totals.framesSkipped, totals.pixelsRendered / reportedFrames, 100.0 * totals.pixelsRendered / reportedFrames / ((double)width * height));
+
+    if(reportPacing)
+    {
+        SWFramePacingStats pacingStats;
+        swGetFramePacingStats(&scheduler, &pacingStats);
+        printf("Frame pacing: %.1f frames/s, %.3f ms +- %.3f ms between frames, at most %.3f ms, %.1f%% CPU.\n",
+            pacingStats.framesPerSecond, pacingStats.interval * 1000.0, pacingStats.jitter * 1000.0, pacingStats.intervalMax * 1000.0,
+            pacingStats.cpuUtilization * 100.0);
+    }
+
+    swDestroyFrameScheduler(&scheduler);
+
+    if(totals.kernelMismatches)
+    {
+        fprintf(stderr, "Kernel validation failed: %llu blocks, vertices or culling decisions differ from the scalar reference.\n", totals.kernelMismatches);
+        result = 1;
+    }
+
+    if(outputFileName && !swglWriteFrontBuffer(outputFileName))
+    {
+        fprintf(stderr, "Failed to write '%s'.\n", outputFileName);
+        result = 1;
+    }
+
+    swglDeleteContext(context);
+    return result;
+}
@@ -0,0 +1,103 @@
+// Read-only memory mapping of whole files, for the scene and mesh loaders of the software renderer.
+
+#include "context.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool swMapFile(const char *fileName, SWMappedFile *file)
+{
+    file->data = NULL;
+    file->size = 0;
+    file->mapping = NULL;
+
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER fileSize;
+
+    if(handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    if(!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0 || (unsigned long long)fileSize.QuadPart > (size_t)-1)
+    {
+        CloseHandle(handle);
+        return false;
+    }
+
+    // The mapping keeps the file open.
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+
+    if(!mapping)
+    {
+        return false;
+    }
+
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if(!data)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    file->mapping = mapping;
+    file->size = (size_t)fileSize.QuadPart;
+#else
+    int handle = open(fileName, O_RDONLY);
+    struct stat status;
+
+    if(handle < 0)
+    {
+        return false;
+    }
+
+    if(fstat(handle, &status) != 0 || status.st_size <= 0)
+    {
+        close(handle);
+        return false;
+    }
+
+    // The mapping keeps the file open.
+    void *data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+    close(handle);
+
+    if(data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    file->size = (size_t)status.st_size;
+#endif
+
+    file->data = (const unsigned char *)data;
+    return true;
+}
+
+void swUnmapFile(SWMappedFile *file)
+{
+    if(!file->data)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(file->data);
+    CloseHandle((HANDLE)file->mapping);
+#else
+    munmap((void *)file->data, file->size);
+#endif
+
+    file->data = NULL;
+    file->size = 0;
+    file->mapping = NULL;
+}
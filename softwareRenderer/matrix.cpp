@@ -0,0 +1,364 @@
+// Model-view and projection matrices of the software renderer.
+
+#include <math.h>
+#include <string.h>
+
+#include "context.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SW_SSE2 1
+#endif
+
+void swMatrixIdentity(float *matrix)
+{
+    memset(matrix, 0, 16 * sizeof(float));
+    matrix[0] = 1.0f;
+    matrix[5] = 1.0f;
+    matrix[10] = 1.0f;
+    matrix[15] = 1.0f;
+}
+
+void swMatrixMultiply(float *result, const float *a, const float *b)
+{
+#if defined(SW_SSE2)
+    // Each column of the product sums the columns of a in the same order as the scalar code. All of b is read
+    // before result is written, which allows result to alias a or b.
+    __m128 a0 = _mm_load_ps(a);
+    __m128 a1 = _mm_load_ps(a + 4);
+    __m128 a2 = _mm_load_ps(a + 8);
+    __m128 a3 = _mm_load_ps(a + 12);
+    __m128 product[4];
+
+    for(int column = 0; column < 4; ++column)
+    {
+        const float *factors = b + column * 4;
+        product[column] = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(a0, _mm_set1_ps(factors[0])),
+            _mm_mul_ps(a1, _mm_set1_ps(factors[1]))),
+            _mm_mul_ps(a2, _mm_set1_ps(factors[2]))),
+            _mm_mul_ps(a3, _mm_set1_ps(factors[3])));
+    }
+
+    for(int column = 0; column < 4; ++column)
+    {
+        _mm_store_ps(result + column * 4, product[column]);
+    }
+#else
+    float product[16]; // Allows result to alias a or b.
+
+    for(int column = 0; column < 4; ++column)
+    {
+        for(int row = 0; row < 4; ++row)
+        {
+            product[column * 4 + row] = a[row] * b[column * 4]
+                + a[4 + row] * b[column * 4 + 1]
+                + a[8 + row] * b[column * 4 + 2]
+                + a[12 + row] * b[column * 4 + 3];
+        }
+    }
+
+    memcpy(result, product, sizeof(product));
+#endif
+}
+
+// Multiplies matrix by a rotation in the plane of two of its axes: first becomes first * c + second * s and second
+// becomes second * c - first * s. The other two columns stay as they are.
+static void rotateColumns(float *matrix, int first, int second, float c, float s)
+{
+    float *a = matrix + first * 4;
+    float *b = matrix + second * 4;
+
+#if defined(SW_SSE2)
+    __m128 columnA = _mm_load_ps(a);
+    __m128 columnB = _mm_load_ps(b);
+    __m128 cosine = _mm_set1_ps(c);
+    __m128 sine = _mm_set1_ps(s);
+    _mm_store_ps(a, _mm_add_ps(_mm_mul_ps(columnA, cosine), _mm_mul_ps(columnB, sine)));
+    _mm_store_ps(b, _mm_sub_ps(_mm_mul_ps(columnB, cosine), _mm_mul_ps(columnA, sine)));
+#else
+    for(int row = 0; row < 4; ++row)
+    {
+        float valueA = a[row];
+        float valueB = b[row];
+        a[row] = valueA * c + valueB * s;
+        b[row] = valueB * c - valueA * s;
+    }
+#endif
+}
+
+void swMatrixTranslate(float *matrix, float x, float y, float z)
+{
+    // Only the last column changes when multiplying by a translation.
+#if defined(SW_SSE2)
+    __m128 offset = _mm_add_ps(_mm_add_ps(
+        _mm_mul_ps(_mm_load_ps(matrix), _mm_set1_ps(x)),
+        _mm_mul_ps(_mm_load_ps(matrix + 4), _mm_set1_ps(y))),
+        _mm_mul_ps(_mm_load_ps(matrix + 8), _mm_set1_ps(z)));
+    _mm_store_ps(matrix + 12, _mm_add_ps(_mm_load_ps(matrix + 12), offset));
+#else
+    for(int row = 0; row < 4; ++row)
+    {
+        matrix[12 + row] += matrix[row] * x + matrix[4 + row] * y + matrix[8 + row] * z;
+    }
+#endif
+}
+
+void swMatrixRotate(float *matrix, float angle, float x, float y, float z)
+{
+    float length = sqrtf(x * x + y * y + z * z);
+
+    if(length == 0.0f)
+    {
+        return;
+    }
+
+    float radians = angle * (3.14159265358979323846f / 180.0f);
+    float c = cosf(radians);
+    float s = sinf(radians);
+
+    // Rotations about a coordinate axis, like those of the samples, only mix two columns.
+    if(y == 0.0f && z == 0.0f)
+    {
+        rotateColumns(matrix, 1, 2, c, x > 0.0f ? s : -s);
+        return;
+    }
+
+    if(x == 0.0f && z == 0.0f)
+    {
+        rotateColumns(matrix, 2, 0, c, y > 0.0f ? s : -s);
+        return;
+    }
+
+    if(x == 0.0f && y == 0.0f)
+    {
+        rotateColumns(matrix, 0, 1, c, z > 0.0f ? s : -s);
+        return;
+    }
+
+    x /= length;
+    y /= length;
+    z /= length;
+
+    float t = 1.0f - c;
+
+    alignas(16) float rotation[16] = {
+        x * x * t + c, y * x * t + z * s, x * z * t - y * s, 0.0f,
+        x * y * t - z * s, y * y * t + c, y * z * t + x * s, 0.0f,
+        x * z * t + y * s, y * z * t - x * s, z * z * t + c, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+
+    swMatrixMultiply(matrix, matrix, rotation);
+}
+
+const float *swGetModelviewProjection(SWGLContext *context)
+{
+    if(context->modelviewProjectionDirty)
+    {
+        swMatrixMultiply(context->modelviewProjection, context->projection, context->modelview);
+        context->modelviewProjectionDirty = false;
+    }
+
+    return context->modelviewProjection;
+}
+
+// Returns the matrix selected by glMatrixMode(), or NULL if it can not be changed right now.
+static float *currentMatrix(SWGLContext *context)
+{
+    if(!context)
+    {
+        return NULL;
+    }
+
+    if(context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return NULL;
+    }
+
+    swFlushVertices(context); // Recorded vertices use the matrices as they were.
+    context->modelviewProjectionDirty = true;
+    return context->matrixMode == GL_PROJECTION ? context->projection : context->modelview;
+}
+
+GLvoid glMatrixMode(GLenum mode)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(context->listBuilder && !swCompileCommand(context, SW_LIST_MATRIX_MODE, mode, 0.0, 0.0, 0.0))
+    {
+        return;
+    }
+
+    if(mode != GL_MODELVIEW && mode != GL_PROJECTION)
+    {
+        swSetError(context, GL_INVALID_ENUM);
+        return;
+    }
+
+    context->matrixMode = mode;
+}
+
+GLvoid glLoadIdentity(GLvoid)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(context && context->listBuilder && !swCompileCommand(context, SW_LIST_LOAD_IDENTITY, 0.0, 0.0, 0.0, 0.0))
+    {
+        return;
+    }
+
+    float *matrix = currentMatrix(context);
+
+    if(matrix)
+    {
+        swMatrixIdentity(matrix);
+    }
+}
+
+GLvoid glPushMatrix(GLvoid)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(context->listBuilder && !swCompileCommand(context, SW_LIST_PUSH_MATRIX, 0.0, 0.0, 0.0, 0.0))
+    {
+        return;
+    }
+
+    if(context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return;
+    }
+
+    bool projection = context->matrixMode == GL_PROJECTION;
+    int *depth = projection ? &context->projectionStackDepth : &context->modelviewStackDepth;
+
+    if(*depth == (projection ? SW_PROJECTION_STACK_DEPTH : SW_MODELVIEW_STACK_DEPTH) - 1)
+    {
+        swSetError(context, GL_STACK_OVERFLOW);
+        return;
+    }
+
+    // The current matrix does not change, neither does the combined one.
+    float *saved = projection ? context->projectionStack[*depth] : context->modelviewStack[*depth];
+    memcpy(saved, projection ? context->projection : context->modelview, 16 * sizeof(float));
+    ++*depth;
+}
+
+GLvoid glPopMatrix(GLvoid)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(context->listBuilder && !swCompileCommand(context, SW_LIST_POP_MATRIX, 0.0, 0.0, 0.0, 0.0))
+    {
+        return;
+    }
+
+    if(context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return;
+    }
+
+    bool projection = context->matrixMode == GL_PROJECTION;
+    int *depth = projection ? &context->projectionStackDepth : &context->modelviewStackDepth;
+
+    if(*depth == 0)
+    {
+        swSetError(context, GL_STACK_UNDERFLOW);
+        return;
+    }
+
+    float *matrix = currentMatrix(context);
+    --*depth;
+    memcpy(matrix, projection ? context->projectionStack[*depth] : context->modelviewStack[*depth], 16 * sizeof(float));
+}
+
+GLvoid glTranslatef(GLfloat x, GLfloat y, GLfloat z)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(context && context->listBuilder && !swCompileCommand(context, SW_LIST_TRANSLATE, x, y, z, 0.0))
+    {
+        return;
+    }
+
+    float *matrix = currentMatrix(context);
+
+    if(matrix)
+    {
+        swMatrixTranslate(matrix, x, y, z);
+    }
+}
+
+GLvoid glRotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(context && context->listBuilder && !swCompileCommand(context, SW_LIST_ROTATE, angle, x, y, z))
+    {
+        return;
+    }
+
+    float *matrix = currentMatrix(context);
+
+    if(matrix)
+    {
+        swMatrixRotate(matrix, angle, x, y, z);
+    }
+}
+
+GLvoid gluPerspective(GLdouble fovy, GLdouble aspect, GLdouble zNear, GLdouble zFar)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(context && context->listBuilder && !swCompileCommand(context, SW_LIST_PERSPECTIVE, fovy, aspect, zNear, zFar))
+    {
+        return;
+    }
+
+    float *matrix = currentMatrix(context);
+
+    if(!matrix)
+    {
+        return;
+    }
+
+    double radians = fovy * 0.5 * (3.14159265358979323846 / 180.0);
+    double depth = zFar - zNear;
+    double sine = sin(radians);
+
+    // Same degenerate cases as the reference GLU implementation.
+    if(depth == 0.0 || sine == 0.0 || aspect == 0.0)
+    {
+        return;
+    }
+
+    double cotangent = cos(radians) / sine;
+
+    alignas(16) float perspective[16] = {0.0f};
+    perspective[0] = (float)(cotangent / aspect);
+    perspective[5] = (float)cotangent;
+    perspective[10] = (float)(-(zFar + zNear) / depth);
+    perspective[11] = -1.0f;
+    perspective[14] = (float)(-2.0 * zNear * zFar / depth);
+
+    swMatrixMultiply(matrix, matrix, perspective);
+}
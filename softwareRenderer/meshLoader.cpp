@@ -0,0 +1,1174 @@
+// OBJ and PLY mesh loading of the software renderer, see swglLoadMesh().
+//
+// The file is mapped into memory and parsed in place: lines are never copied, and numbers are read by a hand-written
+// parser that converts 8 digits at a time with integer arithmetic. Text is split into chunks of whole lines that are
+// parsed in parallel on the worker threads of the renderer. A first pass counts the vertices (OBJ) or lines (ASCII
+// PLY) of every chunk, so the second pass writes vertices straight to their place in the vertex buffer. Faces, whose
+// number of indices is only known after parsing, are gathered per chunk and copied together at the end.
+//
+// Only positions, vertex colors and faces are read. Faces with more than 3 vertices are split into a fan of
+// triangles; texture coordinates, normals, groups and materials are skipped.
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+#include <vector>
+
+#include "context.h"
+#include "threadPool.h"
+
+#define SW_MESH_CHUNK_SIZE (1 << 20) // Bytes of text per chunk, chunks end at the first line break after this.
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define SW_MESH_SWAR 0 // The 8 digit conversion and binary PLY expect little-endian loads.
+#else
+#define SW_MESH_SWAR 1
+#endif
+
+struct SWGLMesh
+{
+    std::vector<SWRecordedVertex> vertices;
+    std::vector<unsigned int> indices; // Triangles.
+    bool colors; // Whether the file has vertex colors, otherwise the current color is used.
+};
+
+// Text between begin and end, parsed by one task.
+struct SWMeshChunk
+{
+    const unsigned char *begin;
+    const unsigned char *end;
+    size_t count; // Vertices (OBJ) or lines (PLY) in the chunk, from the first pass.
+    size_t first; // Vertices or lines in the chunks before this one.
+    size_t colors; // Vertices with a color.
+    std::vector<unsigned int> indices;
+    bool failed;
+};
+
+// Parse state shared by the tasks of one file.
+struct SWMeshParse
+{
+    const struct SWPlyFormat *ply; // NULL for OBJ.
+    SWMeshChunk *chunks;
+    SWRecordedVertex *vertices;
+    size_t vertexCount;
+    unsigned int *indices;
+};
+
+static void parsePlyChunk(SWMeshParse *parse, SWMeshChunk *chunk);
+
+static const double swPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isDigit(unsigned char c)
+{
+    return (unsigned char)(c - '0') < 10;
+}
+
+// Spaces between the values of a line, the carriage return of Windows line breaks included.
+static inline bool isBlank(unsigned char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const unsigned char *skipBlanks(const unsigned char *p, const unsigned char *end)
+{
+    while(p < end && isBlank(*p))
+    {
+        ++p;
+    }
+
+    return p;
+}
+
+// Start of the line after the one p is in.
+static inline const unsigned char *nextLine(const unsigned char *p, const unsigned char *end)
+{
+    const unsigned char *lineBreak = (const unsigned char *)memchr(p, '\n', end - p);
+    return lineBreak ? lineBreak + 1 : end;
+}
+
+// Index of the lowest set bit of a nonzero value.
+static inline int lowestBit(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+// Converts the run of up to 8 ASCII digits at p with integer arithmetic on the 8 bytes at p, which must all be
+// readable. Returns the number of digits.
+static inline int parseDigits(const unsigned char *p, uint64_t *value)
+{
+#if SW_MESH_SWAR
+    uint64_t chunk;
+    memcpy(&chunk, p, sizeof(chunk));
+
+    // A byte is a digit when it is below 10 after subtracting '0'; adding 0x76 sets the high bit of the others.
+    uint64_t digitValues = chunk - 0x3030303030303030ull;
+    uint64_t others = (digitValues | (digitValues + 0x7676767676767676ull)) & 0x8080808080808080ull;
+    int count = others ? lowestBit(others) >> 3 : 8;
+
+    if(count == 0)
+    {
+        return 0;
+    }
+
+    // Move the digits to the high bytes, after zeros, so they convert like an 8 digit number.
+    chunk = count == 8 ? digitValues : (digitValues << (64 - count * 8));
+
+    // Combine neighbouring digits into 2, 4 and finally 8 digit numbers.
+    chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFull;
+    chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFull;
+    *value = (chunk * 10000 + (chunk >> 32)) & 0xFFFFFFFFull;
+    return count;
+#else
+    int count = 0;
+    *value = 0;
+
+    while(count < 8 && isDigit(p[count]))
+    {
+        *value = *value * 10 + (p[count++] - '0');
+    }
+
+    return count;
+#endif
+}
+
+// Converts the digits at *cursor into *mantissa, at most 19 of them in total, and moves the cursor past them.
+static inline int parseMantissa(const unsigned char **cursor, const unsigned char *end, uint64_t *mantissa, int digits)
+{
+    static const uint64_t scales[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+    const unsigned char *p = *cursor;
+    const unsigned char *first = p;
+    uint64_t value;
+    int count;
+
+    while(p + 8 <= end && digits <= 11 && (count = parseDigits(p, &value)) > 0)
+    {
+        *mantissa = *mantissa * scales[count] + value;
+        digits += count;
+        p += count;
+
+        if(count < 8)
+        {
+            break;
+        }
+    }
+
+    while(p < end && isDigit(*p) && digits < 19)
+    {
+        *mantissa = *mantissa * 10 + (*p++ - '0');
+        ++digits;
+    }
+
+    *cursor = p;
+    return (int)(p - first);
+}
+
+// Reads the number at *cursor with the C library, for what the fast path does not handle: more than 19 significant
+// digits, large exponents, hexadecimal numbers, infinities and not a number.
+static bool parseFloatSlow(const unsigned char **cursor, const unsigned char *end, float *result)
+{
+    char text[64];
+    size_t length = 0;
+    const unsigned char *p = *cursor;
+
+    while(p + length < end && length < sizeof(text) - 1 && !isBlank(p[length]) && p[length] != '\n')
+    {
+        text[length] = (char)p[length];
+        ++length;
+    }
+
+    text[length] = '\0';
+    char *parsed = NULL;
+    double value = strtod(text, &parsed);
+
+    if(length == 0 || parsed != text + length)
+    {
+        return false;
+    }
+
+    *result = (float)value;
+    *cursor = p + length;
+    return true;
+}
+
+// Reads a decimal number at *cursor and moves the cursor past it. Gives the same result as (float)strtod().
+static bool parseFloat(const unsigned char **cursor, const unsigned char *end, float *result)
+{
+    const unsigned char *p = *cursor;
+    bool negative = false;
+
+    if(p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = parseMantissa(&p, end, &mantissa, 0);
+    bool hasDigits = digits > 0;
+
+    if(p < end && *p == '.')
+    {
+        ++p;
+        int fraction = parseMantissa(&p, end, &mantissa, digits);
+        digits += fraction;
+        exponent -= fraction;
+        hasDigits = hasDigits || fraction > 0;
+    }
+
+    if(!hasDigits || (p < end && isDigit(*p)))
+    {
+        return parseFloatSlow(cursor, end, result); // Too many digits, or not a plain number.
+    }
+
+    if(p < end && (*p == 'e' || *p == 'E'))
+    {
+        const unsigned char *power = ++p;
+        bool negativePower = false;
+        int value = 0;
+
+        if(p < end && (*p == '-' || *p == '+'))
+        {
+            negativePower = *p == '-';
+            ++p;
+        }
+
+        while(p < end && isDigit(*p) && value < 1000)
+        {
+            value = value * 10 + (*p++ - '0');
+        }
+
+        if(p == power || !isDigit(p[-1]) || (p < end && isDigit(*p)))
+        {
+            return parseFloatSlow(cursor, end, result);
+        }
+
+        exponent += negativePower ? -value : value;
+    }
+
+    // Both the mantissa and the power of ten are exact doubles, so the division or multiplication rounds once.
+    if(mantissa > (1ull << 53) || exponent < -22 || exponent > 22 || (p < end && !isBlank(*p) && *p != '\n'))
+    {
+        return parseFloatSlow(cursor, end, result);
+    }
+
+    double value = (double)mantissa;
+    value = exponent < 0 ? value / swPowersOfTen[-exponent] : value * swPowersOfTen[exponent];
+    *result = (float)(negative ? -value : value);
+    *cursor = p;
+    return true;
+}
+
+// Reads a decimal integer of at most 18 digits at *cursor and moves the cursor past it.
+static bool parseInteger(const unsigned char **cursor, const unsigned char *end, long long *result)
+{
+    const unsigned char *p = *cursor;
+    bool negative = false;
+
+    if(p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t value = 0;
+    int digits = parseMantissa(&p, end, &value, 0);
+
+    if(digits == 0 || digits > 18 || (p < end && isDigit(*p)))
+    {
+        return false;
+    }
+
+    *result = negative ? -(long long)value : (long long)value;
+    *cursor = p;
+    return true;
+}
+
+// Splits text into chunks of whole lines, at least SW_MESH_CHUNK_SIZE bytes each.
+static void splitChunks(const unsigned char *begin, const unsigned char *end, std::vector<SWMeshChunk> &chunks)
+{
+    const unsigned char *p = begin;
+
+    while(p < end)
+    {
+        SWMeshChunk chunk;
+        chunk.begin = p;
+        chunk.end = (size_t)(end - p) > SW_MESH_CHUNK_SIZE ? nextLine(p + SW_MESH_CHUNK_SIZE, end) : end;
+        chunk.count = 0;
+        chunk.first = 0;
+        chunk.colors = 0;
+        chunk.failed = false;
+        chunks.push_back(chunk);
+        p = chunk.end;
+    }
+}
+
+// Sets the first vertex or line of every chunk from the counts of the first pass, returns the total.
+static size_t sumChunks(std::vector<SWMeshChunk> &chunks)
+{
+    size_t total = 0;
+
+    for(size_t i = 0; i < chunks.size(); ++i)
+    {
+        chunks[i].first = total;
+        total += chunks[i].count;
+    }
+
+    return total;
+}
+
+// Appends the triangles of a fan around the first vertex of a polygon, given its vertices one by one.
+struct SWFan
+{
+    unsigned int first;
+    unsigned int previous;
+    int count;
+
+    void add(std::vector<unsigned int> &indices, unsigned int index)
+    {
+        if(count >= 2)
+        {
+            indices.push_back(first);
+            indices.push_back(previous);
+            indices.push_back(index);
+        }
+
+        first = count == 0 ? index : first;
+        previous = index;
+        ++count;
+    }
+};
+
+// Whether the line at p is an OBJ vertex, "v" followed by a blank.
+static inline bool isObjVertex(const unsigned char *p, const unsigned char *end)
+{
+    return p + 1 < end && p[0] == 'v' && isBlank(p[1]);
+}
+
+static void countObjVertices(void *data, int index)
+{
+    SWMeshChunk *chunk = &((SWMeshParse *)data)->chunks[index];
+    size_t count = 0;
+
+    for(const unsigned char *p = chunk->begin; p < chunk->end; p = nextLine(p, chunk->end))
+    {
+        count += isObjVertex(skipBlanks(p, chunk->end), chunk->end);
+    }
+
+    chunk->count = count;
+}
+
+// Second pass over an OBJ chunk: "v x y z [r g b]" and "f v[/vt][/vn] ..." lines.
+static void parseObjChunk(SWMeshParse *parse, SWMeshChunk *chunk)
+{
+    const unsigned char *end = chunk->end;
+    size_t vertex = chunk->first;
+
+    for(const unsigned char *p = chunk->begin; p < end && !chunk->failed; p = nextLine(p, end))
+    {
+        p = skipBlanks(p, end);
+
+        if(isObjVertex(p, end))
+        {
+            float values[6] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+            int count = 0;
+            p = skipBlanks(p + 1, end);
+
+            while(p < end && *p != '\n' && count < 6)
+            {
+                if(!parseFloat(&p, end, &values[count++]))
+                {
+                    chunk->failed = true;
+                    break;
+                }
+
+                p = skipBlanks(p, end);
+            }
+
+            // x y z, x y z w, or x y z r g b.
+            chunk->failed = chunk->failed || count < 3 || count == 5 || (p < end && *p != '\n');
+
+            if(count != 6)
+            {
+                values[3] = values[4] = values[5] = 1.0f;
+            }
+
+            SWRecordedVertex *target = &parse->vertices[vertex++];
+            target->x = values[0];
+            target->y = values[1];
+            target->z = values[2];
+            target->r = values[3];
+            target->g = values[4];
+            target->b = values[5];
+            chunk->colors += count == 6;
+        }
+        else if(p + 1 < end && p[0] == 'f' && isBlank(p[1]))
+        {
+            SWFan fan = {0, 0, 0};
+            p = skipBlanks(p + 1, end);
+
+            while(p < end && *p != '\n')
+            {
+                long long position;
+
+                if(!parseInteger(&p, end, &position))
+                {
+                    chunk->failed = true;
+                    break;
+                }
+
+                // Negative indices count back from the last vertex before the face.
+                long long resolved = position < 0 ? (long long)vertex + position : position - 1;
+
+                if(position == 0 || resolved < 0 || resolved >= (long long)parse->vertexCount)
+                {
+                    chunk->failed = true;
+                    break;
+                }
+
+                fan.add(chunk->indices, (unsigned int)resolved);
+
+                // Texture coordinate and normal indices.
+                while(p < end && !isBlank(*p) && *p != '\n')
+                {
+                    ++p;
+                }
+
+                p = skipBlanks(p, end);
+            }
+        }
+    }
+}
+
+// Tasks run on the worker threads, where running out of memory for the indices must not escape.
+static void parseChunk(void *data, int index)
+{
+    SWMeshParse *parse = (SWMeshParse *)data;
+    SWMeshChunk *chunk = &parse->chunks[index];
+
+    try
+    {
+        if(parse->ply)
+        {
+            parsePlyChunk(parse, chunk);
+        }
+        else
+        {
+            parseObjChunk(parse, chunk);
+        }
+    }
+    catch(const std::bad_alloc &)
+    {
+        chunk->failed = true;
+    }
+}
+
+static void copyIndices(void *data, int index)
+{
+    SWMeshParse *parse = (SWMeshParse *)data;
+    SWMeshChunk *chunk = &parse->chunks[index];
+
+    if(!chunk->indices.empty())
+    {
+        memcpy(&parse->indices[chunk->first], chunk->indices.data(), chunk->indices.size() * sizeof(unsigned int));
+    }
+}
+
+// Concatenates the faces of all chunks into mesh->indices. Fails when a chunk failed.
+static bool gatherIndices(SWMeshParse *parse, std::vector<SWMeshChunk> &chunks, SWGLMesh *mesh)
+{
+    size_t indexCount = 0;
+
+    for(size_t i = 0; i < chunks.size(); ++i)
+    {
+        if(chunks[i].failed)
+        {
+            return false;
+        }
+
+        chunks[i].first = indexCount;
+        indexCount += chunks[i].indices.size();
+    }
+
+    if(indexCount > INT_MAX)
+    {
+        return false;
+    }
+
+    mesh->indices.resize(indexCount);
+    parse->indices = mesh->indices.data();
+    swParallelFor((int)chunks.size(), copyIndices, parse);
+    return true;
+}
+
+static bool loadObj(const unsigned char *text, size_t size, SWGLMesh *mesh)
+{
+    std::vector<SWMeshChunk> chunks;
+    splitChunks(text, text + size, chunks);
+
+    SWMeshParse parse;
+    memset(&parse, 0, sizeof(parse));
+    parse.chunks = chunks.data();
+    swParallelFor((int)chunks.size(), countObjVertices, &parse);
+
+    size_t vertexCount = sumChunks(chunks);
+
+    if(vertexCount > INT_MAX)
+    {
+        return false;
+    }
+
+    mesh->vertices.resize(vertexCount);
+    parse.vertices = mesh->vertices.data();
+    parse.vertexCount = vertexCount;
+    swParallelFor((int)chunks.size(), parseChunk, &parse);
+
+    for(size_t i = 0; i < chunks.size(); ++i)
+    {
+        mesh->colors = mesh->colors || chunks[i].colors > 0;
+    }
+
+    return gatherIndices(&parse, chunks, mesh);
+}
+
+// PLY property and element types.
+#define SW_PLY_INT8 0
+#define SW_PLY_UINT8 1
+#define SW_PLY_INT16 2
+#define SW_PLY_UINT16 3
+#define SW_PLY_INT32 4
+#define SW_PLY_UINT32 5
+#define SW_PLY_FLOAT32 6
+#define SW_PLY_FLOAT64 7
+
+#define SW_PLY_OTHER 0
+#define SW_PLY_X 1
+#define SW_PLY_Y 2
+#define SW_PLY_Z 3
+#define SW_PLY_RED 4
+#define SW_PLY_GREEN 5
+#define SW_PLY_BLUE 6
+#define SW_PLY_INDICES 7
+
+static const int swPlyTypeSizes[] = {1, 1, 2, 2, 4, 4, 4, 8};
+
+struct SWPlyProperty
+{
+    int type; // Type of the value, or of the list entries.
+    int countType; // Type of the entry count of a list, -1 for a single value.
+    int role; // SW_PLY_X to SW_PLY_INDICES, or SW_PLY_OTHER for properties that are skipped.
+};
+
+struct SWPlyElement
+{
+    bool vertex;
+    bool face;
+    size_t count;
+    size_t firstLine; // Line of the first entry, in ASCII files.
+    int size; // Bytes of an entry in binary files, 0 when it holds a list.
+    std::vector<SWPlyProperty> properties;
+};
+
+struct SWPlyFormat
+{
+    bool binary;
+    std::vector<SWPlyElement> elements;
+    const SWPlyElement *vertex;
+    bool colors;
+};
+
+static int plyType(const char *name)
+{
+    static const char *names[][2] = {
+        {"char", "int8"}, {"uchar", "uint8"}, {"short", "int16"}, {"ushort", "uint16"},
+        {"int", "int32"}, {"uint", "uint32"}, {"float", "float32"}, {"double", "float64"}
+    };
+
+    for(int type = 0; type < 8; ++type)
+    {
+        if(!strcmp(name, names[type][0]) || !strcmp(name, names[type][1]))
+        {
+            return type;
+        }
+    }
+
+    return -1;
+}
+
+// Reads the header up to and including "end_header". Returns the size of the header, 0 when it is not supported.
+static size_t parsePlyHeader(const unsigned char *text, size_t size, SWPlyFormat *format)
+{
+    const unsigned char *end = text + size;
+    const unsigned char *p = text;
+    bool formatSeen = false;
+    char line[256];
+
+    format->vertex = NULL;
+    format->colors = false;
+
+    while(p < end)
+    {
+        const unsigned char *next = nextLine(p, end);
+        size_t length = (size_t)(next - p);
+
+        if(length >= sizeof(line))
+        {
+            return 0;
+        }
+
+        memcpy(line, p, length);
+        line[length] = '\0';
+        p = next;
+
+        char word[5][32];
+        int words = sscanf(line, "%31s %31s %31s %31s %31s", word[0], word[1], word[2], word[3], word[4]);
+
+        if(words <= 0 || !strcmp(word[0], "comment") || !strcmp(word[0], "obj_info") || !strcmp(word[0], "ply"))
+        {
+            continue;
+        }
+
+        if(!strcmp(word[0], "end_header"))
+        {
+            return formatSeen ? (size_t)(p - text) : 0;
+        }
+
+        if(!strcmp(word[0], "format") && words >= 2)
+        {
+            if(strcmp(word[1], "ascii") && (strcmp(word[1], "binary_little_endian") || !SW_MESH_SWAR))
+            {
+                return 0;
+            }
+
+            format->binary = strcmp(word[1], "ascii") != 0;
+            formatSeen = true;
+        }
+        else if(!strcmp(word[0], "element") && words >= 3)
+        {
+            SWPlyElement element;
+            char *countEnd = NULL;
+            element.vertex = !strcmp(word[1], "vertex");
+            element.face = !strcmp(word[1], "face");
+            element.count = (size_t)strtoull(word[2], &countEnd, 10);
+            element.firstLine = 0;
+            element.size = 0;
+
+            if(*countEnd != '\0')
+            {
+                return 0;
+            }
+
+            format->elements.push_back(element);
+        }
+        else if(!strcmp(word[0], "property") && words >= 3 && !format->elements.empty())
+        {
+            SWPlyElement *element = &format->elements.back();
+            SWPlyProperty property;
+            const char *name;
+
+            // "property <type> <name>" or "property list <count type> <type> <name>".
+            if(!strcmp(word[1], "list"))
+            {
+                if(words < 5)
+                {
+                    return 0;
+                }
+
+                property.countType = plyType(word[2]);
+                property.type = plyType(word[3]);
+                name = word[4];
+
+                if(property.countType < 0)
+                {
+                    return 0;
+                }
+            }
+            else
+            {
+                property.countType = -1;
+                property.type = plyType(word[1]);
+                name = word[2];
+            }
+
+            if(property.type < 0)
+            {
+                return 0;
+            }
+
+            property.role = SW_PLY_OTHER;
+
+            if(element->vertex && property.countType < 0)
+            {
+                // Colors are also named r, g and b, or diffuse_red, diffuse_green and diffuse_blue.
+                static const char *roles[][3] = {
+                    {"x", "x", "x"}, {"y", "y", "y"}, {"z", "z", "z"},
+                    {"red", "r", "diffuse_red"}, {"green", "g", "diffuse_green"}, {"blue", "b", "diffuse_blue"}
+                };
+
+                for(int role = 0; role < 6; ++role)
+                {
+                    if(!strcmp(name, roles[role][0]) || !strcmp(name, roles[role][1]) || !strcmp(name, roles[role][2]))
+                    {
+                        property.role = SW_PLY_X + role;
+                    }
+                }
+            }
+            else if(element->face && property.countType >= 0 && (!strcmp(name, "vertex_indices") || !strcmp(name, "vertex_index")))
+            {
+                property.role = SW_PLY_INDICES;
+            }
+
+            element->properties.push_back(property);
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    return 0; // No end_header.
+}
+
+// Reads a binary value of type at p as a double.
+static inline double readPlyValue(const unsigned char *p, int type)
+{
+    switch(type)
+    {
+        case SW_PLY_INT8: return (double)(int8_t)p[0];
+        case SW_PLY_UINT8: return (double)p[0];
+        case SW_PLY_INT16: { int16_t value; memcpy(&value, p, 2); return value; }
+        case SW_PLY_UINT16: { uint16_t value; memcpy(&value, p, 2); return value; }
+        case SW_PLY_INT32: { int32_t value; memcpy(&value, p, 4); return value; }
+        case SW_PLY_UINT32: { uint32_t value; memcpy(&value, p, 4); return value; }
+        case SW_PLY_FLOAT32: { float value; memcpy(&value, p, 4); return value; }
+        default: { double value; memcpy(&value, p, 8); return value; }
+    }
+}
+
+// Stores a vertex property, colors stored as integers are scaled to 0.0 to 1.0.
+static inline void setPlyVertex(SWRecordedVertex *vertex, const SWPlyProperty *property, double value)
+{
+    float scale = property->type == SW_PLY_UINT8 ? 1.0f / 255.0f : property->type == SW_PLY_UINT16 ? 1.0f / 65535.0f : 1.0f;
+
+    switch(property->role)
+    {
+        case SW_PLY_X: vertex->x = (float)value; break;
+        case SW_PLY_Y: vertex->y = (float)value; break;
+        case SW_PLY_Z: vertex->z = (float)value; break;
+        case SW_PLY_RED: vertex->r = (float)value * scale; break;
+        case SW_PLY_GREEN: vertex->g = (float)value * scale; break;
+        case SW_PLY_BLUE: vertex->b = (float)value * scale; break;
+        default: break;
+    }
+}
+
+static void countPlyLines(void *data, int index)
+{
+    SWMeshChunk *chunk = &((SWMeshParse *)data)->chunks[index];
+    size_t count = 0;
+
+    for(const unsigned char *p = chunk->begin; p < chunk->end; p = nextLine(p, chunk->end))
+    {
+        ++count;
+    }
+
+    chunk->count = count;
+}
+
+// Second pass over an ASCII PLY chunk, every line is an entry of the element its line number falls into.
+static void parsePlyChunk(SWMeshParse *parse, SWMeshChunk *chunk)
+{
+    const std::vector<SWPlyElement> &elements = parse->ply->elements;
+    const unsigned char *end = chunk->end;
+    size_t line = chunk->first;
+    size_t element = 0;
+
+    for(const unsigned char *p = chunk->begin; p < end && !chunk->failed; p = nextLine(p, end), ++line)
+    {
+        while(element < elements.size() && line >= elements[element].firstLine + elements[element].count)
+        {
+            ++element;
+        }
+
+        if(element == elements.size())
+        {
+            break; // Anything after the last element is ignored.
+        }
+
+        const SWPlyElement *entry = &elements[element];
+
+        if(!entry->vertex && !entry->face)
+        {
+            continue;
+        }
+
+        SWRecordedVertex *vertex = entry->vertex ? &parse->vertices[line - entry->firstLine] : NULL;
+        p = skipBlanks(p, end);
+
+        if(vertex)
+        {
+            vertex->x = vertex->y = vertex->z = 0.0f;
+            vertex->r = vertex->g = vertex->b = 1.0f;
+        }
+
+        for(size_t i = 0; i < entry->properties.size() && !chunk->failed; ++i)
+        {
+            const SWPlyProperty *property = &entry->properties[i];
+            long long count = 1;
+
+            if(property->countType >= 0 && (!parseInteger(&p, end, &count) || count < 0))
+            {
+                chunk->failed = true;
+                break;
+            }
+
+            SWFan fan = {0, 0, 0};
+
+            for(long long j = 0; j < count; ++j)
+            {
+                p = skipBlanks(p, end);
+
+                if(property->role == SW_PLY_INDICES)
+                {
+                    long long position;
+
+                    if(!parseInteger(&p, end, &position) || position < 0 || position >= (long long)parse->vertexCount)
+                    {
+                        chunk->failed = true;
+                        break;
+                    }
+
+                    fan.add(chunk->indices, (unsigned int)position);
+                    continue;
+                }
+
+                float value;
+
+                if(!parseFloat(&p, end, &value))
+                {
+                    chunk->failed = true;
+                    break;
+                }
+
+                if(vertex)
+                {
+                    setPlyVertex(vertex, property, value);
+                }
+            }
+
+            p = skipBlanks(p, end);
+        }
+    }
+}
+
+// Vertices of a binary PLY file, SW_MESH_CHUNK_SIZE bytes of them per task.
+static void parsePlyBinaryVertices(void *data, int index)
+{
+    SWMeshParse *parse = (SWMeshParse *)data;
+    SWMeshChunk *chunk = &parse->chunks[index];
+    const SWPlyElement *element = parse->ply->vertex;
+
+    for(size_t i = chunk->first; i < chunk->first + chunk->count; ++i)
+    {
+        const unsigned char *p = chunk->begin + (i - chunk->first) * element->size;
+        SWRecordedVertex *vertex = &parse->vertices[i];
+        vertex->x = vertex->y = vertex->z = 0.0f;
+        vertex->r = vertex->g = vertex->b = 1.0f;
+
+        for(size_t j = 0; j < element->properties.size(); ++j)
+        {
+            const SWPlyProperty *property = &element->properties[j];
+
+            if(property->role != SW_PLY_OTHER)
+            {
+                setPlyVertex(vertex, property, readPlyValue(p, property->type));
+            }
+
+            p += swPlyTypeSizes[property->type];
+        }
+    }
+}
+
+static bool loadPly(const unsigned char *text, size_t size, SWGLMesh *mesh)
+{
+    SWPlyFormat format;
+    size_t headerSize = parsePlyHeader(text, size, &format);
+
+    if(headerSize == 0)
+    {
+        return false;
+    }
+
+    size_t line = 0;
+
+    for(size_t i = 0; i < format.elements.size(); ++i)
+    {
+        SWPlyElement *element = &format.elements[i];
+        element->firstLine = line;
+        line += element->count;
+
+        for(size_t j = 0; j < element->properties.size(); ++j)
+        {
+            const SWPlyProperty *property = &element->properties[j];
+            element->size = property->countType >= 0 || element->size < 0 ? -1 : element->size + swPlyTypeSizes[property->type];
+            format.colors = format.colors || (element->vertex && property->role >= SW_PLY_RED && property->role <= SW_PLY_BLUE);
+        }
+
+        element->size = element->size < 0 ? 0 : element->size;
+
+        if(element->vertex && !format.vertex)
+        {
+            format.vertex = element;
+        }
+    }
+
+    size_t vertexCount = format.vertex ? format.vertex->count : 0;
+
+    if(vertexCount > INT_MAX)
+    {
+        return false;
+    }
+
+    mesh->vertices.resize(vertexCount);
+    mesh->colors = format.colors;
+
+    std::vector<SWMeshChunk> chunks;
+    SWMeshParse parse;
+    memset(&parse, 0, sizeof(parse));
+    parse.ply = &format;
+    parse.vertices = mesh->vertices.data();
+    parse.vertexCount = vertexCount;
+
+    if(!format.binary)
+    {
+        splitChunks(text + headerSize, text + size, chunks);
+        parse.chunks = chunks.data();
+        swParallelFor((int)chunks.size(), countPlyLines, &parse);
+
+        if(sumChunks(chunks) < line)
+        {
+            return false; // Truncated.
+        }
+
+        swParallelFor((int)chunks.size(), parseChunk, &parse);
+        return gatherIndices(&parse, chunks, mesh);
+    }
+
+    // Binary: vertices are converted in parallel, faces are read in order as their lists make their size vary.
+    const unsigned char *p = text + headerSize;
+    const unsigned char *end = text + size;
+    std::vector<unsigned int> indices;
+
+    for(size_t i = 0; i < format.elements.size(); ++i)
+    {
+        const SWPlyElement *element = &format.elements[i];
+
+        if(element->size > 0 && (size_t)(end - p) / element->size < element->count)
+        {
+            return false;
+        }
+
+        if(element == format.vertex)
+        {
+            if(element->size == 0)
+            {
+                return false; // Vertices holding lists are not supported.
+            }
+
+            size_t perChunk = SW_MESH_CHUNK_SIZE / element->size + 1;
+
+            for(size_t first = 0; first < element->count; first += perChunk)
+            {
+                SWMeshChunk chunk;
+                chunk.begin = p + first * element->size;
+                chunk.end = NULL;
+                chunk.colors = 0;
+                chunk.failed = false;
+                chunk.first = first;
+                chunk.count = element->count - first < perChunk ? element->count - first : perChunk;
+                chunks.push_back(chunk);
+            }
+
+            parse.chunks = chunks.data();
+            swParallelFor((int)chunks.size(), parsePlyBinaryVertices, &parse);
+            p += element->count * element->size;
+            continue;
+        }
+
+        if(element->size > 0 && !element->face)
+        {
+            p += element->count * element->size;
+            continue;
+        }
+
+        // Entries with lists, read value by value.
+        for(size_t entry = 0; entry < element->count; ++entry)
+        {
+            for(size_t j = 0; j < element->properties.size(); ++j)
+            {
+                const SWPlyProperty *property = &element->properties[j];
+                int valueSize = swPlyTypeSizes[property->type];
+                size_t count = 1;
+
+                if(property->countType >= 0)
+                {
+                    if(end - p < swPlyTypeSizes[property->countType])
+                    {
+                        return false;
+                    }
+
+                    double listSize = readPlyValue(p, property->countType);
+                    p += swPlyTypeSizes[property->countType];
+
+                    if(!(listSize >= 0.0))
+                    {
+                        return false;
+                    }
+
+                    count = (size_t)listSize;
+                }
+
+                if((size_t)(end - p) / valueSize < count)
+                {
+                    return false;
+                }
+
+                if(property->role == SW_PLY_INDICES && element->face)
+                {
+                    SWFan fan = {0, 0, 0};
+
+                    for(size_t k = 0; k < count; ++k)
+                    {
+                        double position = readPlyValue(p + k * valueSize, property->type);
+
+                        if(!(position >= 0.0 && position < (double)vertexCount))
+                        {
+                            return false;
+                        }
+
+                        fan.add(indices, (unsigned int)position);
+                    }
+                }
+
+                p += count * valueSize;
+            }
+        }
+    }
+
+    if(indices.size() > INT_MAX)
+    {
+        return false;
+    }
+
+    mesh->indices.swap(indices);
+    return true;
+}
+
+HSWGLMESH swglLoadMesh(const char *fileName)
+{
+    SWMappedFile file;
+
+    if(!fileName || !swMapFile(fileName, &file))
+    {
+        return NULL;
+    }
+
+    SWGLMesh *mesh = new(std::nothrow) SWGLMesh();
+    bool loaded = false;
+
+    if(mesh)
+    {
+        mesh->colors = false;
+
+        try
+        {
+            bool ply = file.size >= 4 && !memcmp(file.data, "ply", 3) && (file.data[3] == '\n' || file.data[3] == '\r');
+            loaded = ply ? loadPly(file.data, file.size, mesh) : loadObj(file.data, file.size, mesh);
+        }
+        catch(const std::bad_alloc &)
+        {
+            loaded = false;
+        }
+    }
+
+    swUnmapFile(&file);
+
+    if(!loaded)
+    {
+        delete mesh;
+        return NULL;
+    }
+
+    return mesh;
+}
+
+int swglDeleteMesh(HSWGLMESH mesh)
+{
+    if(!mesh)
+    {
+        return FALSE;
+    }
+
+    delete mesh;
+    return TRUE;
+}
+
+int swglGetMeshData(HSWGLMESH mesh, GLsizei *vertexCount, const GLfloat **vertices, GLsizei *indexCount, const GLuint **indices)
+{
+    if(!mesh)
+    {
+        return FALSE;
+    }
+
+    static_assert(sizeof(SWRecordedVertex) == 6 * sizeof(GLfloat), "Vertices are handed out as 6 floats.");
+
+    if(vertexCount)
+    {
+        *vertexCount = (GLsizei)mesh->vertices.size();
+    }
+
+    if(vertices)
+    {
+        *vertices = mesh->vertices.empty() ? NULL : &mesh->vertices[0].x;
+    }
+
+    if(indexCount)
+    {
+        *indexCount = (GLsizei)mesh->indices.size();
+    }
+
+    if(indices)
+    {
+        *indices = mesh->indices.empty() ? NULL : mesh->indices.data();
+    }
+
+    return TRUE;
+}
+
+int swglDrawMesh(HSWGLMESH mesh)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context || !mesh || context->insideBeginEnd)
+    {
+        return FALSE;
+    }
+
+    int vertexCount = (int)mesh->vertices.size();
+    swDrawIndexed(context, GL_TRIANGLES, mesh->vertices.data(), vertexCount, mesh->colors ? 0 : vertexCount,
+        mesh->indices.data(), (int)mesh->indices.size());
+    return TRUE;
+}
@@ -0,0 +1,811 @@
+// Immediate mode primitive assembly and clipping of the software renderer.
+
+#include <math.h>
+
+#include <string.h>
+
+#include <new>
+#include <vector>
+
+#include "context.h"
+
+#define SW_BATCH_VERTICES 768 // Capacity of a batch, small enough for the recorded and transformed vertices to stay in cache.
+#define SW_VERTEX_CACHE_BITS 6
+#define SW_VERTEX_CACHE_SIZE (1 << SW_VERTEX_CACHE_BITS) // Entries of the post-transform vertex cache.
+
+// Vertices of consecutive primitives recorded between glBegin() and glEnd(), all of one mode and drawn with the
+// same matrices and render state, so that swFlushVertices() can transform them in one pass.
+struct SWCommandBuffer
+{
+    GLenum mode;
+    int vertexCount;
+    SWRecordedVertex vertices[SW_BATCH_VERTICES];
+    SWTransformedVertex transformed[SW_BATCH_VERTICES]; // Vertices of the batch being drawn.
+    std::vector<SWTransformedVertex> indexed; // Vertices of an indexed or instanced draw, kept to reuse the storage.
+    std::vector<SWRecordedVertex> instance; // Geometry of an instanced draw.
+    std::vector<int> visibleInstances; // Instances of an instanced draw left by frustum culling.
+
+    // Post-transform vertex cache of indexed draws. An entry added by the batch being drawn points at its slot in
+    // transformed, and is copied to cached once the batch is done, as the next batch overwrites transformed.
+    int cachedIndex[SW_VERTEX_CACHE_SIZE]; // -1 for empty entries.
+    int cachedSlot[SW_VERTEX_CACHE_SIZE]; // -1 for entries of earlier batches.
+    SWTransformedVertex cached[SW_VERTEX_CACHE_SIZE];
+    const SWTransformedVertex *corners[SW_BATCH_VERTICES]; // Vertex of every index of the batch.
+};
+
+static bool swNativeQuads = true; // See swglSetNativeQuads().
+static bool swGuardBand = true; // See swglSetGuardBand().
+static bool swVertexBatching = true; // See swglSetVertexBatching().
+static bool swVertexCache = true; // See swglSetVertexCache().
+
+SWCommandBuffer *swCreateCommandBuffer(void)
+{
+    SWCommandBuffer *commands = new(std::nothrow) SWCommandBuffer();
+
+    if(commands)
+    {
+        commands->mode = GL_TRIANGLES;
+        commands->vertexCount = 0;
+    }
+
+    return commands;
+}
+
+void swDestroyCommandBuffer(SWCommandBuffer *commands)
+{
+    delete commands;
+}
+
+GLvoid glBegin(GLenum mode)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(context->listBuilder && !swCompileCommand(context, SW_LIST_BEGIN, mode, 0.0, 0.0, 0.0))
+    {
+        return;
+    }
+
+    if(context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return;
+    }
+
+    if(mode != GL_TRIANGLES && mode != GL_QUADS)
+    {
+        swSetError(context, GL_INVALID_ENUM);
+        return;
+    }
+
+    // A batch holds primitives of one mode only.
+    if(context->commands->mode != mode)
+    {
+        swFlushVertices(context);
+        context->commands->mode = mode;
+    }
+
+    context->insideBeginEnd = true;
+    context->primitiveMode = mode;
+    context->primitiveVertexCount = 0;
+}
+
+GLvoid glEnd(GLvoid)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(context->listBuilder && !swCompileCommand(context, SW_LIST_END, 0.0, 0.0, 0.0, 0.0))
+    {
+        return;
+    }
+
+    if(!context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return;
+    }
+
+    // Vertices of an incomplete primitive are ignored.
+    if(swVertexBatching)
+    {
+        context->commands->vertexCount -= context->primitiveVertexCount;
+    }
+
+    context->insideBeginEnd = false;
+    context->primitiveVertexCount = 0;
+}
+
+GLvoid glColor3f(GLfloat red, GLfloat green, GLfloat blue)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(context->listBuilder && !swCompileCommand(context, SW_LIST_COLOR, red, green, blue, 0.0))
+    {
+        return;
+    }
+
+    context->currentColor[0] = red;
+    context->currentColor[1] = green;
+    context->currentColor[2] = blue;
+}
+
+// Determinant of the homogeneous 2D coordinates (x, y, w) of three clip space vertices.
+// Its sign is the winding in window space of the part of the triangle in front of the eye,
+// without dividing by w, so it also holds for triangles that still have to be clipped.
+static float homogeneousArea(const SWVertex *v0, const SWVertex *v1, const SWVertex *v2)
+{
+    return v0->x * (v1->y * v2->w - v2->y * v1->w)
+        - v0->y * (v1->x * v2->w - v2->x * v1->w)
+        + v0->w * (v1->x * v2->y - v2->x * v1->y);
+}
+
+// Face culling, done on the projected primitive before clipping and setup.
+static bool isCulled(const SWGLContext *context, const SWTransformedVertex *vertices, int vertexCount)
+{
+    if(context->cullFaceMode == GL_FRONT_AND_BACK)
+    {
+        return true;
+    }
+
+    // The halves of a planar quad have the same winding, their sum keeps it when one half is degenerate.
+    float area = homogeneousArea(&vertices[0].clip, &vertices[1].clip, &vertices[2].clip);
+
+    if(vertexCount == 4)
+    {
+        area += homogeneousArea(&vertices[0].clip, &vertices[2].clip, &vertices[3].clip);
+    }
+
+    // The viewport transform keeps the winding, window y points up like clip space y.
+    bool front = context->frontFace == GL_CCW ? area > 0.0f : area < 0.0f;
+    return front == (context->cullFaceMode == GL_FRONT);
+}
+
+// Culls, shades and clips a primitive after the geometry stage.
+static void drawPrimitive(SWGLContext *context, SWTransformedVertex *vertices, int vertexCount)
+{
+    if(context->cullFace && isCulled(context, vertices, vertexCount))
+    {
+        context->stats.primitivesCulled++;
+        return;
+    }
+
+    // Flat shading takes the color of the last vertex of the primitive.
+    if(context->shadeModel == GL_FLAT)
+    {
+        const SWVertex *last = &vertices[vertexCount - 1].clip;
+
+        for(int i = 0; i < vertexCount - 1; ++i)
+        {
+            vertices[i].clip.r = vertices[i].window.r = last->r;
+            vertices[i].clip.g = vertices[i].window.g = last->g;
+            vertices[i].clip.b = vertices[i].window.b = last->b;
+        }
+    }
+
+    if(vertexCount == 4)
+    {
+        swDrawQuad(context, &vertices[0], &vertices[1], &vertices[2], &vertices[3]);
+    }
+    else
+    {
+        swDrawTriangle(context, &vertices[0], &vertices[1], &vertices[2]);
+    }
+}
+
+// Runs the geometry stage with the guard band selected by swglSetGuardBand().
+static void transformVertices(SWGLContext *context, const float *matrix, const SWRecordedVertex *source, int count, SWTransformedVertex *output)
+{
+    float guardBandX = swGuardBand ? context->guardBandX : 1.0f;
+    float guardBandY = swGuardBand ? context->guardBandY : 1.0f;
+    swTransformVertices(context, matrix, guardBandX, guardBandY, source, count, output);
+}
+
+GLvoid glVertex3f(GLfloat x, GLfloat y, GLfloat z)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(context->listBuilder && !swCompileCommand(context, SW_LIST_VERTEX, x, y, z, 0.0))
+    {
+        return;
+    }
+
+    if(!context->insideBeginEnd)
+    {
+        return;
+    }
+
+    int primitiveSize = context->primitiveMode == GL_QUADS ? 4 : 3;
+
+    // Only record the vertex, the geometry stage runs once for a whole batch.
+    SWCommandBuffer *commands = context->commands;
+    SWRecordedVertex *vertex = swVertexBatching ? &commands->vertices[commands->vertexCount++] : &context->primitiveVertices[context->primitiveVertexCount];
+    vertex->x = x;
+    vertex->y = y;
+    vertex->z = z;
+    vertex->r = context->currentColor[0];
+    vertex->g = context->currentColor[1];
+    vertex->b = context->currentColor[2];
+
+    if(++context->primitiveVertexCount < primitiveSize)
+    {
+        return;
+    }
+
+    context->primitiveVertexCount = 0;
+    context->stats.primitivesSubmitted++;
+
+    if(swVertexBatching)
+    {
+        // Keep room for the next primitive.
+        if(commands->vertexCount > SW_BATCH_VERTICES - 4)
+        {
+            swFlushVertices(context);
+        }
+
+        return;
+    }
+
+    SWTransformedVertex transformed[4];
+    transformVertices(context, swGetModelviewProjection(context), context->primitiveVertices, primitiveSize, transformed);
+    drawPrimitive(context, transformed, primitiveSize);
+}
+
+// Looks the draw up in the draw cache, see drawCache.cpp. Returns true when it was replayed; otherwise the caller
+// runs the geometry stage and calls swRecordDraw().
+static bool replayDraw(SWGLContext *context, const float *matrix, GLenum mode, const SWRecordedVertex *vertices, int vertexCount,
+    int currentColorVertices, const unsigned int *indices, int indexCount)
+{
+    if(!swCacheDraws)
+    {
+        return false;
+    }
+
+    SWDrawKey key;
+    memset(&key, 0, sizeof(key));
+    key.geometryHash = swHashMemory(vertices, vertexCount * sizeof(SWRecordedVertex),
+        indices ? swHashMemory(indices, indexCount * sizeof(unsigned int), 0) : 0);
+    key.mode = mode;
+    key.vertexCount = vertexCount;
+    key.indexCount = indexCount;
+    key.currentColorVertices = currentColorVertices;
+
+    if(currentColorVertices)
+    {
+        memcpy(key.currentColor, context->currentColor, sizeof(key.currentColor));
+    }
+
+    memcpy(key.matrix, matrix, sizeof(key.matrix));
+    key.viewport[0] = context->viewportX;
+    key.viewport[1] = context->viewportY;
+    key.viewport[2] = context->viewportWidth;
+    key.viewport[3] = context->viewportHeight;
+    key.guardBandX = swGuardBand ? context->guardBandX : 1.0f;
+    key.guardBandY = swGuardBand ? context->guardBandY : 1.0f;
+    key.nativeQuads = swNativeQuads;
+    key.cullFace = context->cullFace;
+    key.cullFaceMode = context->cullFaceMode;
+    key.frontFace = context->frontFace;
+    key.shadeModel = context->shadeModel;
+    key.perspectiveHint = context->perspectiveHint;
+    key.depthTest = context->depthTest;
+    key.depthFunc = context->depthFunc;
+    return swReplayDraw(context, &key);
+}
+
+// Geometry stage of the recorded vertices: the whole batch is transformed first, then assembled into primitives.
+void swFlushVertices(SWGLContext *context)
+{
+    SWCommandBuffer *commands = context->commands;
+    int primitiveSize = commands->mode == GL_QUADS ? 4 : 3;
+    int count = commands->vertexCount / primitiveSize * primitiveSize;
+
+    if(count == 0)
+    {
+        return;
+    }
+
+    const float *matrix = swGetModelviewProjection(context);
+
+    if(!replayDraw(context, matrix, commands->mode, commands->vertices, count, 0, NULL, 0))
+    {
+        SWTransformedVertex *transformed = commands->transformed;
+        transformVertices(context, matrix, commands->vertices, count, transformed);
+
+        for(int i = 0; i < count; i += primitiveSize)
+        {
+            drawPrimitive(context, &transformed[i], primitiveSize);
+        }
+
+        swRecordDraw(context);
+    }
+
+    // The vertices of an incomplete primitive stay recorded until glVertex3f() completes it.
+    commands->vertexCount -= count;
+    memmove(commands->vertices, commands->vertices + count, commands->vertexCount * sizeof(SWRecordedVertex));
+}
+
+// Copies vertex index of source into vertex, with the current color where source has none.
+static inline void fetchVertex(const SWGLContext *context, const SWVertexSource *source, unsigned int index, SWRecordedVertex *vertex)
+{
+    const float *position = (const float *)(source->positions + index * source->positionStride);
+    const float *color = source->colors ? (const float *)(source->colors + index * source->colorStride) : context->currentColor;
+
+    vertex->x = position[0];
+    vertex->y = position[1];
+    vertex->z = source->positionSize == 3 ? position[2] : 0.0f;
+    vertex->r = color[0];
+    vertex->g = color[1];
+    vertex->b = color[2];
+}
+
+// Indexed draw in batches of up to SW_BATCH_VERTICES indices. Every index is looked up in a direct-mapped cache of
+// recently transformed vertices; only the misses are gathered and transformed, together, before the primitives of
+// the batch are assembled from the vertices of their corners.
+template<typename Index>
+static void drawElements(SWGLContext *context, GLenum mode, const SWVertexSource *source, const Index *indices, int indexCount)
+{
+    SWCommandBuffer *commands = context->commands;
+    int primitiveSize = mode == GL_QUADS ? 4 : 3;
+    int count = indexCount / primitiveSize * primitiveSize;
+    const int batchSize = SW_BATCH_VERTICES / 12 * 12; // Whole triangles and quads.
+    const float *matrix = swGetModelviewProjection(context);
+    SWTransformedVertex *transformed = commands->transformed;
+    SWRecordedVertex *missed = commands->vertices; // Empty after swFlushVertices().
+    const SWTransformedVertex **corners = commands->corners;
+    int hits = 0;
+
+    // Vertices of an earlier draw were transformed by other matrices, or are other vertices.
+    memset(commands->cachedIndex, -1, sizeof(commands->cachedIndex));
+    memset(commands->cachedSlot, -1, sizeof(commands->cachedSlot));
+
+    for(int first = 0; first < count; first += batchSize)
+    {
+        int batch = count - first < batchSize ? count - first : batchSize;
+        int missCount = 0;
+
+        for(int i = 0; i < batch; ++i)
+        {
+            unsigned int index = indices[first + i];
+            unsigned int entry = (index * 2654435761u) >> (32 - SW_VERTEX_CACHE_BITS); // Neighbouring indices spread out.
+
+            if(swVertexCache && commands->cachedIndex[entry] == (int)index)
+            {
+                int slot = commands->cachedSlot[entry];
+                corners[i] = slot >= 0 ? &transformed[slot] : &commands->cached[entry];
+                hits++;
+                continue;
+            }
+
+            // The vertex the entry held stays in cached until the end of the batch, for the corners using it.
+            commands->cachedIndex[entry] = (int)index;
+            commands->cachedSlot[entry] = missCount;
+            corners[i] = &transformed[missCount];
+            fetchVertex(context, source, index, &missed[missCount++]);
+        }
+
+        transformVertices(context, matrix, missed, missCount, transformed);
+
+        SWTransformedVertex primitive[4];
+
+        for(int i = 0; i < batch; i += primitiveSize)
+        {
+            // Copied, drawPrimitive() changes the colors of flat shaded primitives.
+            for(int j = 0; j < primitiveSize; ++j)
+            {
+                primitive[j] = *corners[i + j];
+            }
+
+            context->stats.primitivesSubmitted++;
+            drawPrimitive(context, primitive, primitiveSize);
+        }
+
+        for(int entry = 0; entry < SW_VERTEX_CACHE_SIZE; ++entry)
+        {
+            if(commands->cachedSlot[entry] >= 0)
+            {
+                commands->cached[entry] = transformed[commands->cachedSlot[entry]];
+                commands->cachedSlot[entry] = -1;
+            }
+        }
+    }
+
+    context->stats.vertexCacheLookups += count;
+    context->stats.vertexCacheHits += hits;
+}
+
+void swDrawElements(SWGLContext *context, GLenum mode, const SWVertexSource *source, GLenum indexType, const void *indices,
+    int indexCount)
+{
+    // Recorded immediate mode primitives come first.
+    swFlushVertices(context);
+
+    switch(indexType)
+    {
+        case GL_UNSIGNED_BYTE: drawElements(context, mode, source, (const unsigned char *)indices, indexCount); break;
+        case GL_UNSIGNED_SHORT: drawElements(context, mode, source, (const unsigned short *)indices, indexCount); break;
+        default: drawElements(context, mode, source, (const unsigned int *)indices, indexCount); break;
+    }
+}
+
+void swDrawIndexed(SWGLContext *context, GLenum mode, const SWRecordedVertex *vertices, int vertexCount, int currentColorVertices,
+    const unsigned int *indices, int indexCount)
+{
+    // Recorded immediate mode primitives come first.
+    swFlushVertices(context);
+
+    const float *matrix = swGetModelviewProjection(context);
+
+    if(replayDraw(context, matrix, mode, vertices, vertexCount, currentColorVertices, indices, indexCount))
+    {
+        return;
+    }
+
+    // Every vertex is used, so all of them are transformed once up front instead of going through the vertex cache.
+    SWCommandBuffer *commands = context->commands;
+    commands->indexed.resize(vertexCount);
+    SWTransformedVertex *transformed = commands->indexed.data();
+    transformVertices(context, matrix, vertices, vertexCount, transformed);
+
+    for(int i = 0; i < currentColorVertices; ++i)
+    {
+        transformed[i].clip.r = transformed[i].window.r = context->currentColor[0];
+        transformed[i].clip.g = transformed[i].window.g = context->currentColor[1];
+        transformed[i].clip.b = transformed[i].window.b = context->currentColor[2];
+    }
+
+    int primitiveSize = mode == GL_QUADS ? 4 : 3;
+    SWTransformedVertex primitive[4];
+
+    for(int i = 0; i + primitiveSize <= indexCount; i += primitiveSize)
+    {
+        for(int j = 0; j < primitiveSize; ++j)
+        {
+            primitive[j] = transformed[indices[i + j]];
+        }
+
+        context->stats.primitivesSubmitted++;
+        drawPrimitive(context, primitive, primitiveSize);
+    }
+
+    swRecordDraw(context);
+}
+
+int swglDrawInstanced(GLenum mode, GLsizei vertexCount, const GLfloat *positions, const GLfloat *colors,
+    GLsizei instanceCount, const GLfloat *matrices, const GLfloat *instanceColors)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context || context->insideBeginEnd || (mode != GL_TRIANGLES && mode != GL_QUADS)
+        || vertexCount < 0 || instanceCount < 0 || (vertexCount && !positions) || (instanceCount && !matrices))
+    {
+        return FALSE;
+    }
+
+    // Recorded immediate mode primitives come first.
+    swFlushVertices(context);
+
+    // Vertices of an incomplete primitive are ignored.
+    int primitiveSize = mode == GL_QUADS ? 4 : 3;
+    int count = vertexCount / primitiveSize * primitiveSize;
+    SWCommandBuffer *commands = context->commands;
+    commands->instance.resize(count);
+    commands->indexed.resize(count);
+    SWRecordedVertex *geometry = commands->instance.data();
+    SWTransformedVertex *transformed = commands->indexed.data();
+
+    for(int i = 0; i < count; ++i)
+    {
+        const float *color = colors ? &colors[i * 3] : context->currentColor;
+        geometry[i].x = positions[i * 3];
+        geometry[i].y = positions[i * 3 + 1];
+        geometry[i].z = positions[i * 3 + 2];
+        geometry[i].r = color[0];
+        geometry[i].g = color[1];
+        geometry[i].b = color[2];
+    }
+
+    if(count == 0)
+    {
+        return TRUE;
+    }
+
+    // Bounding sphere of the geometry, centered on its bounding box.
+    float minimum[3] = {geometry[0].x, geometry[0].y, geometry[0].z};
+    float maximum[3] = {geometry[0].x, geometry[0].y, geometry[0].z};
+
+    for(int i = 1; i < count; ++i)
+    {
+        minimum[0] = fminf(minimum[0], geometry[i].x);
+        minimum[1] = fminf(minimum[1], geometry[i].y);
+        minimum[2] = fminf(minimum[2], geometry[i].z);
+        maximum[0] = fmaxf(maximum[0], geometry[i].x);
+        maximum[1] = fmaxf(maximum[1], geometry[i].y);
+        maximum[2] = fmaxf(maximum[2], geometry[i].z);
+    }
+
+    float sphere[4] = {(minimum[0] + maximum[0]) * 0.5f, (minimum[1] + maximum[1]) * 0.5f, (minimum[2] + maximum[2]) * 0.5f, 0.0f};
+
+    for(int i = 0; i < count; ++i)
+    {
+        float x = geometry[i].x - sphere[0];
+        float y = geometry[i].y - sphere[1];
+        float z = geometry[i].z - sphere[2];
+        sphere[3] = fmaxf(sphere[3], sqrtf(x * x + y * y + z * z));
+    }
+
+    // Whole instances outside the view frustum are dropped before any vertex work.
+    const float *modelviewProjection = swGetModelviewProjection(context);
+    commands->visibleInstances.resize(instanceCount);
+    int *visible = commands->visibleInstances.data();
+    int visibleCount = swCullInstances(context, modelviewProjection, sphere, 0, matrices, instanceCount, visible);
+
+    alignas(16) float model[16]; // Copied, the matrices of the caller need not be aligned.
+    alignas(16) float matrix[16];
+
+    for(int next = 0; next < visibleCount; ++next)
+    {
+        int instance = visible[next];
+        memcpy(model, &matrices[instance * 16], sizeof(model));
+        swMatrixMultiply(matrix, modelviewProjection, model);
+        transformVertices(context, matrix, geometry, count, transformed);
+
+        if(instanceColors)
+        {
+            const float *color = &instanceColors[instance * 3];
+
+            for(int i = 0; i < count; ++i)
+            {
+                transformed[i].clip.r = transformed[i].window.r = color[0];
+                transformed[i].clip.g = transformed[i].window.g = color[1];
+                transformed[i].clip.b = transformed[i].window.b = color[2];
+            }
+        }
+
+        for(int i = 0; i < count; i += primitiveSize)
+        {
+            context->stats.primitivesSubmitted++;
+            drawPrimitive(context, &transformed[i], primitiveSize);
+        }
+    }
+
+    return TRUE;
+}
+
+void swDrawVertices(SWGLContext *context, const float *matrix, GLenum mode, const SWRecordedVertex *vertices, int vertexCount)
+{
+    int primitiveSize = mode == GL_QUADS ? 4 : 3;
+    int count = vertexCount / primitiveSize * primitiveSize;
+    const int chunkSize = SW_BATCH_VERTICES / 12 * 12; // Whole triangles and quads.
+    SWTransformedVertex *transformed = context->commands->transformed;
+
+    if(replayDraw(context, matrix, mode, vertices, count, 0, NULL, 0))
+    {
+        return;
+    }
+
+    for(int first = 0; first < count; first += chunkSize)
+    {
+        int chunk = count - first < chunkSize ? count - first : chunkSize;
+        transformVertices(context, matrix, &vertices[first], chunk, transformed);
+
+        for(int i = 0; i < chunk; i += primitiveSize)
+        {
+            context->stats.primitivesSubmitted++;
+            drawPrimitive(context, &transformed[i], primitiveSize);
+        }
+    }
+
+    swRecordDraw(context);
+}
+
+// Signed distance of a vertex to one of the clip planes, positive inside.
+static float planeDistance(const SWVertex *vertex, int plane, float guardBandX, float guardBandY)
+{
+    switch(plane)
+    {
+        case 0: return guardBandX * vertex->w + vertex->x;
+        case 1: return guardBandX * vertex->w - vertex->x;
+        case 2: return guardBandY * vertex->w + vertex->y;
+        case 3: return guardBandY * vertex->w - vertex->y;
+        case 4: return vertex->w + vertex->z;
+        default: return vertex->w - vertex->z;
+    }
+}
+
+static SWVertex lerpVertex(const SWVertex *a, const SWVertex *b, float t)
+{
+    SWVertex result;
+    result.x = a->x + (b->x - a->x) * t;
+    result.y = a->y + (b->y - a->y) * t;
+    result.z = a->z + (b->z - a->z) * t;
+    result.w = a->w + (b->w - a->w) * t;
+    result.r = a->r + (b->r - a->r) * t;
+    result.g = a->g + (b->g - a->g) * t;
+    result.b = a->b + (b->b - a->b) * t;
+    return result;
+}
+
+// Sutherland-Hodgman clipping of a convex polygon against the planes in clipMask.
+// Returns the number of vertices left in polygon.
+static int clipPolygon(SWVertex *polygon, int count, unsigned int clipMask, float guardBandX, float guardBandY)
+{
+    SWVertex clipped[SW_MAX_CLIP_VERTICES];
+
+    for(int plane = 0; plane < 6 && count > 0; ++plane)
+    {
+        if(!(clipMask & (1u << plane)))
+        {
+            continue;
+        }
+
+        int clippedCount = 0;
+
+        for(int i = 0; i < count; ++i)
+        {
+            const SWVertex *current = &polygon[i];
+            const SWVertex *next = &polygon[(i + 1) % count];
+            float currentDistance = planeDistance(current, plane, guardBandX, guardBandY);
+            float nextDistance = planeDistance(next, plane, guardBandX, guardBandY);
+
+            if(currentDistance >= 0.0f)
+            {
+                clipped[clippedCount++] = *current;
+            }
+
+            // Edge crosses the plane, emit the intersection point.
+            if((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+            {
+                float t = currentDistance / (currentDistance - nextDistance);
+                clipped[clippedCount++] = lerpVertex(current, next, t);
+            }
+        }
+
+        for(int i = 0; i < clippedCount; ++i)
+        {
+            polygon[i] = clipped[i];
+        }
+
+        count = clippedCount;
+    }
+
+    return count;
+}
+
+void swDrawTriangle(SWGLContext *context, const SWTransformedVertex *v0, const SWTransformedVertex *v1, const SWTransformedVertex *v2)
+{
+    // All vertices outside the same plane, nothing is visible.
+    if(v0->clipCode & v1->clipCode & v2->clipCode)
+    {
+        return;
+    }
+
+    unsigned int clipMask = (v0->clipCode | v1->clipCode | v2->clipCode) & SW_CLIP_PLANES;
+
+    // Inside the guard band, the geometry stage already computed the window coordinates.
+    if(!clipMask)
+    {
+        swSubmitTriangle(context, &v0->window, &v1->window, &v2->window);
+        return;
+    }
+
+    SWVertex polygon[SW_MAX_CLIP_VERTICES];
+    polygon[0] = v0->clip;
+    polygon[1] = v1->clip;
+    polygon[2] = v2->clip;
+
+    float guardBandX = swGuardBand ? context->guardBandX : 1.0f;
+    float guardBandY = swGuardBand ? context->guardBandY : 1.0f;
+    int count = clipPolygon(polygon, 3, clipMask, guardBandX, guardBandY);
+    context->stats.trianglesClipped++;
+
+    if(count < 3)
+    {
+        return;
+    }
+
+    SWScreenVertex screen[SW_MAX_CLIP_VERTICES];
+
+    for(int i = 0; i < count; ++i)
+    {
+        swToWindow(context, &polygon[i], &screen[i]);
+    }
+
+    // Clipped polygon is convex, draw it as a fan.
+    for(int i = 1; i < count - 1; ++i)
+    {
+        swSubmitTriangle(context, &screen[0], &screen[i], &screen[i + 1]);
+    }
+}
+
+void swDrawQuad(SWGLContext *context, const SWTransformedVertex *v0, const SWTransformedVertex *v1, const SWTransformedVertex *v2, const SWTransformedVertex *v3)
+{
+    if(v0->clipCode & v1->clipCode & v2->clipCode & v3->clipCode)
+    {
+        return;
+    }
+
+    // A quad crossing a clip plane is split, each half is clipped on its own.
+    if(!swNativeQuads || ((v0->clipCode | v1->clipCode | v2->clipCode | v3->clipCode) & SW_CLIP_PLANES))
+    {
+        swDrawTriangle(context, v0, v1, v2);
+        swDrawTriangle(context, v0, v2, v3);
+        return;
+    }
+
+    swSubmitQuad(context, &v0->window, &v1->window, &v2->window, &v3->window);
+}
+
+// The guard band extends as far around the viewport center as window coordinates stay within SW_GUARD_BAND,
+// and is never narrower than the viewport.
+void swUpdateGuardBand(SWGLContext *context)
+{
+    float halfWidth = context->viewportWidth * 0.5f;
+    float halfHeight = context->viewportHeight * 0.5f;
+    float roomX = SW_GUARD_BAND - fabsf(context->viewportX + halfWidth);
+    float roomY = SW_GUARD_BAND - fabsf(context->viewportY + halfHeight);
+
+    context->guardBandX = roomX > halfWidth ? roomX / halfWidth : 1.0f;
+    context->guardBandY = roomY > halfHeight ? roomY / halfHeight : 1.0f;
+}
+
+int swglSetNativeQuads(int enable)
+{
+    swNativeQuads = enable != FALSE;
+    return TRUE;
+}
+
+int swglSetGuardBand(int enable)
+{
+    swGuardBand = enable != FALSE;
+    return TRUE;
+}
+
+int swglSetVertexBatching(int enable)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(context && context->insideBeginEnd)
+    {
+        return FALSE;
+    }
+
+    if(context)
+    {
+        swFlushVertices(context);
+    }
+
+    swVertexBatching = enable != FALSE;
+    return TRUE;
+}
+
+int swglSetVertexCache(int enable)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(context && context->insideBeginEnd)
+    {
+        return FALSE;
+    }
+
+    swVertexCache = enable != FALSE;
+    return TRUE;
+}
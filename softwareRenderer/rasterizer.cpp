@@ -0,0 +1,957 @@
+// Half-space rasterizer of triangles and convex quads of the software renderer.
+
+#include <math.h>
+#include <string.h>
+
+#include "rasterizer.h"
+
+#define SW_QUAD_PLANE_TOLERANCE 1e-5 // Relative rounding error allowed at the fourth vertex of a quad drawn as one primitive.
+
+// Builds the plane equation of an attribute from its values at the three vertices.
+static SWPlane setupPlane(const float *x, const float *y, float f0, float f1, float f2, double inverseArea, float originX, float originY)
+{
+    double dx = ((double)(f1 - f0) * (y[2] - y[0]) - (double)(f2 - f0) * (y[1] - y[0])) * inverseArea;
+    double dy = ((double)(f2 - f0) * (x[1] - x[0]) - (double)(f1 - f0) * (x[2] - x[0])) * inverseArea;
+
+    SWPlane plane;
+    plane.base = (float)(f0 + dx * (originX - x[0]) + dy * (originY - y[0]));
+    plane.dx = (float)dx;
+    plane.dy = (float)dy;
+    return plane;
+}
+
+static inline bool depthPasses(GLenum func, float depth, float stored)
+{
+    switch(func)
+    {
+        case GL_NEVER: return false;
+        case GL_LESS: return depth < stored;
+        case GL_EQUAL: return depth == stored;
+        case GL_LEQUAL: return depth <= stored;
+        case GL_GREATER: return depth > stored;
+        case GL_NOTEQUAL: return depth != stored;
+        case GL_GEQUAL: return depth >= stored;
+        default: return true;
+    }
+}
+
+static inline unsigned int packChannel(float value)
+{
+    // Keep value in range of 0.0f to 1.0f, NaN ends up as 0.
+    value = value > 0.0f ? value : 0.0f;
+    value = value < 1.0f ? value : 1.0f;
+    return (unsigned int)(value * 255.0f + 0.5f);
+}
+
+SWBlockResult swRasterizeBlockScalar(const SWPrimitiveSetup *setup, const SWBlock *block, const SWBlockTarget *target)
+{
+    SWBlockResult result = {0, 0};
+
+    for(int row = block->firstRow; row <= block->lastRow; ++row)
+    {
+        int edge0 = block->edge[0] + row * block->edgeStepY[0];
+        int edge1 = block->edge[1] + row * block->edgeStepY[1];
+        int edge2 = block->edge[2] + row * block->edgeStepY[2];
+        int edge3 = block->edge[3] + row * block->edgeStepY[3];
+        float y = (float)(block->row + row);
+        float rowDepth = setup->depth.base + setup->depth.dy * y;
+        float rowRed = setup->red.base + setup->red.dy * y;
+        float rowGreen = setup->green.base + setup->green.dy * y;
+        float rowBlue = setup->blue.base + setup->blue.dy * y;
+        float rowInverseW = setup->inverseW.base + setup->inverseW.dy * y;
+        unsigned int *color = target->color + row * target->stride;
+        float *depth = target->depth + row * target->stride;
+
+        for(int column = 0; column < SW_BLOCK_SIZE; ++column)
+        {
+            bool covered = ((block->columnMask >> column) & 1) != 0;
+
+            if(!block->fullyCovered)
+            {
+                int coverage = (edge0 + column * block->edgeStepX[0])
+                    | (edge1 + column * block->edgeStepX[1])
+                    | (edge2 + column * block->edgeStepX[2])
+                    | (edge3 + column * block->edgeStepX[3]);
+                covered = covered && coverage >= 0;
+            }
+
+            if(!covered)
+            {
+                continue;
+            }
+
+            result.tested++;
+
+            float x = (float)(block->column + column);
+            float z = rowDepth + setup->depth.dx * x;
+
+            if(target->depthTest)
+            {
+                if(!depthPasses(target->depthFunc, z, depth[column]))
+                {
+                    continue;
+                }
+
+                depth[column] = z;
+            }
+
+            if(setup->colorMode == SW_COLOR_FLAT)
+            {
+                color[column] = setup->flatColor;
+                result.written++;
+                continue;
+            }
+
+            float red = rowRed + setup->red.dx * x;
+            float green = rowGreen + setup->green.dx * x;
+            float blue = rowBlue + setup->blue.dx * x;
+
+            if(setup->colorMode == SW_COLOR_PERSPECTIVE)
+            {
+                float w = 1.0f / (rowInverseW + setup->inverseW.dx * x);
+                red *= w;
+                green *= w;
+                blue *= w;
+            }
+
+            color[column] = 0xFF000000u | (packChannel(red) << 16) | (packChannel(green) << 8) | packChannel(blue);
+            result.written++;
+        }
+    }
+
+    return result;
+}
+
+// Window coordinates on the sub-pixel grid, snapped by the geometry stage. Returns false when a vertex is too far
+// outside the framebuffer for the edge functions, or not a number.
+static bool snapVertices(const SWScreenVertex *const *vertices, int count, long long *fixedX, long long *fixedY)
+{
+    for(int i = 0; i < count; ++i)
+    {
+        if(vertices[i]->fixedX == SW_INVALID_COORDINATE || vertices[i]->fixedY == SW_INVALID_COORDINATE)
+        {
+            return false;
+        }
+
+        fixedX[i] = vertices[i]->fixedX;
+        fixedY[i] = vertices[i]->fixedY;
+    }
+
+    return true;
+}
+
+// Twice the signed area of a triangle in sub-pixel units, positive when counter-clockwise.
+static inline long long doubleArea(const long long *fixedX, const long long *fixedY, int i0, int i1, int i2)
+{
+    return (fixedX[i1] - fixedX[i0]) * (fixedY[i2] - fixedY[i0]) - (fixedX[i2] - fixedX[i0]) * (fixedY[i1] - fixedY[i0]);
+}
+
+// Bounding box of the pixel centers, clamped to the viewport and the framebuffer. Returns false when it is empty.
+// Primitives are only clipped to the guard band, the clamp scissors them to the viewport.
+static bool setupBoundingBox(const SWGLContext *context, const long long *fixedX, const long long *fixedY, int count, SWPrimitiveSetup *setup)
+{
+    long long minFixedX = fixedX[0];
+    long long maxFixedX = fixedX[0];
+    long long minFixedY = fixedY[0];
+    long long maxFixedY = fixedY[0];
+
+    for(int i = 1; i < count; ++i)
+    {
+        minFixedX = fixedX[i] < minFixedX ? fixedX[i] : minFixedX;
+        maxFixedX = fixedX[i] > maxFixedX ? fixedX[i] : maxFixedX;
+        minFixedY = fixedY[i] < minFixedY ? fixedY[i] : minFixedY;
+        maxFixedY = fixedY[i] > maxFixedY ? fixedY[i] : maxFixedY;
+    }
+
+    const long long halfPixel = SW_SUBPIXEL_SCALE / 2;
+    long long minX = (minFixedX - halfPixel + SW_SUBPIXEL_SCALE - 1) >> SW_SUBPIXEL_BITS;
+    long long maxX = (maxFixedX - halfPixel) >> SW_SUBPIXEL_BITS;
+    long long minY = (minFixedY - halfPixel + SW_SUBPIXEL_SCALE - 1) >> SW_SUBPIXEL_BITS;
+    long long maxY = (maxFixedY - halfPixel) >> SW_SUBPIXEL_BITS;
+
+    long long scissorMinX = context->viewportX > 0 ? context->viewportX : 0;
+    long long scissorMinY = context->viewportY > 0 ? context->viewportY : 0;
+    long long scissorMaxX = (long long)context->viewportX + context->viewportWidth - 1;
+    long long scissorMaxY = (long long)context->viewportY + context->viewportHeight - 1;
+    scissorMaxX = scissorMaxX < context->framebuffer.width - 1 ? scissorMaxX : context->framebuffer.width - 1;
+    scissorMaxY = scissorMaxY < context->framebuffer.height - 1 ? scissorMaxY : context->framebuffer.height - 1;
+
+    minX = minX < scissorMinX ? scissorMinX : minX;
+    minY = minY < scissorMinY ? scissorMinY : minY;
+    maxX = maxX > scissorMaxX ? scissorMaxX : maxX;
+    maxY = maxY > scissorMaxY ? scissorMaxY : maxY;
+
+    if(minX > maxX || minY > maxY)
+    {
+        return false;
+    }
+
+    setup->minX = (int)minX;
+    setup->minY = (int)minY;
+    setup->maxX = (int)maxX;
+    setup->maxY = (int)maxY;
+    return true;
+}
+
+// Edge functions of a counter-clockwise convex polygon. Edges past the last vertex are 0, they accept every pixel.
+static void setupEdges(const long long *fixedX, const long long *fixedY, int count, SWPrimitiveSetup *setup)
+{
+    const long long halfPixel = SW_SUBPIXEL_SCALE / 2;
+
+    // Edge functions E = a * px + b * py + c for sub-pixel positions, rewritten for pixel centers.
+    // The top-left fill rule is applied by biasing c so that shared edges are drawn exactly once.
+    for(int i = 0; i < count; ++i)
+    {
+        int next = (i + 1) % count;
+        long long a = fixedY[i] - fixedY[next];
+        long long b = fixedX[next] - fixedX[i];
+        long long c = fixedX[i] * fixedY[next] - fixedY[i] * fixedX[next];
+        bool topLeft = a > 0 || (a == 0 && b < 0);
+
+        setup->edgeStepX[i] = a * SW_SUBPIXEL_SCALE;
+        setup->edgeStepY[i] = b * SW_SUBPIXEL_SCALE;
+        // An edge of length zero, where two quad vertices coincide, does not bound anything.
+        setup->edgeC[i] = a == 0 && b == 0 ? 0 : (a + b) * halfPixel + c + (topLeft ? 0 : -1);
+    }
+
+    for(int i = count; i < SW_MAX_EDGES; ++i)
+    {
+        setup->edgeC[i] = 0;
+        setup->edgeStepX[i] = 0;
+        setup->edgeStepY[i] = 0;
+    }
+}
+
+static inline bool sameColor(const SWScreenVertex *a, const SWScreenVertex *b)
+{
+    return a->r == b->r && a->g == b->g && a->b == b->b;
+}
+
+// Depth and color planes from three counter-clockwise vertices with the given doubled area, based at the
+// center of the first pixel of the bounding box.
+static void setupAttributes(const SWGLContext *context, const SWScreenVertex *const *vertices, const long long *fixedX, const long long *fixedY,
+    long long area, bool flat, SWPrimitiveSetup *setup)
+{
+    float x[3];
+    float y[3];
+
+    for(int i = 0; i < 3; ++i)
+    {
+        x[i] = (float)fixedX[i] / SW_SUBPIXEL_SCALE;
+        y[i] = (float)fixedY[i] / SW_SUBPIXEL_SCALE;
+    }
+
+    double inverseArea = (double)(SW_SUBPIXEL_SCALE * SW_SUBPIXEL_SCALE) / (double)area;
+    float originX = (float)setup->minX + 0.5f;
+    float originY = (float)setup->minY + 0.5f;
+    setup->depth = setupPlane(x, y, vertices[0]->z, vertices[1]->z, vertices[2]->z, inverseArea, originX, originY);
+
+    // A single color, from glShadeModel(GL_FLAT) or from one glColor3f() for all vertices, is stored as is.
+    if(flat)
+    {
+        SWPlane unused = {0.0f, 0.0f, 0.0f};
+        setup->red = unused;
+        setup->green = unused;
+        setup->blue = unused;
+        setup->inverseW = unused;
+        setup->colorMode = SW_COLOR_FLAT;
+        setup->flatColor = 0xFF000000u | (packChannel(vertices[0]->r) << 16) | (packChannel(vertices[0]->g) << 8) | packChannel(vertices[0]->b);
+        return;
+    }
+
+    // Window space depth is linear in screen space, colors are linear in eye space. With perspective correction
+    // color / w and 1 / w are interpolated instead, and divided per pixel. Dividing 1 / w by its value at the first
+    // vertex keeps it close to 1.0, the factor cancels out in the division.
+    float inverseW[3];
+
+    for(int i = 0; i < 3; ++i)
+    {
+        inverseW[i] = vertices[i]->inverseW / vertices[0]->inverseW;
+    }
+
+    bool perspective = context->perspectiveHint != GL_FASTEST && (inverseW[1] != 1.0f || inverseW[2] != 1.0f);
+    setup->colorMode = perspective ? SW_COLOR_PERSPECTIVE : SW_COLOR_AFFINE;
+
+    if(perspective)
+    {
+        setup->red = setupPlane(x, y, vertices[0]->r * inverseW[0], vertices[1]->r * inverseW[1], vertices[2]->r * inverseW[2], inverseArea, originX, originY);
+        setup->green = setupPlane(x, y, vertices[0]->g * inverseW[0], vertices[1]->g * inverseW[1], vertices[2]->g * inverseW[2], inverseArea, originX, originY);
+        setup->blue = setupPlane(x, y, vertices[0]->b * inverseW[0], vertices[1]->b * inverseW[1], vertices[2]->b * inverseW[2], inverseArea, originX, originY);
+        setup->inverseW = setupPlane(x, y, inverseW[0], inverseW[1], inverseW[2], inverseArea, originX, originY);
+    }
+    else
+    {
+        setup->red = setupPlane(x, y, vertices[0]->r, vertices[1]->r, vertices[2]->r, inverseArea, originX, originY);
+        setup->green = setupPlane(x, y, vertices[0]->g, vertices[1]->g, vertices[2]->g, inverseArea, originX, originY);
+        setup->blue = setupPlane(x, y, vertices[0]->b, vertices[1]->b, vertices[2]->b, inverseArea, originX, originY);
+        setup->inverseW.base = 1.0f;
+        setup->inverseW.dx = 0.0f;
+        setup->inverseW.dy = 0.0f;
+    }
+}
+
+bool swSetupTriangle(const SWGLContext *context, const SWScreenVertex *v0, const SWScreenVertex *v1, const SWScreenVertex *v2, SWPrimitiveSetup *setup)
+{
+    const SWScreenVertex *vertices[3] = {v0, v1, v2};
+    long long fixedX[3];
+    long long fixedY[3];
+
+    if(!snapVertices(vertices, 3, fixedX, fixedY))
+    {
+        return false;
+    }
+
+    long long area = doubleArea(fixedX, fixedY, 0, 1, 2);
+
+    if(area == 0)
+    {
+        return false; // Degenerate triangle covers no pixel.
+    }
+
+    // Make the winding counter-clockwise so the inside of every edge is positive.
+    if(area < 0)
+    {
+        const SWScreenVertex *vertex = vertices[1];
+        vertices[1] = vertices[2];
+        vertices[2] = vertex;
+
+        long long swap = fixedX[1];
+        fixedX[1] = fixedX[2];
+        fixedX[2] = swap;
+        swap = fixedY[1];
+        fixedY[1] = fixedY[2];
+        fixedY[2] = swap;
+        area = -area;
+    }
+
+    if(!setupBoundingBox(context, fixedX, fixedY, 3, setup))
+    {
+        return false;
+    }
+
+    setup->depthTest = context->depthTest;
+    setup->depthFunc = context->depthFunc;
+    setupEdges(fixedX, fixedY, 3, setup);
+    setupAttributes(context, vertices, fixedX, fixedY, area, sameColor(v0, v1) && sameColor(v0, v2), setup);
+    return true;
+}
+
+// Whether the plane through three vertices, with the given doubled area, also contains the value f3 at a fourth
+// vertex. Snapping moves every vertex by up to half a sub-pixel, so the plane may miss f3 by its change over one
+// sub-pixel, on top of the rounding of the attributes.
+static bool planeContains(const long long *fixedX, const long long *fixedY, long long area, float f0, float f1, float f2, long long x3, long long y3, float f3)
+{
+    double dx = ((double)(f1 - f0) * (fixedY[2] - fixedY[0]) - (double)(f2 - f0) * (fixedY[1] - fixedY[0])) / (double)area;
+    double dy = ((double)(f2 - f0) * (fixedX[1] - fixedX[0]) - (double)(f1 - f0) * (fixedX[2] - fixedX[0])) / (double)area;
+    double predicted = f0 + dx * (double)(x3 - fixedX[0]) + dy * (double)(y3 - fixedY[0]);
+    return fabs(predicted - f3) <= fabs(dx) + fabs(dy) + SW_QUAD_PLANE_TOLERANCE * (1.0 + fabs((double)f3));
+}
+
+bool swSetupQuad(const SWGLContext *context, const SWScreenVertex *v0, const SWScreenVertex *v1, const SWScreenVertex *v2, const SWScreenVertex *v3, SWPrimitiveSetup *setup)
+{
+    const SWScreenVertex *vertices[4] = {v0, v1, v2, v3};
+    long long fixedX[4];
+    long long fixedY[4];
+
+    if(!snapVertices(vertices, 4, fixedX, fixedY))
+    {
+        return false;
+    }
+
+    long long firstArea = doubleArea(fixedX, fixedY, 0, 1, 2);
+    long long secondArea = doubleArea(fixedX, fixedY, 0, 2, 3);
+
+    // Reverse a clockwise quad, keeping the first vertex.
+    if(firstArea + secondArea < 0)
+    {
+        const SWScreenVertex *vertex = vertices[1];
+        vertices[1] = vertices[3];
+        vertices[3] = vertex;
+
+        long long swap = fixedX[1];
+        fixedX[1] = fixedX[3];
+        fixedX[3] = swap;
+        swap = fixedY[1];
+        fixedY[1] = fixedY[3];
+        fixedY[3] = swap;
+
+        swap = firstArea;
+        firstArea = -secondArea;
+        secondArea = -swap;
+    }
+
+    if(firstArea + secondArea <= 0)
+    {
+        return false;
+    }
+
+    // Convex when no corner turns clockwise. Both halves then have a non-negative area.
+    for(int i = 0; i < 4; ++i)
+    {
+        if(doubleArea(fixedX, fixedY, i, (i + 1) % 4, (i + 2) % 4) < 0)
+        {
+            return false;
+        }
+    }
+
+    // Attribute planes from the larger half, they must also hold at the fourth vertex.
+    const SWScreenVertex *half[3];
+    long long halfX[3];
+    long long halfY[3];
+    int indices[4] = {0, 1, 2, 3};
+
+    if(secondArea > firstArea)
+    {
+        indices[0] = 0;
+        indices[1] = 2;
+        indices[2] = 3;
+        indices[3] = 1;
+    }
+
+    for(int i = 0; i < 3; ++i)
+    {
+        half[i] = vertices[indices[i]];
+        halfX[i] = fixedX[indices[i]];
+        halfY[i] = fixedY[indices[i]];
+    }
+
+    const SWScreenVertex *fourth = vertices[indices[3]];
+    long long fourthX = fixedX[indices[3]];
+    long long fourthY = fixedY[indices[3]];
+    long long area = secondArea > firstArea ? secondArea : firstArea;
+
+    if(!planeContains(halfX, halfY, area, half[0]->z, half[1]->z, half[2]->z, fourthX, fourthY, fourth->z))
+    {
+        return false;
+    }
+
+    bool flat = sameColor(v0, v1) && sameColor(v0, v2) && sameColor(v0, v3);
+
+    if(!flat)
+    {
+        float inverseW[4];
+
+        for(int i = 0; i < 3; ++i)
+        {
+            inverseW[i] = half[i]->inverseW / half[0]->inverseW;
+        }
+
+        inverseW[3] = fourth->inverseW / half[0]->inverseW;
+        bool perspective = context->perspectiveHint != GL_FASTEST && (inverseW[1] != 1.0f || inverseW[2] != 1.0f);
+
+        if(perspective)
+        {
+            if(!planeContains(halfX, halfY, area, inverseW[0], inverseW[1], inverseW[2], fourthX, fourthY, inverseW[3])
+                || !planeContains(halfX, halfY, area, half[0]->r * inverseW[0], half[1]->r * inverseW[1], half[2]->r * inverseW[2], fourthX, fourthY, fourth->r * inverseW[3])
+                || !planeContains(halfX, halfY, area, half[0]->g * inverseW[0], half[1]->g * inverseW[1], half[2]->g * inverseW[2], fourthX, fourthY, fourth->g * inverseW[3])
+                || !planeContains(halfX, halfY, area, half[0]->b * inverseW[0], half[1]->b * inverseW[1], half[2]->b * inverseW[2], fourthX, fourthY, fourth->b * inverseW[3]))
+            {
+                return false;
+            }
+        }
+        else if((context->perspectiveHint != GL_FASTEST && inverseW[3] != 1.0f)
+            || !planeContains(halfX, halfY, area, half[0]->r, half[1]->r, half[2]->r, fourthX, fourthY, fourth->r)
+            || !planeContains(halfX, halfY, area, half[0]->g, half[1]->g, half[2]->g, fourthX, fourthY, fourth->g)
+            || !planeContains(halfX, halfY, area, half[0]->b, half[1]->b, half[2]->b, fourthX, fourthY, fourth->b))
+        {
+            return false;
+        }
+    }
+
+    if(!setupBoundingBox(context, fixedX, fixedY, 4, setup))
+    {
+        return false;
+    }
+
+    setup->depthTest = context->depthTest;
+    setup->depthFunc = context->depthFunc;
+    setupEdges(fixedX, fixedY, 4, setup);
+    setupAttributes(context, half, halfX, halfY, area, flat, setup);
+    return true;
+}
+
+// Classifies the 8x8 block at (blockX, blockY) against the edges.
+// Returns false when an edge rejects the whole block.
+static bool setupBlock(const SWPrimitiveSetup *setup, int blockX, int blockY, SWBlock *block)
+{
+    const long long last = SW_BLOCK_SIZE - 1;
+    block->fullyCovered = true;
+
+    for(int i = 0; i < SW_MAX_EDGES; ++i)
+    {
+        long long stepX = setup->edgeStepX[i];
+        long long stepY = setup->edgeStepY[i];
+        long long edge = setup->edgeC[i] + blockX * stepX + blockY * stepY;
+
+        // The edge function is linear, its extremes over the block are at the corners.
+        long long minEdge = edge + (stepX < 0 ? stepX * last : 0) + (stepY < 0 ? stepY * last : 0);
+        long long maxEdge = edge + (stepX > 0 ? stepX * last : 0) + (stepY > 0 ? stepY * last : 0);
+
+        if(maxEdge < 0)
+        {
+            return false;
+        }
+
+        if(minEdge >= 0)
+        {
+            block->edge[i] = 0;
+            block->edgeStepX[i] = 0;
+            block->edgeStepY[i] = 0;
+        }
+        else
+        {
+            // The edge crosses the block, so its values stay within the variation over 8x8 pixels.
+            block->edge[i] = (int)edge;
+            block->edgeStepX[i] = (int)stepX;
+            block->edgeStepY[i] = (int)stepY;
+            block->fullyCovered = false;
+        }
+    }
+
+    return true;
+}
+
+// Results of the hierarchical depth test of a region.
+#define SW_HIZ_TEST 0 // Pixels need the per-pixel depth test.
+#define SW_HIZ_REJECT 1 // No pixel can pass the depth test.
+#define SW_HIZ_ACCEPT 2 // Every pixel passes the depth test.
+
+// Range of the depths the kernels compute for the pixels columnA to columnB and rowA to rowB of the bounding box.
+// The depth plane is linear and rounding is monotonic, so the extremes are at the corners.
+// Returns false when a corner is not finite, then nothing is known about the pixels in between.
+static bool triangleDepthRange(const SWPlane *plane, int columnA, int rowA, int columnB, int rowB, SWDepthRange *range)
+{
+    float rowDepthA = plane->base + plane->dy * (float)rowA;
+    float rowDepthB = plane->base + plane->dy * (float)rowB;
+    float corners[4] = {
+        rowDepthA + plane->dx * (float)columnA, rowDepthA + plane->dx * (float)columnB,
+        rowDepthB + plane->dx * (float)columnA, rowDepthB + plane->dx * (float)columnB
+    };
+
+    range->min = corners[0];
+    range->max = corners[0];
+
+    for(int i = 0; i < 4; ++i)
+    {
+        if(!isfinite(corners[i]))
+        {
+            return false;
+        }
+
+        range->min = corners[i] < range->min ? corners[i] : range->min;
+        range->max = corners[i] > range->max ? corners[i] : range->max;
+    }
+
+    return true;
+}
+
+static int hierarchicalDepthTest(GLenum func, const SWDepthRange *triangle, const SWDepthRange *stored)
+{
+    switch(func)
+    {
+        case GL_LESS:
+            return triangle->min >= stored->max ? SW_HIZ_REJECT : (triangle->max < stored->min ? SW_HIZ_ACCEPT : SW_HIZ_TEST);
+
+        case GL_LEQUAL:
+            return triangle->min > stored->max ? SW_HIZ_REJECT : (triangle->max <= stored->min ? SW_HIZ_ACCEPT : SW_HIZ_TEST);
+
+        case GL_GREATER:
+            return triangle->max <= stored->min ? SW_HIZ_REJECT : (triangle->min > stored->max ? SW_HIZ_ACCEPT : SW_HIZ_TEST);
+
+        case GL_GEQUAL:
+            return triangle->max < stored->min ? SW_HIZ_REJECT : (triangle->min >= stored->max ? SW_HIZ_ACCEPT : SW_HIZ_TEST);
+
+        default:
+            return SW_HIZ_TEST;
+    }
+}
+
+// Exact range of the depths stored in the first rows and columns of a block, which must all be finite.
+static SWDepthRange storedDepthRange(const float *depth, int stride, int columns, int rows)
+{
+    // Per-column extremes first, so that the full width case compiles to vector minimum and maximum.
+    float columnMin[SW_BLOCK_SIZE];
+    float columnMax[SW_BLOCK_SIZE];
+
+    for(int column = 0; column < SW_BLOCK_SIZE; ++column)
+    {
+        columnMin[column] = depth[column < columns ? column : 0];
+        columnMax[column] = columnMin[column];
+    }
+
+    if(columns == SW_BLOCK_SIZE)
+    {
+        for(int row = 1; row < rows; ++row)
+        {
+            for(int column = 0; column < SW_BLOCK_SIZE; ++column)
+            {
+                float value = depth[row * stride + column];
+                columnMin[column] = value < columnMin[column] ? value : columnMin[column];
+                columnMax[column] = value > columnMax[column] ? value : columnMax[column];
+            }
+        }
+    }
+    else
+    {
+        for(int row = 1; row < rows; ++row)
+        {
+            for(int column = 0; column < columns; ++column)
+            {
+                float value = depth[row * stride + column];
+                columnMin[column] = value < columnMin[column] ? value : columnMin[column];
+                columnMax[column] = value > columnMax[column] ? value : columnMax[column];
+            }
+        }
+    }
+
+    SWDepthRange range = {columnMin[0], columnMax[0]};
+
+    for(int column = 1; column < SW_BLOCK_SIZE; ++column)
+    {
+        range.min = columnMin[column] < range.min ? columnMin[column] : range.min;
+        range.max = columnMax[column] > range.max ? columnMax[column] : range.max;
+    }
+
+    return range;
+}
+
+static inline long long floorDivide(long long numerator, long long denominator)
+{
+    long long quotient = numerator / denominator;
+    return (numerator % denominator != 0 && numerator < 0) ? quotient - 1 : quotient;
+}
+
+// Number of pixels of the rectangle minX to maxX, minY to maxY covered by the primitive.
+// Counts the covered span of every row from the edge functions, without touching the framebuffer.
+static long long countCoverage(const SWPrimitiveSetup *setup, int minX, int minY, int maxX, int maxY)
+{
+    // Where edge i crosses the row is floor(E(0, y) / |edgeStepX|), kept as quotient and remainder
+    // that are stepped from row to row.
+    long long divisor[SW_MAX_EDGES];
+    long long quotient[SW_MAX_EDGES];
+    long long remainder[SW_MAX_EDGES];
+    long long quotientStep[SW_MAX_EDGES];
+    long long remainderStep[SW_MAX_EDGES];
+
+    for(int i = 0; i < SW_MAX_EDGES; ++i)
+    {
+        long long edge = setup->edgeC[i] + minY * setup->edgeStepY[i];
+        divisor[i] = setup->edgeStepX[i] < 0 ? -setup->edgeStepX[i] : setup->edgeStepX[i];
+
+        if(divisor[i])
+        {
+            quotient[i] = floorDivide(edge, divisor[i]);
+            remainder[i] = edge - quotient[i] * divisor[i];
+            quotientStep[i] = floorDivide(setup->edgeStepY[i], divisor[i]);
+            remainderStep[i] = setup->edgeStepY[i] - quotientStep[i] * divisor[i];
+        }
+        else
+        {
+            quotient[i] = edge; // Horizontal edge, only its sign matters.
+            quotientStep[i] = setup->edgeStepY[i];
+        }
+    }
+
+    long long count = 0;
+
+    for(int y = minY; y <= maxY; ++y)
+    {
+        long long first = minX;
+        long long last = maxX;
+
+        for(int i = 0; i < SW_MAX_EDGES; ++i)
+        {
+            if(setup->edgeStepX[i] > 0)
+            {
+                first = -quotient[i] > first ? -quotient[i] : first; // Inside from x = ceil(-E(0, y) / edgeStepX).
+            }
+            else if(setup->edgeStepX[i] < 0)
+            {
+                last = quotient[i] < last ? quotient[i] : last; // Inside up to x = floor(E(0, y) / -edgeStepX).
+            }
+            else if(quotient[i] < 0)
+            {
+                last = first - 1;
+            }
+
+            quotient[i] += quotientStep[i];
+
+            if(divisor[i])
+            {
+                remainder[i] += remainderStep[i];
+
+                if(remainder[i] >= divisor[i])
+                {
+                    remainder[i] -= divisor[i];
+                    quotient[i]++;
+                }
+            }
+        }
+
+        count += first <= last ? last - first + 1 : 0;
+    }
+
+    return count;
+}
+
+// Runs the kernel on one block. When validating, also runs the scalar reference on a copy of the block
+// and counts a mismatch when the two differ.
+static SWBlockResult runKernel(SWBlockKernel kernel, bool validate, const SWPrimitiveSetup *setup, const SWBlock *block,
+    const SWBlockTarget *target, SWGLFrameStats *stats)
+{
+    if(!validate)
+    {
+        return kernel(setup, block, target);
+    }
+
+    unsigned int referenceColor[SW_BLOCK_SIZE * SW_BLOCK_SIZE];
+    float referenceDepth[SW_BLOCK_SIZE * SW_BLOCK_SIZE];
+    int stride = target->stride;
+
+    for(int row = 0; row <= block->lastRow; ++row)
+    {
+        memcpy(referenceColor + row * SW_BLOCK_SIZE, target->color + row * stride, SW_BLOCK_SIZE * sizeof(unsigned int));
+        memcpy(referenceDepth + row * SW_BLOCK_SIZE, target->depth + row * stride, SW_BLOCK_SIZE * sizeof(float));
+    }
+
+    SWBlockTarget referenceTarget = *target;
+    referenceTarget.color = referenceColor;
+    referenceTarget.depth = referenceDepth;
+    referenceTarget.stride = SW_BLOCK_SIZE;
+
+    SWBlockResult reference = swRasterizeBlockScalar(setup, block, &referenceTarget);
+    SWBlockResult result = kernel(setup, block, target);
+    bool identical = reference.tested == result.tested && reference.written == result.written;
+
+    for(int row = 0; row <= block->lastRow && identical; ++row)
+    {
+        identical = !memcmp(referenceColor + row * SW_BLOCK_SIZE, target->color + row * stride, SW_BLOCK_SIZE * sizeof(unsigned int))
+            && !memcmp(referenceDepth + row * SW_BLOCK_SIZE, target->depth + row * stride, SW_BLOCK_SIZE * sizeof(float));
+    }
+
+    stats->kernelMismatches += identical ? 0 : 1;
+    return result;
+}
+
+void swRasterizePrimitiveTile(const SWPrimitiveSetup *setup, SWFramebuffer *framebuffer, SWTileState *tile, SWGLFrameStats *stats)
+{
+    // Part of the bounding box inside the tile.
+    int minX = setup->minX > tile->x0 ? setup->minX : tile->x0;
+    int minY = setup->minY > tile->y0 ? setup->minY : tile->y0;
+    int maxX = setup->maxX < tile->x1 - 1 ? setup->maxX : tile->x1 - 1;
+    int maxY = setup->maxY < tile->y1 - 1 ? setup->maxY : tile->y1 - 1;
+
+    if(minX > maxX || minY > maxY)
+    {
+        return;
+    }
+
+    // Test the whole tile first, a hidden primitive is dropped without visiting its blocks.
+    int tileTest = SW_HIZ_TEST;
+    SWDepthRange triangleDepth;
+
+    if(setup->depthTest && triangleDepthRange(&setup->depth, minX - setup->minX, minY - setup->minY, maxX - setup->minX, maxY - setup->minY, &triangleDepth))
+    {
+        tileTest = hierarchicalDepthTest(setup->depthFunc, &triangleDepth, &tile->depth);
+
+        if(tileTest == SW_HIZ_REJECT)
+        {
+            stats->fragmentsHiZRejected += countCoverage(setup, minX, minY, maxX, maxY);
+            return;
+        }
+    }
+
+    SWBlockKernel kernel = swGetBlockKernel(swglGetInstructionSet());
+    bool validate = swValidateKernels && kernel != swRasterizeBlockScalar;
+    int stride = framebuffer->stride;
+    bool depthChanged = false;
+
+    for(int blockY = minY & ~(SW_BLOCK_SIZE - 1); blockY <= maxY; blockY += SW_BLOCK_SIZE)
+    {
+        SWBlock block;
+        block.row = blockY - setup->minY;
+        block.firstRow = minY > blockY ? minY - blockY : 0;
+        block.lastRow = maxY - blockY < SW_BLOCK_SIZE - 1 ? maxY - blockY : SW_BLOCK_SIZE - 1;
+
+        SWDepthRange *blockDepthRow = framebuffer->blockDepth + (size_t)(blockY / SW_BLOCK_SIZE) * framebuffer->blocksX;
+        int validRows = framebuffer->height - blockY < SW_BLOCK_SIZE ? framebuffer->height - blockY : SW_BLOCK_SIZE;
+        int blockIndexRow = (blockY - tile->y0) / SW_BLOCK_SIZE * (SW_TILE_SIZE / SW_BLOCK_SIZE);
+
+        for(int blockX = minX & ~(SW_BLOCK_SIZE - 1); blockX <= maxX; blockX += SW_BLOCK_SIZE)
+        {
+            if(!setupBlock(setup, blockX, blockY, &block))
+            {
+                continue;
+            }
+
+            // Only columns inside the bounding box, which also excludes the row padding.
+            int firstColumn = minX > blockX ? minX - blockX : 0;
+            int lastColumn = maxX - blockX < SW_BLOCK_SIZE - 1 ? maxX - blockX : SW_BLOCK_SIZE - 1;
+            block.columnMask = ((1u << (lastColumn + 1)) - 1) & ~((1u << firstColumn) - 1);
+            block.column = blockX - setup->minX;
+
+            size_t offset = (size_t)blockY * stride + blockX;
+            SWBlockTarget target;
+            target.color = framebuffer->backBuffer + offset;
+            target.depth = framebuffer->depthBuffer + offset;
+            target.stride = stride;
+            target.depthTest = setup->depthTest;
+            target.depthFunc = setup->depthFunc;
+
+            SWDepthRange *blockDepth = blockDepthRow + blockX / SW_BLOCK_SIZE;
+            bool finiteDepth = false;
+            bool accepted = false;
+
+            if(setup->depthTest)
+            {
+                finiteDepth = triangleDepthRange(&setup->depth, block.column + firstColumn, block.row + block.firstRow,
+                    block.column + lastColumn, block.row + block.lastRow, &triangleDepth);
+                int test = tileTest;
+
+                if(test == SW_HIZ_TEST && finiteDepth)
+                {
+                    test = hierarchicalDepthTest(setup->depthFunc, &triangleDepth, blockDepth);
+                }
+
+                if(test == SW_HIZ_REJECT)
+                {
+                    stats->fragmentsHiZRejected += block.fullyCovered
+                        ? (unsigned long long)(swBitCount(block.columnMask) * (block.lastRow - block.firstRow + 1))
+                        : (unsigned long long)countCoverage(setup, blockX + firstColumn, blockY + block.firstRow, blockX + lastColumn, blockY + block.lastRow);
+                    continue;
+                }
+
+                if(test == SW_HIZ_ACCEPT)
+                {
+                    target.depthFunc = GL_ALWAYS; // Still writes depth, but skips the comparison.
+                    accepted = true;
+                }
+            }
+
+            int validColumns = framebuffer->width - blockX < SW_BLOCK_SIZE ? framebuffer->width - blockX : SW_BLOCK_SIZE;
+            unsigned long long blockBit = 1ull << (blockIndexRow + (blockX - tile->x0) / SW_BLOCK_SIZE);
+            unsigned long long colorBit = tile->colorClearMask & blockBit;
+            unsigned long long depthBit = setup->depthTest ? tile->depthClearMask & blockBit : 0; // Depth is only used by the depth test.
+
+            if(colorBit | depthBit)
+            {
+                // A pending clear is skipped for good when the kernel writes every pixel of the block.
+                bool overwritten = block.fullyCovered && (!setup->depthTest || accepted)
+                    && block.firstRow == 0 && block.lastRow == validRows - 1 && block.columnMask == (1u << validColumns) - 1;
+
+                if(overwritten)
+                {
+                    tile->colorClearMask &= ~colorBit;
+                    tile->depthClearMask &= ~depthBit;
+                }
+                else
+                {
+                    swResolveClear(framebuffer, tile, colorBit, depthBit);
+                }
+            }
+
+            SWBlockResult result = runKernel(kernel, validate, setup, &block, &target, stats);
+            stats->fragmentsTested += result.tested;
+            stats->fragmentsWritten += result.written;
+            stats->fragmentsHiZAccepted += accepted ? result.tested : 0;
+            stats->fragmentsFlatColor += setup->colorMode == SW_COLOR_FLAT ? result.written : 0;
+
+            if(!setup->depthTest || !result.written)
+            {
+                continue;
+            }
+
+            if(finiteDepth && result.written == validColumns * validRows)
+            {
+                *blockDepth = triangleDepth; // Every pixel of the block now holds a depth of this primitive.
+            }
+            else if(!finiteDepth || blockDepth->min == -INFINITY)
+            {
+                // The block may hold values that are not finite, it stays unknown until overwritten or cleared.
+                blockDepth->min = -INFINITY;
+                blockDepth->max = INFINITY;
+            }
+            else
+            {
+                // The block was just written and is in cache, reading it back keeps the range tight.
+                *blockDepth = storedDepthRange(target.depth, stride, validColumns, validRows);
+            }
+
+            depthChanged = true;
+        }
+    }
+
+    if(!depthChanged)
+    {
+        return;
+    }
+
+    // Refresh the range of the tile from its blocks.
+    SWDepthRange range;
+    range.min = INFINITY;
+    range.max = -INFINITY;
+
+    for(int blockY = tile->y0 / SW_BLOCK_SIZE; blockY * SW_BLOCK_SIZE < tile->y1; ++blockY)
+    {
+        const SWDepthRange *blockDepth = framebuffer->blockDepth + (size_t)blockY * framebuffer->blocksX;
+
+        for(int blockX = tile->x0 / SW_BLOCK_SIZE; blockX * SW_BLOCK_SIZE < tile->x1; ++blockX)
+        {
+            range.min = blockDepth[blockX].min < range.min ? blockDepth[blockX].min : range.min;
+            range.max = blockDepth[blockX].max > range.max ? blockDepth[blockX].max : range.max;
+        }
+    }
+
+    tile->depth = range;
+}
+
+void swResolveClear(SWFramebuffer *framebuffer, SWTileState *tile, unsigned long long colorMask, unsigned long long depthMask)
+{
+    tile->colorClearMask &= ~colorMask;
+    tile->depthClearMask &= ~depthMask;
+
+    for(unsigned long long mask = colorMask | depthMask; mask; mask &= mask - 1)
+    {
+        int index = 0;
+
+        while(!((mask >> index) & 1))
+        {
+            index++;
+        }
+
+        // Masks have bits for the whole 64x64 pixels, tiles at the top and right border are smaller.
+        int blockX = tile->x0 + index % (SW_TILE_SIZE / SW_BLOCK_SIZE) * SW_BLOCK_SIZE;
+        int blockY = tile->y0 + index / (SW_TILE_SIZE / SW_BLOCK_SIZE) * SW_BLOCK_SIZE;
+
+        if(blockX >= tile->x1 || blockY >= tile->y1)
+        {
+            continue;
+        }
+
+        int rows = tile->y1 - blockY < SW_BLOCK_SIZE ? tile->y1 - blockY : SW_BLOCK_SIZE;
+        size_t offset = (size_t)blockY * framebuffer->stride + blockX;
+
+        for(int row = 0; row < rows; ++row)
+        {
+            if((colorMask >> index) & 1)
+            {
+                unsigned int *color = framebuffer->backBuffer + offset + (size_t)row * framebuffer->stride;
+
+                for(int column = 0; column < SW_BLOCK_SIZE; ++column)
+                {
+                    color[column] = tile->clearColor;
+                }
+            }
+
+            if((depthMask >> index) & 1)
+            {
+                float *depth = framebuffer->depthBuffer + offset + (size_t)row * framebuffer->stride;
+
+                for(int column = 0; column < SW_BLOCK_SIZE; ++column)
+                {
+                    depth[column] = tile->clearDepth;
+                }
+            }
+        }
+    }
+}
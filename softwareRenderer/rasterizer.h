@@ -0,0 +1,174 @@
+// Triangle and quad setup and pixel kernels of the software renderer.
+//
+// Primitives are walked in 8x8 pixel blocks aligned to the framebuffer. Edge functions are evaluated in
+// 64-bit integers once per block; a block that straddles an edge is handed to a kernel with 32-bit edge
+// values, which can not overflow inside 8x8 pixels. The scalar kernel is the reference implementation, the
+// SSE4.1 and AVX2 kernels perform the same operations in the same order and must produce bit-identical
+// results. This holds as long as the compiler does not contract multiply-add pairs, which is the default
+// when building for plain x86-64.
+//
+// With the depth test enabled, the depth range of every block and tile (hierarchical-Z) is compared with the
+// range of the primitive first. Blocks that can not pass are skipped, blocks that must pass are written without
+// per-pixel comparisons.
+//
+// glClear() only marks the blocks of every tile as cleared (fast clear). A block is filled with the clear value
+// before a kernel first reads it, or when the frame is presented; blocks a triangle overwrites completely are
+// never filled.
+
+#ifndef SOFTWARE_RENDERER_RASTERIZER_H
+#define SOFTWARE_RENDERER_RASTERIZER_H
+
+#include "context.h"
+
+#define SW_BLOCK_SIZE 8 // Width and height of the pixel blocks handed to the kernels.
+#define SW_TILE_SIZE 64 // Width and height of a tile, 8x8 blocks so that a 64-bit mask has one bit per block.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SW_X86 1
+#endif
+
+// Lets one translation unit hold code for several instruction sets, selected at runtime.
+#if defined(__GNUC__)
+#define SW_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SW_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SW_TARGET_SSE41
+#define SW_TARGET_AVX2
+#endif
+
+// How the kernels compute the color of a fragment.
+#define SW_COLOR_FLAT 0 // All vertices have the same color, flatColor is stored as is.
+#define SW_COLOR_AFFINE 1 // Linear in screen space.
+#define SW_COLOR_PERSPECTIVE 2 // Perspective-correct, color / w divided by 1 / w per pixel.
+
+#define SW_MAX_EDGES 4 // A triangle or a convex quad.
+
+// Attribute interpolated linearly in window space: value = base + dx * column + dy * row,
+// where column and row are relative to the bottom-left corner of the primitive bounding box.
+struct SWPlane
+{
+    float base;
+    float dx;
+    float dy;
+};
+
+// Convex primitive, a triangle or a quad that is drawn without splitting it.
+struct SWPrimitiveSetup
+{
+    int minX, minY, maxX, maxY; // Inclusive pixel bounding box, clamped to the viewport and the framebuffer.
+
+    // Edge functions in pixel units: E(x, y) = edgeC + x * edgeStepX + y * edgeStepY, inside when E >= 0.
+    // The last edge of a triangle is 0 everywhere.
+    long long edgeC[SW_MAX_EDGES];
+    long long edgeStepX[SW_MAX_EDGES];
+    long long edgeStepY[SW_MAX_EDGES];
+
+    SWPlane depth;
+    SWPlane red; // Color divided by w with SW_COLOR_PERSPECTIVE.
+    SWPlane green;
+    SWPlane blue;
+    SWPlane inverseW; // 1 / w, relative to the first vertex.
+    int colorMode; // One of SW_COLOR_*, see glHint() and glShadeModel().
+    unsigned int flatColor; // Packed color with SW_COLOR_FLAT.
+
+    bool depthTest; // Depth state captured when the primitive was submitted.
+    GLenum depthFunc;
+};
+
+// Framebuffer rectangle rendered by one thread at a time, with the metadata of the pixels inside it.
+struct SWTileState
+{
+    int x0, y0, x1, y1; // Pixels x0 <= x < x1, y0 <= y < y1, the last column of tiles includes the row padding.
+    SWDepthRange depth; // Hierarchical-Z, union of the block ranges of the tile.
+
+    // Fast clear, bit i is set while block i of the tile, counted row by row from the bottom-left,
+    // still has to be filled with the clear value.
+    unsigned long long colorClearMask;
+    unsigned long long depthClearMask;
+    unsigned int clearColor;
+    float clearDepth;
+
+    // Damage tracking, hashes of the bins whose rendering the buffers hold, 0 when unknown; see swRenderBins().
+    unsigned long long backHash;
+    unsigned long long frontHash;
+    unsigned long long depthHash; // The depth buffer and the metadata above.
+};
+
+// Block of up to 8x8 pixels prepared for a kernel.
+struct SWBlock
+{
+    int column; // Column of the block's first pixel, relative to the bounding box.
+    int row; // Row of the block's first pixel, relative to the bounding box.
+    int firstRow; // Rows firstRow to lastRow of the block are processed.
+    int lastRow;
+    unsigned int columnMask; // Bit i set when column i of the block is inside the framebuffer.
+    bool fullyCovered; // All edges accept the whole block, coverage does not need to be computed.
+
+    // Edge values at the block's first pixel and their per pixel steps.
+    // Edges that accept the whole block, and those a triangle does not have, are all 0.
+    int edge[SW_MAX_EDGES];
+    int edgeStepX[SW_MAX_EDGES];
+    int edgeStepY[SW_MAX_EDGES];
+};
+
+// Destination of a kernel, pointing at the first pixel of the block.
+struct SWBlockTarget
+{
+    unsigned int *color;
+    float *depth;
+    int stride; // Pixels between two rows.
+    bool depthTest;
+    GLenum depthFunc;
+};
+
+// Fragment counters returned by the kernels.
+struct SWBlockResult
+{
+    int tested;
+    int written;
+};
+
+typedef SWBlockResult (*SWBlockKernel)(const SWPrimitiveSetup *setup, const SWBlock *block, const SWBlockTarget *target);
+
+SWBlockResult swRasterizeBlockScalar(const SWPrimitiveSetup *setup, const SWBlock *block, const SWBlockTarget *target);
+
+#ifdef SW_X86
+SWBlockResult swRasterizeBlockSSE41(const SWPrimitiveSetup *setup, const SWBlock *block, const SWBlockTarget *target);
+SWBlockResult swRasterizeBlockAVX2(const SWPrimitiveSetup *setup, const SWBlock *block, const SWBlockTarget *target);
+#endif
+
+// Snaps the triangle to the sub-pixel grid and computes its edge functions and attribute planes.
+// Returns false when the triangle covers no pixel of the framebuffer.
+bool swSetupTriangle(const SWGLContext *context, const SWScreenVertex *v0, const SWScreenVertex *v1, const SWScreenVertex *v2, SWPrimitiveSetup *setup);
+
+// Sets up a quad as one primitive with four edges, sharing the attribute planes of its two halves.
+// Returns false when that is not possible: the quad is not convex, its attributes are not linear across it,
+// or it covers no pixel. The caller then draws the quad as two triangles.
+bool swSetupQuad(const SWGLContext *context, const SWScreenVertex *v0, const SWScreenVertex *v1, const SWScreenVertex *v2, const SWScreenVertex *v3, SWPrimitiveSetup *setup);
+
+// Rasterizes the part of a primitive inside a tile, fragment counters are added to stats.
+void swRasterizePrimitiveTile(const SWPrimitiveSetup *setup, SWFramebuffer *framebuffer, SWTileState *tile, SWGLFrameStats *stats);
+
+// Fills the blocks of a tile selected by the masks with the pending clear values and removes them from the
+// fast clear masks of the tile.
+void swResolveClear(SWFramebuffer *framebuffer, SWTileState *tile, unsigned long long colorMask, unsigned long long depthMask);
+
+// Instruction set detection and kernel selection, see cpuFeatures.cpp.
+int swDetectInstructionSet(void);
+SWBlockKernel swGetBlockKernel(int instructionSet);
+extern bool swValidateKernels; // Compare vector kernels against the scalar one, see swglSetKernelValidation().
+
+// Number of set bits of a lane mask.
+static inline int swBitCount(unsigned int mask)
+{
+    int count = 0;
+
+    for(; mask; mask &= mask - 1)
+    {
+        count++;
+    }
+
+    return count;
+}
+
+#endif // SOFTWARE_RENDERER_RASTERIZER_H
@@ -0,0 +1,182 @@
+// AVX2 pixel kernel, processes a row of 8 pixels per iteration.
+
+#include "rasterizer.h"
+
+#ifdef SW_X86
+
+#include <immintrin.h>
+
+template<GLenum depthFunc>
+SW_TARGET_AVX2 static inline __m256 depthPassMask(__m256 depth, __m256 stored)
+{
+    // Ordered predicates behave like the scalar comparisons when a value is NaN.
+    switch(depthFunc)
+    {
+        case GL_NEVER: return _mm256_setzero_ps();
+        case GL_LESS: return _mm256_cmp_ps(depth, stored, _CMP_LT_OQ);
+        case GL_EQUAL: return _mm256_cmp_ps(depth, stored, _CMP_EQ_OQ);
+        case GL_LEQUAL: return _mm256_cmp_ps(depth, stored, _CMP_LE_OQ);
+        case GL_GREATER: return _mm256_cmp_ps(depth, stored, _CMP_GT_OQ);
+        case GL_NOTEQUAL: return _mm256_cmp_ps(depth, stored, _CMP_NEQ_UQ);
+        case GL_GEQUAL: return _mm256_cmp_ps(depth, stored, _CMP_GE_OQ);
+        default: return _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    }
+}
+
+SW_TARGET_AVX2 static inline __m256i packChannel(__m256 value)
+{
+    // Same clamping as the scalar kernel, max returns its second operand when value is NaN.
+    value = _mm256_max_ps(value, _mm256_setzero_ps());
+    value = _mm256_min_ps(value, _mm256_set1_ps(1.0f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+}
+
+template<bool depthTest, GLenum depthFunc, int colorMode>
+SW_TARGET_AVX2 static SWBlockResult rasterizeBlock(const SWPrimitiveSetup *setup, const SWBlock *block, const SWBlockTarget *target)
+{
+    SWBlockResult result = {0, 0};
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i laneBit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i columnMask = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)block->columnMask), laneBit), laneBit);
+
+    // Edge values of the lanes, stepped from row to row. Only needed when the block is not fully covered.
+    __m256i edge0 = _mm256_setzero_si256();
+    __m256i edge1 = _mm256_setzero_si256();
+    __m256i edge2 = _mm256_setzero_si256();
+    __m256i edge3 = _mm256_setzero_si256();
+
+    if(!block->fullyCovered)
+    {
+        edge0 = _mm256_add_epi32(_mm256_set1_epi32(block->edge[0] + block->firstRow * block->edgeStepY[0]), _mm256_mullo_epi32(lane, _mm256_set1_epi32(block->edgeStepX[0])));
+        edge1 = _mm256_add_epi32(_mm256_set1_epi32(block->edge[1] + block->firstRow * block->edgeStepY[1]), _mm256_mullo_epi32(lane, _mm256_set1_epi32(block->edgeStepX[1])));
+        edge2 = _mm256_add_epi32(_mm256_set1_epi32(block->edge[2] + block->firstRow * block->edgeStepY[2]), _mm256_mullo_epi32(lane, _mm256_set1_epi32(block->edgeStepX[2])));
+        edge3 = _mm256_add_epi32(_mm256_set1_epi32(block->edge[3] + block->firstRow * block->edgeStepY[3]), _mm256_mullo_epi32(lane, _mm256_set1_epi32(block->edgeStepX[3])));
+    }
+
+    // Attribute contributions of the columns, the same for every row.
+    __m256 x = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(block->column), lane));
+    __m256 depthX = _mm256_mul_ps(_mm256_set1_ps(setup->depth.dx), x);
+    __m256 redX = _mm256_mul_ps(_mm256_set1_ps(setup->red.dx), x);
+    __m256 greenX = _mm256_mul_ps(_mm256_set1_ps(setup->green.dx), x);
+    __m256 blueX = _mm256_mul_ps(_mm256_set1_ps(setup->blue.dx), x);
+    __m256 inverseWX = _mm256_mul_ps(_mm256_set1_ps(setup->inverseW.dx), x);
+
+    for(int row = block->firstRow; row <= block->lastRow; ++row)
+    {
+        __m256i covered = columnMask;
+
+        if(!block->fullyCovered)
+        {
+            __m256i inside = _mm256_cmpgt_epi32(_mm256_or_si256(_mm256_or_si256(edge0, edge1), _mm256_or_si256(edge2, edge3)), _mm256_set1_epi32(-1));
+            covered = _mm256_and_si256(covered, inside);
+            edge0 = _mm256_add_epi32(edge0, _mm256_set1_epi32(block->edgeStepY[0]));
+            edge1 = _mm256_add_epi32(edge1, _mm256_set1_epi32(block->edgeStepY[1]));
+            edge2 = _mm256_add_epi32(edge2, _mm256_set1_epi32(block->edgeStepY[2]));
+            edge3 = _mm256_add_epi32(edge3, _mm256_set1_epi32(block->edgeStepY[3]));
+        }
+
+        unsigned int coveredBits = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(covered));
+
+        if(!coveredBits)
+        {
+            continue;
+        }
+
+        result.tested += swBitCount(coveredBits);
+
+        float y = (float)(block->row + row);
+        __m256 depth = _mm256_add_ps(_mm256_set1_ps(setup->depth.base + setup->depth.dy * y), depthX);
+        __m256 mask = _mm256_castsi256_ps(covered);
+        float *depthRow = target->depth + row * target->stride;
+
+        if(depthTest)
+        {
+            __m256 stored = _mm256_loadu_ps(depthRow);
+            mask = _mm256_and_ps(mask, depthPassMask<depthFunc>(depth, stored));
+            _mm256_storeu_ps(depthRow, _mm256_blendv_ps(stored, depth, mask));
+        }
+
+        unsigned int writtenBits = (unsigned int)_mm256_movemask_ps(mask);
+
+        if(!writtenBits)
+        {
+            continue;
+        }
+
+        result.written += swBitCount(writtenBits);
+
+        __m256i color;
+
+        if(colorMode == SW_COLOR_FLAT)
+        {
+            color = _mm256_set1_epi32((int)setup->flatColor);
+        }
+        else
+        {
+            __m256 redValue = _mm256_add_ps(_mm256_set1_ps(setup->red.base + setup->red.dy * y), redX);
+            __m256 greenValue = _mm256_add_ps(_mm256_set1_ps(setup->green.base + setup->green.dy * y), greenX);
+            __m256 blueValue = _mm256_add_ps(_mm256_set1_ps(setup->blue.base + setup->blue.dy * y), blueX);
+
+            if(colorMode == SW_COLOR_PERSPECTIVE)
+            {
+                __m256 w = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_add_ps(_mm256_set1_ps(setup->inverseW.base + setup->inverseW.dy * y), inverseWX));
+                redValue = _mm256_mul_ps(redValue, w);
+                greenValue = _mm256_mul_ps(greenValue, w);
+                blueValue = _mm256_mul_ps(blueValue, w);
+            }
+
+            __m256i red = packChannel(redValue);
+            __m256i green = packChannel(greenValue);
+            __m256i blue = packChannel(blueValue);
+            color = _mm256_or_si256(_mm256_or_si256(_mm256_set1_epi32((int)0xFF000000u), _mm256_slli_epi32(red, 16)),
+                _mm256_or_si256(_mm256_slli_epi32(green, 8), blue));
+        }
+
+        __m256i *colorRow = (__m256i *)(target->color + row * target->stride);
+
+        if(writtenBits == 0xFF)
+        {
+            _mm256_storeu_si256(colorRow, color); // Whole row written, no need to merge.
+        }
+        else
+        {
+            __m256i stored = _mm256_loadu_si256(colorRow);
+            _mm256_storeu_si256(colorRow, _mm256_blendv_epi8(stored, color, _mm256_castps_si256(mask)));
+        }
+    }
+
+    return result;
+}
+
+template<int colorMode>
+SW_TARGET_AVX2 static SWBlockResult rasterizeBlockDepth(const SWPrimitiveSetup *setup, const SWBlock *block, const SWBlockTarget *target)
+{
+    if(!target->depthTest)
+    {
+        return rasterizeBlock<false, GL_ALWAYS, colorMode>(setup, block, target);
+    }
+
+    switch(target->depthFunc)
+    {
+        case GL_NEVER: return rasterizeBlock<true, GL_NEVER, colorMode>(setup, block, target);
+        case GL_LESS: return rasterizeBlock<true, GL_LESS, colorMode>(setup, block, target);
+        case GL_EQUAL: return rasterizeBlock<true, GL_EQUAL, colorMode>(setup, block, target);
+        case GL_LEQUAL: return rasterizeBlock<true, GL_LEQUAL, colorMode>(setup, block, target);
+        case GL_GREATER: return rasterizeBlock<true, GL_GREATER, colorMode>(setup, block, target);
+        case GL_NOTEQUAL: return rasterizeBlock<true, GL_NOTEQUAL, colorMode>(setup, block, target);
+        case GL_GEQUAL: return rasterizeBlock<true, GL_GEQUAL, colorMode>(setup, block, target);
+        default: return rasterizeBlock<true, GL_ALWAYS, colorMode>(setup, block, target);
+    }
+}
+
+SW_TARGET_AVX2 SWBlockResult swRasterizeBlockAVX2(const SWPrimitiveSetup *setup, const SWBlock *block, const SWBlockTarget *target)
+{
+    switch(setup->colorMode)
+    {
+        case SW_COLOR_FLAT: return rasterizeBlockDepth<SW_COLOR_FLAT>(setup, block, target);
+        case SW_COLOR_AFFINE: return rasterizeBlockDepth<SW_COLOR_AFFINE>(setup, block, target);
+        default: return rasterizeBlockDepth<SW_COLOR_PERSPECTIVE>(setup, block, target);
+    }
+}
+
+#endif // SW_X86
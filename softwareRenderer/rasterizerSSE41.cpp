@@ -0,0 +1,194 @@
+// SSE4.1 pixel kernel, processes a row of 8 pixels as two groups of 4 per iteration.
+
+#include "rasterizer.h"
+
+#ifdef SW_X86
+
+#include <smmintrin.h>
+
+template<GLenum depthFunc>
+SW_TARGET_SSE41 static inline __m128 depthPassMask(__m128 depth, __m128 stored)
+{
+    // cmpneq is unordered, the others are ordered, like the scalar comparisons.
+    switch(depthFunc)
+    {
+        case GL_NEVER: return _mm_setzero_ps();
+        case GL_LESS: return _mm_cmplt_ps(depth, stored);
+        case GL_EQUAL: return _mm_cmpeq_ps(depth, stored);
+        case GL_LEQUAL: return _mm_cmple_ps(depth, stored);
+        case GL_GREATER: return _mm_cmpgt_ps(depth, stored);
+        case GL_NOTEQUAL: return _mm_cmpneq_ps(depth, stored);
+        case GL_GEQUAL: return _mm_cmpge_ps(depth, stored);
+        default: return _mm_castsi128_ps(_mm_set1_epi32(-1));
+    }
+}
+
+SW_TARGET_SSE41 static inline __m128i packChannel(__m128 value)
+{
+    // Same clamping as the scalar kernel, max returns its second operand when value is NaN.
+    value = _mm_max_ps(value, _mm_setzero_ps());
+    value = _mm_min_ps(value, _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+template<bool depthTest, GLenum depthFunc, int colorMode>
+SW_TARGET_SSE41 static SWBlockResult rasterizeBlock(const SWPrimitiveSetup *setup, const SWBlock *block, const SWBlockTarget *target)
+{
+    SWBlockResult result = {0, 0};
+    const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i laneBit = _mm_setr_epi32(1, 2, 4, 8);
+
+    for(int half = 0; half < 2; ++half)
+    {
+        int column = half * 4;
+        __m128i columnBits = _mm_set1_epi32((int)(block->columnMask >> column));
+        const __m128i columnMask = _mm_cmpeq_epi32(_mm_and_si128(columnBits, laneBit), laneBit);
+
+        if(_mm_testz_si128(columnMask, columnMask))
+        {
+            continue;
+        }
+
+        // Edge values of the lanes, stepped from row to row. Only needed when the block is not fully covered.
+        __m128i columnLane = _mm_add_epi32(_mm_set1_epi32(column), lane);
+        __m128i edge0 = _mm_setzero_si128();
+        __m128i edge1 = _mm_setzero_si128();
+        __m128i edge2 = _mm_setzero_si128();
+        __m128i edge3 = _mm_setzero_si128();
+
+        if(!block->fullyCovered)
+        {
+            edge0 = _mm_add_epi32(_mm_set1_epi32(block->edge[0] + block->firstRow * block->edgeStepY[0]), _mm_mullo_epi32(columnLane, _mm_set1_epi32(block->edgeStepX[0])));
+            edge1 = _mm_add_epi32(_mm_set1_epi32(block->edge[1] + block->firstRow * block->edgeStepY[1]), _mm_mullo_epi32(columnLane, _mm_set1_epi32(block->edgeStepX[1])));
+            edge2 = _mm_add_epi32(_mm_set1_epi32(block->edge[2] + block->firstRow * block->edgeStepY[2]), _mm_mullo_epi32(columnLane, _mm_set1_epi32(block->edgeStepX[2])));
+            edge3 = _mm_add_epi32(_mm_set1_epi32(block->edge[3] + block->firstRow * block->edgeStepY[3]), _mm_mullo_epi32(columnLane, _mm_set1_epi32(block->edgeStepX[3])));
+        }
+
+        // Attribute contributions of the columns, the same for every row.
+        __m128 x = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(block->column), columnLane));
+        __m128 depthX = _mm_mul_ps(_mm_set1_ps(setup->depth.dx), x);
+        __m128 redX = _mm_mul_ps(_mm_set1_ps(setup->red.dx), x);
+        __m128 greenX = _mm_mul_ps(_mm_set1_ps(setup->green.dx), x);
+        __m128 blueX = _mm_mul_ps(_mm_set1_ps(setup->blue.dx), x);
+        __m128 inverseWX = _mm_mul_ps(_mm_set1_ps(setup->inverseW.dx), x);
+
+        for(int row = block->firstRow; row <= block->lastRow; ++row)
+        {
+            __m128i covered = columnMask;
+
+            if(!block->fullyCovered)
+            {
+                __m128i inside = _mm_cmpgt_epi32(_mm_or_si128(_mm_or_si128(edge0, edge1), _mm_or_si128(edge2, edge3)), _mm_set1_epi32(-1));
+                covered = _mm_and_si128(covered, inside);
+                edge0 = _mm_add_epi32(edge0, _mm_set1_epi32(block->edgeStepY[0]));
+                edge1 = _mm_add_epi32(edge1, _mm_set1_epi32(block->edgeStepY[1]));
+                edge2 = _mm_add_epi32(edge2, _mm_set1_epi32(block->edgeStepY[2]));
+                edge3 = _mm_add_epi32(edge3, _mm_set1_epi32(block->edgeStepY[3]));
+            }
+
+            unsigned int coveredBits = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(covered));
+
+            if(!coveredBits)
+            {
+                continue;
+            }
+
+            result.tested += swBitCount(coveredBits);
+
+            float y = (float)(block->row + row);
+            __m128 depth = _mm_add_ps(_mm_set1_ps(setup->depth.base + setup->depth.dy * y), depthX);
+            __m128 mask = _mm_castsi128_ps(covered);
+            float *depthRow = target->depth + row * target->stride + column;
+
+            if(depthTest)
+            {
+                __m128 stored = _mm_loadu_ps(depthRow);
+                mask = _mm_and_ps(mask, depthPassMask<depthFunc>(depth, stored));
+                _mm_storeu_ps(depthRow, _mm_blendv_ps(stored, depth, mask));
+            }
+
+            unsigned int writtenBits = (unsigned int)_mm_movemask_ps(mask);
+
+            if(!writtenBits)
+            {
+                continue;
+            }
+
+            result.written += swBitCount(writtenBits);
+
+            __m128i color;
+
+            if(colorMode == SW_COLOR_FLAT)
+            {
+                color = _mm_set1_epi32((int)setup->flatColor);
+            }
+            else
+            {
+                __m128 redValue = _mm_add_ps(_mm_set1_ps(setup->red.base + setup->red.dy * y), redX);
+                __m128 greenValue = _mm_add_ps(_mm_set1_ps(setup->green.base + setup->green.dy * y), greenX);
+                __m128 blueValue = _mm_add_ps(_mm_set1_ps(setup->blue.base + setup->blue.dy * y), blueX);
+
+                if(colorMode == SW_COLOR_PERSPECTIVE)
+                {
+                    __m128 w = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_set1_ps(setup->inverseW.base + setup->inverseW.dy * y), inverseWX));
+                    redValue = _mm_mul_ps(redValue, w);
+                    greenValue = _mm_mul_ps(greenValue, w);
+                    blueValue = _mm_mul_ps(blueValue, w);
+                }
+
+                __m128i red = packChannel(redValue);
+                __m128i green = packChannel(greenValue);
+                __m128i blue = packChannel(blueValue);
+                color = _mm_or_si128(_mm_or_si128(_mm_set1_epi32((int)0xFF000000u), _mm_slli_epi32(red, 16)),
+                    _mm_or_si128(_mm_slli_epi32(green, 8), blue));
+            }
+
+            __m128i *colorRow = (__m128i *)(target->color + row * target->stride + column);
+
+            if(writtenBits == 0xF)
+            {
+                _mm_storeu_si128(colorRow, color); // Whole row written, no need to merge.
+            }
+            else
+            {
+                __m128i stored = _mm_loadu_si128(colorRow);
+                _mm_storeu_si128(colorRow, _mm_blendv_epi8(stored, color, _mm_castps_si128(mask)));
+            }
+        }
+    }
+
+    return result;
+}
+
+template<int colorMode>
+SW_TARGET_SSE41 static SWBlockResult rasterizeBlockDepth(const SWPrimitiveSetup *setup, const SWBlock *block, const SWBlockTarget *target)
+{
+    if(!target->depthTest)
+    {
+        return rasterizeBlock<false, GL_ALWAYS, colorMode>(setup, block, target);
+    }
+
+    switch(target->depthFunc)
+    {
+        case GL_NEVER: return rasterizeBlock<true, GL_NEVER, colorMode>(setup, block, target);
+        case GL_LESS: return rasterizeBlock<true, GL_LESS, colorMode>(setup, block, target);
+        case GL_EQUAL: return rasterizeBlock<true, GL_EQUAL, colorMode>(setup, block, target);
+        case GL_LEQUAL: return rasterizeBlock<true, GL_LEQUAL, colorMode>(setup, block, target);
+        case GL_GREATER: return rasterizeBlock<true, GL_GREATER, colorMode>(setup, block, target);
+        case GL_NOTEQUAL: return rasterizeBlock<true, GL_NOTEQUAL, colorMode>(setup, block, target);
+        case GL_GEQUAL: return rasterizeBlock<true, GL_GEQUAL, colorMode>(setup, block, target);
+        default: return rasterizeBlock<true, GL_ALWAYS, colorMode>(setup, block, target);
+    }
+}
+
+SW_TARGET_SSE41 SWBlockResult swRasterizeBlockSSE41(const SWPrimitiveSetup *setup, const SWBlock *block, const SWBlockTarget *target)
+{
+    switch(setup->colorMode)
+    {
+        case SW_COLOR_FLAT: return rasterizeBlockDepth<SW_COLOR_FLAT>(setup, block, target);
+        case SW_COLOR_AFFINE: return rasterizeBlockDepth<SW_COLOR_AFFINE>(setup, block, target);
+        default: return rasterizeBlockDepth<SW_COLOR_PERSPECTIVE>(setup, block, target);
+    }
+}
+
+#endif // SW_X86
@@ -0,0 +1,172 @@
+// Memory-mapped scene files of the software renderer, see sceneFormat.h.
+//
+// Loading a scene maps the file and checks the header and the object table. The vertices are drawn straight from
+// the mapping, so their pages are only read from disk when an object is first drawn, and never copied.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+#include "context.h"
+#include "sceneFormat.h"
+
+// Vertices of a scene are handed to the geometry stage as they are stored.
+static_assert(sizeof(SWSceneVertex) == sizeof(SWRecordedVertex), "Scene vertices must match recorded vertices.");
+static_assert(offsetof(SWSceneObject, radius) == offsetof(SWSceneObject, center) + 3 * sizeof(float), "The bounding sphere must be contiguous.");
+static_assert(sizeof(SWSceneObject) % sizeof(float) == 0, "Objects must hold a whole number of floats.");
+
+struct SWGLScene
+{
+    SWMappedFile file;
+    const SWSceneHeader *header;
+    const SWSceneObject *objects;
+    const SWRecordedVertex *vertices;
+    float *matrices; // Model matrix of every object at the frame being drawn.
+    int *visible; // Objects left by frustum culling.
+};
+
+// Whether size bytes at data hold a scene whose arrays and objects are all inside the file.
+static bool validScene(const unsigned char *data, size_t size)
+{
+    if(size < sizeof(SWSceneHeader))
+    {
+        return false;
+    }
+
+    const SWSceneHeader *header = (const SWSceneHeader *)data;
+
+    if(memcmp(header->magic, SW_SCENE_MAGIC, sizeof(header->magic)) || header->version != SW_SCENE_VERSION)
+    {
+        return false;
+    }
+
+    if(header->objectOffset % SW_SCENE_ALIGNMENT || header->vertexOffset % SW_SCENE_ALIGNMENT
+        || header->objectOffset > size || header->objectCount > (size - header->objectOffset) / sizeof(SWSceneObject)
+        || header->objectCount > INT_MAX / 16 || header->vertexOffset > size
+        || header->vertexCount > (size - header->vertexOffset) / sizeof(SWSceneVertex))
+    {
+        return false;
+    }
+
+    const SWSceneObject *objects = (const SWSceneObject *)(data + header->objectOffset);
+
+    for(uint32_t i = 0; i < header->objectCount; ++i)
+    {
+        const SWSceneObject *object = &objects[i];
+
+        if((object->mode != GL_TRIANGLES && object->mode != GL_QUADS) || object->vertexCount > INT_MAX
+            || object->firstVertex > header->vertexCount || object->vertexCount > header->vertexCount - object->firstVertex)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+HSWGLSCENE swglLoadScene(const char *fileName)
+{
+    if(!fileName)
+    {
+        return NULL;
+    }
+
+    SWGLScene *scene = new(std::nothrow) SWGLScene();
+
+    if(!scene)
+    {
+        return NULL;
+    }
+
+    if(!swMapFile(fileName, &scene->file))
+    {
+        delete scene;
+        return NULL;
+    }
+
+    if(!validScene(scene->file.data, scene->file.size))
+    {
+        swUnmapFile(&scene->file);
+        delete scene;
+        return NULL;
+    }
+
+    const unsigned char *data = scene->file.data;
+    scene->header = (const SWSceneHeader *)data;
+    scene->objects = (const SWSceneObject *)(data + scene->header->objectOffset);
+    scene->vertices = (const SWRecordedVertex *)(data + scene->header->vertexOffset);
+
+    int objectCount = (int)scene->header->objectCount;
+    scene->matrices = (float *)swAlignedAlloc((objectCount > 0 ? objectCount : 1) * 16 * sizeof(float));
+    scene->visible = (int *)malloc((objectCount > 0 ? objectCount : 1) * sizeof(int));
+
+    if(!scene->matrices || !scene->visible)
+    {
+        swglDeleteScene(scene);
+        return NULL;
+    }
+
+    return scene;
+}
+
+int swglDeleteScene(HSWGLSCENE scene)
+{
+    if(!scene)
+    {
+        return FALSE;
+    }
+
+    swUnmapFile(&scene->file);
+    swAlignedFree(scene->matrices);
+    free(scene->visible);
+    delete scene;
+    return TRUE;
+}
+
+int swglDrawScene(HSWGLSCENE scene, GLfloat frame)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context || !scene || context->insideBeginEnd)
+    {
+        return FALSE;
+    }
+
+    // Recorded immediate mode primitives come first.
+    swFlushVertices(context);
+
+    int objectCount = (int)scene->header->objectCount;
+
+    if(objectCount == 0)
+    {
+        return TRUE;
+    }
+
+    // Same model matrix as glLoadIdentity(), glTranslatef() and glRotatef() would build.
+    for(int i = 0; i < objectCount; ++i)
+    {
+        const SWSceneObject *object = &scene->objects[i];
+        float *model = &scene->matrices[i * 16];
+        swMatrixIdentity(model);
+        swMatrixTranslate(model, object->translation[0], object->translation[1], object->translation[2]);
+        swMatrixRotate(model, fmodf(object->angle + object->rate * frame, 360.0f), object->axis[0], object->axis[1], object->axis[2]);
+    }
+
+    const float *modelviewProjection = swGetModelviewProjection(context);
+    int visibleCount = swCullInstances(context, modelviewProjection, scene->objects[0].center,
+        (int)(sizeof(SWSceneObject) / sizeof(float)), scene->matrices, objectCount, scene->visible);
+
+    alignas(16) float matrix[16];
+
+    for(int next = 0; next < visibleCount; ++next)
+    {
+        int i = scene->visible[next];
+        const SWSceneObject *object = &scene->objects[i];
+        swMatrixMultiply(matrix, modelviewProjection, &scene->matrices[i * 16]);
+        swDrawVertices(context, matrix, object->mode, &scene->vertices[object->firstVertex], (int)object->vertexCount);
+    }
+
+    return TRUE;
+}
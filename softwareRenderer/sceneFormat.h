@@ -0,0 +1,52 @@
+// Binary scene file of the software renderer, see swglLoadScene().
+//
+// A scene file is meant to be mapped into memory and drawn in place, so everything in it is stored the way the
+// renderer uses it: little-endian, naturally aligned, and vertices laid out like the ones glVertex3f() records.
+//
+//     SWSceneHeader
+//     SWSceneObject[objectCount], at objectOffset
+//     SWSceneVertex[vertexCount], at vertexOffset
+//
+// Every object is one glBegin()/glEnd() pair of the samples: a run of vertices drawn with a model matrix of
+// glTranslatef(translation) followed by glRotatef(angle, axis), where angle advances by rate every frame.
+// sceneConverter builds these files from a text description.
+
+#ifndef SOFTWARE_RENDERER_SCENE_FORMAT_H
+#define SOFTWARE_RENDERER_SCENE_FORMAT_H
+
+#include <stdint.h>
+
+#define SW_SCENE_MAGIC "SWSCENE" // First 8 bytes of a scene file, including the terminating zero.
+#define SW_SCENE_VERSION 1
+#define SW_SCENE_ALIGNMENT 64 // Alignment of the object and vertex arrays within the file.
+
+struct SWSceneHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t objectCount;
+    uint64_t vertexCount;
+    uint64_t objectOffset; // Bytes from the start of the file.
+    uint64_t vertexOffset;
+};
+
+struct SWSceneObject
+{
+    uint32_t mode; // GL_TRIANGLES or GL_QUADS, an incomplete last primitive is ignored.
+    uint32_t vertexCount;
+    uint64_t firstVertex;
+    float translation[3];
+    float axis[3]; // Rotation axis, the object does not rotate when all zero.
+    float angle; // Rotation in degrees at frame 0.
+    float rate; // Degrees added to angle per frame, like the rtri and rquad increments of polygonRotation.
+    float center[3]; // Bounding sphere of the vertices, in object space.
+    float radius;
+};
+
+struct SWSceneVertex
+{
+    float x, y, z;
+    float r, g, b;
+};
+
+#endif // SOFTWARE_RENDERER_SCENE_FORMAT_H
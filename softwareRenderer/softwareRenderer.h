@@ -0,0 +1,345 @@
+// Headless software renderer.
+// Implements the fixed-function OpenGL subset used by the samples into an in-memory framebuffer,
+// so drawGLScene() can run unchanged without a window, a GPU or a display.
+//
+// compile command (from a sample directory)
+// g++ -O3 -DSOFTWARE_RENDERER polygonRotation.cpp ../softwareRenderer/*.cpp -o polygonRotation
+//
+
+#ifndef SOFTWARE_RENDERER_H
+#define SOFTWARE_RENDERER_H
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+typedef unsigned int GLenum;
+typedef unsigned char GLboolean;
+typedef unsigned int GLbitfield;
+typedef void GLvoid;
+typedef int GLint;
+typedef unsigned int GLuint;
+typedef int GLsizei;
+typedef float GLfloat;
+typedef float GLclampf;
+typedef double GLdouble;
+typedef double GLclampd;
+
+// Boolean values.
+#define GL_FALSE 0
+#define GL_TRUE 1
+
+// Errors.
+#define GL_NO_ERROR 0
+#define GL_INVALID_ENUM 0x0500
+#define GL_INVALID_VALUE 0x0501
+#define GL_INVALID_OPERATION 0x0502
+#define GL_STACK_OVERFLOW 0x0503
+#define GL_STACK_UNDERFLOW 0x0504
+#define GL_OUT_OF_MEMORY 0x0505
+
+// Primitives.
+#define GL_TRIANGLES 0x0004
+#define GL_QUADS 0x0007
+
+// Buffer bits.
+#define GL_DEPTH_BUFFER_BIT 0x00000100
+#define GL_COLOR_BUFFER_BIT 0x00004000
+
+// Depth functions.
+#define GL_NEVER 0x0200
+#define GL_LESS 0x0201
+#define GL_EQUAL 0x0202
+#define GL_LEQUAL 0x0203
+#define GL_GREATER 0x0204
+#define GL_NOTEQUAL 0x0205
+#define GL_GEQUAL 0x0206
+#define GL_ALWAYS 0x0207
+
+// Capabilities.
+#define GL_CULL_FACE 0x0B44
+#define GL_DEPTH_TEST 0x0B71
+
+// Faces.
+#define GL_FRONT 0x0404
+#define GL_BACK 0x0405
+#define GL_FRONT_AND_BACK 0x0408
+
+// Winding orders.
+#define GL_CW 0x0900
+#define GL_CCW 0x0901
+
+// Shading models.
+#define GL_FLAT 0x1D00
+#define GL_SMOOTH 0x1D01
+
+// Hints.
+#define GL_PERSPECTIVE_CORRECTION_HINT 0x0C50
+#define GL_DONT_CARE 0x1100
+#define GL_FASTEST 0x1101
+#define GL_NICEST 0x1102
+
+// Matrix modes.
+#define GL_MODELVIEW 0x1700
+#define GL_PROJECTION 0x1701
+
+// Display list modes.
+#define GL_COMPILE 0x1300
+#define GL_COMPILE_AND_EXECUTE 0x1301
+
+// Data types.
+#define GL_UNSIGNED_BYTE 0x1401
+#define GL_UNSIGNED_SHORT 0x1403
+#define GL_UNSIGNED_INT 0x1405
+#define GL_FLOAT 0x1406
+
+// Vertex arrays.
+#define GL_VERTEX_ARRAY 0x8074
+#define GL_COLOR_ARRAY 0x8076
+
+// State.
+GLvoid glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
+GLvoid glClearDepth(GLclampd depth);
+GLvoid glClear(GLbitfield mask);
+GLvoid glEnable(GLenum cap);
+GLvoid glDisable(GLenum cap);
+GLboolean glIsEnabled(GLenum cap);
+GLvoid glDepthFunc(GLenum func);
+GLvoid glCullFace(GLenum mode);
+GLvoid glFrontFace(GLenum mode);
+GLvoid glShadeModel(GLenum mode);
+GLvoid glHint(GLenum target, GLenum mode);
+GLvoid glViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+GLvoid glFlush(GLvoid);
+GLvoid glFinish(GLvoid);
+GLenum glGetError(GLvoid);
+
+// Matrices.
+GLvoid glMatrixMode(GLenum mode);
+GLvoid glLoadIdentity(GLvoid);
+GLvoid glPushMatrix(GLvoid);
+GLvoid glPopMatrix(GLvoid);
+GLvoid glTranslatef(GLfloat x, GLfloat y, GLfloat z);
+GLvoid glRotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z);
+GLvoid gluPerspective(GLdouble fovy, GLdouble aspect, GLdouble zNear, GLdouble zFar);
+
+// Immediate mode.
+GLvoid glBegin(GLenum mode);
+GLvoid glEnd(GLvoid);
+GLvoid glVertex3f(GLfloat x, GLfloat y, GLfloat z);
+GLvoid glColor3f(GLfloat red, GLfloat green, GLfloat blue);
+
+// Display lists. Only the immediate mode and matrix functions and glCallList() are compiled into a list, other
+// functions called between glNewList() and glEndList() execute right away.
+GLuint glGenLists(GLsizei range);
+GLvoid glDeleteLists(GLuint list, GLsizei range);
+GLboolean glIsList(GLuint list);
+GLvoid glNewList(GLuint list, GLenum mode);
+GLvoid glEndList(GLvoid);
+GLvoid glCallList(GLuint list);
+
+// Vertex arrays. Positions of 2 or 3 and colors of 3 or 4 GL_FLOAT values are supported, alpha is ignored.
+// glDrawElements() transforms every vertex it finds in the post-transform vertex cache only once, see
+// swglSetVertexCache() and swglOptimizeVertexCache(). It is not compiled into display lists.
+GLvoid glEnableClientState(GLenum array);
+GLvoid glDisableClientState(GLenum array);
+GLvoid glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+GLvoid glColorPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+GLvoid glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices);
+
+// Software rendering context, the headless counterpart of HGLRC.
+typedef struct SWGLContext *HSWGLRC;
+
+// Frame statistics, collected between two swglSwapBuffers() calls.
+typedef struct SWGLFrameStats
+{
+    unsigned long long primitivesSubmitted; // Triangles and quads received from glBegin/glEnd.
+    unsigned long long primitivesCulled; // Submitted primitives rejected by face culling before clipping and setup.
+    unsigned long long trianglesClipped; // Triangles, including halves of split quads, cut into new polygons by the guard band or the near and far planes.
+    unsigned long long trianglesRasterized; // Triangles that reached the rasterizer after clipping, including halves of split quads.
+    unsigned long long quadsRasterized; // Quads that reached the rasterizer as one primitive, see swglSetNativeQuads().
+    unsigned long long fragmentsTested; // Covered pixels that reached the pixel kernels.
+    unsigned long long fragmentsWritten; // Pixels written to the color buffer.
+    unsigned long long fragmentsHiZRejected; // Covered pixels discarded by the hierarchical depth test, never read from the depth buffer.
+    unsigned long long fragmentsHiZAccepted; // Tested pixels known to pass the depth test, written without a per-pixel comparison.
+    unsigned long long fragmentsFlatColor; // Written pixels of single-color triangles, stored without interpolating a color.
+    unsigned long long kernelMismatches; // Blocks, vertices and culling decisions where the vector code differed from the scalar one, see swglSetKernelValidation().
+    unsigned long long objectsVisible; // Instances of swglDrawInstanced() and objects of swglDrawScene() drawn, see swglSetInstanceCulling().
+    unsigned long long objectsCulled; // Instances and objects rejected by frustum culling before any vertex work.
+    unsigned long long vertexCacheLookups; // Indices of glDrawElements(), see swglSetVertexCache().
+    unsigned long long vertexCacheHits; // Indices whose vertex was found already transformed in the post-transform vertex cache.
+    unsigned long long drawCacheLookups; // Batches, display lists, meshes and scene objects looked up in the draw cache, see swglSetDrawCache().
+    unsigned long long drawCacheHits; // Draws whose primitives were taken from an earlier frame, skipping the geometry stage and setup.
+    unsigned long long framesQueued; // Earlier frames still queued or being rendered when this one was queued, see swglSetFrameQueueDepth().
+    unsigned long long queueStallMicroseconds; // Time the application waited for queued frames while recording and queueing this one.
+    unsigned long long framesSkipped; // 1 when the frame was identical to the front buffer and neither rendered nor presented, see swglSetDamageTracking().
+    unsigned long long pixelsRendered; // Pixels of the tiles rendered; tiles the back buffer already holds are skipped.
+} SWGLFrameStats;
+
+// Frustum culling of the instances of swglDrawInstanced(), see swglSetInstanceCulling().
+#define SWGL_INSTANCE_CULLING_NONE 0
+#define SWGL_INSTANCE_CULLING_SPHERES 1
+#define SWGL_INSTANCE_CULLING_GROUPS 2
+
+// Rasterizer instruction sets, the widest one supported by the CPU is selected at startup.
+#define SWGL_INSTRUCTION_SET_SCALAR 0
+#define SWGL_INSTRUCTION_SET_SSE41 1
+#define SWGL_INSTRUCTION_SET_AVX2 2
+
+// Context management, mirrors wglCreateContext/wglMakeCurrent/wglDeleteContext/SwapBuffers.
+HSWGLRC swglCreateContext(int width, int height);
+int swglMakeCurrent(HSWGLRC context);
+int swglDeleteContext(HSWGLRC context);
+HSWGLRC swglGetCurrentContext(void);
+int swglSwapBuffers(void);
+
+// Makes target use the display lists of source, mirrors wglShareLists. Fails when target already has lists.
+int swglShareLists(HSWGLRC source, HSWGLRC target);
+
+// Front buffer access, 0xAARRGGBB pixels stored bottom-up like a Windows DIB.
+// Rows are stride pixels apart.
+const unsigned int *swglGetFrontBuffer(int *width, int *height, int *stride);
+int swglWriteFrontBuffer(const char *fileName);
+
+// Statistics of the last presented frame. With a frame queue, those of the frame queued depth swaps earlier, which
+// is presented by the time swglSwapBuffers() returns; see swglSetFrameQueueDepth().
+int swglGetFrameStats(SWGLFrameStats *stats);
+
+// Rasterizer instruction set selection. swglSetInstructionSet() fails for sets the CPU does not support.
+int swglGetInstructionSet(void);
+int swglSetInstructionSet(int instructionSet);
+const char *swglGetInstructionSetName(int instructionSet);
+
+// Threads rendering the tiles of a frame, including the thread calling swglSwapBuffers(), or the rendering thread of
+// the context with a frame queue, see swglSetFrameQueueDepth(). 0 selects one thread per hardware thread, which is the
+// default.
+int swglSetThreadCount(int count);
+int swglGetThreadCount(void);
+
+// When enabled, every block drawn by a vector kernel is also drawn by the scalar reference kernel, every vertex
+// transformed by vector code is also transformed by the scalar code, and the results are compared bit for bit.
+// Slow, meant for validation runs only.
+int swglSetKernelValidation(int enable);
+
+// When enabled, which is the default, convex quads that need no clipping are rasterized as one primitive
+// instead of two triangles. Disabling it is meant for comparisons.
+int swglSetNativeQuads(int enable);
+
+// When enabled, which is the default, primitives are only clipped against the near and far planes and against a
+// guard band far outside the viewport; the rasterizer scissors them to the viewport. When disabled they are
+// clipped against the whole view frustum, which is meant for comparisons.
+int swglSetGuardBand(int enable);
+
+// When enabled, which is the default, glVertex3f() only records vertices. Consecutive primitives drawn with the
+// same matrices and render state are transformed and assembled as one batch when the state changes, on glClear(),
+// glFlush() and swglSwapBuffers(), or when the batch is full. Disabling it, which is meant for comparisons,
+// processes every primitive as soon as its last vertex arrives. Fails between glBegin() and glEnd().
+int swglSetVertexBatching(int enable);
+
+// When enabled, which is the default, indexed draws keep recently transformed vertices in a post-transform vertex
+// cache of 64 entries, so a vertex shared by nearby primitives is transformed once. Disabling it, which is meant for
+// comparisons, transforms the vertex of every index. Fails between glBegin() and glEnd().
+int swglSetVertexCache(int enable);
+
+// Reorders the triangles of indexCount indices in place so that consecutive triangles share vertices and more of
+// them are found in the post-transform vertex cache, with the algorithm of Tom Forsyth's "Linear-Speed Vertex Cache
+// Optimisation". Meant to run once when a mesh is loaded. The vertices and winding of every triangle are kept, only
+// their order changes. Fails when indexCount is not a multiple of 3 or an index is not below vertexCount.
+int swglOptimizeVertexCache(GLuint *indices, GLsizei indexCount, GLsizei vertexCount);
+
+// When enabled, which is the default, draws that are identical to a draw of the previous frame reuse its primitive
+// setups and skip transform, clipping and setup. A draw is a batch of immediate mode primitives, a display list
+// draw, a mesh or an object of a scene; it is identical when its vertices, matrices, viewport and render state are,
+// which is detected by hashing them. A draw is recorded the second frame in a row it is seen and replayed from the
+// third one, so moving objects only pay for the hash. glDrawElements() and swglDrawInstanced() are not cached. Draws
+// are not replayed while kernels are validated, see swglSetKernelValidation(). Fails between glBegin() and glEnd().
+int swglSetDrawCache(int enable);
+
+// Frames swglSwapBuffers() may leave queued for rendering, 0 to 3. With 0, the default, a frame is rendered and
+// presented before swglSwapBuffers() returns. Above 0, each context renders and presents its frames on a thread of
+// its own, in order, while the application records the next ones; swglSwapBuffers() waits when depth frames are
+// already queued. A deeper queue absorbs frames of uneven cost at the price of latency. Reading the front buffer,
+// glFlush(), glFinish() and changing the instruction set or kernel validation wait until the queued frames are
+// presented. Fails between glBegin() and glEnd().
+int swglSetFrameQueueDepth(int depth);
+
+// When enabled, which is the default, the commands binned to every tile are hashed and compared with those that
+// produced what the color and depth buffers already hold, from the last clear of both buffers on. A frame identical
+// to the front buffer is neither rendered nor presented, and tiles the back buffer already holds are not rendered
+// again; a frame without a clear of both buffers is always rendered in full. Nothing is skipped while kernels are
+// validated, see swglSetKernelValidation(). Fails between glBegin() and glEnd().
+int swglSetDamageTracking(int enable);
+
+// Rectangle of the front buffer changed by the last swglSwapBuffers(), in pixels from the bottom-left, made of whole
+// tiles; empty when the frame was skipped. A window system only needs to copy this rectangle to the screen.
+int swglGetDamageRect(int *x, int *y, int *width, int *height);
+
+// Draws vertexCount vertices of mode once per instance, like a glBegin()/glEnd() pair per instance without the
+// per-call overhead. positions holds x, y and z per vertex; colors holds r, g and b per vertex, or is NULL to use the
+// current color. Every instance is transformed by the current model-view and projection matrices times its own
+// column-major 4x4 model matrix from matrices. When instanceColors is not NULL, it holds r, g and b per instance,
+// which replace the vertex colors. Fails between glBegin() and glEnd() and for modes other than GL_TRIANGLES and
+// GL_QUADS.
+int swglDrawInstanced(GLenum mode, GLsizei vertexCount, const GLfloat *positions, const GLfloat *colors,
+    GLsizei instanceCount, const GLfloat *matrices, const GLfloat *instanceColors);
+
+// Scene files, see sceneFormat.h and sceneConverter. swglLoadScene() maps the file into memory and only checks its
+// layout; vertices are neither read nor copied before they are drawn. Returns NULL when the file can not be mapped
+// or is not a valid scene. A scene may be drawn by any context, by one thread at a time.
+typedef struct SWGLScene *HSWGLSCENE;
+HSWGLSCENE swglLoadScene(const char *fileName);
+int swglDeleteScene(HSWGLSCENE scene);
+
+// Draws every object of scene as it is at frame, which may be fractional. Objects are transformed by the current
+// model-view and projection matrices times their own translation and rotation, and culled like instances, see
+// swglSetInstanceCulling(). Fails between glBegin() and glEnd().
+int swglDrawScene(HSWGLSCENE scene, GLfloat frame);
+
+// Triangle meshes from Wavefront OBJ files or PLY files, ascii or binary_little_endian. Files starting with "ply" are
+// read as PLY, anything else as OBJ. Only positions, vertex colors and faces are kept; faces with more vertices are
+// split into triangles. The file is parsed in place from a memory mapping, in parallel on the worker threads, see
+// swglSetThreadCount(). Returns NULL when the file can not be mapped, is malformed, or refers to missing vertices.
+typedef struct SWGLMesh *HSWGLMESH;
+HSWGLMESH swglLoadMesh(const char *fileName);
+int swglDeleteMesh(HSWGLMESH mesh);
+
+// Draws the triangles of mesh with the current matrices and render state, in the current color when the file has
+// no vertex colors. Fails between glBegin() and glEnd().
+int swglDrawMesh(HSWGLMESH mesh);
+
+// Hands out the arrays of mesh, which stay valid until it is deleted: vertexCount vertices of x, y, z, r, g and b,
+// and indexCount indices of its triangles. Any pointer may be NULL.
+int swglGetMeshData(HSWGLMESH mesh, GLsizei *vertexCount, const GLfloat **vertices, GLsizei *indexCount,
+    const GLuint **indices);
+
+// Selects how swglDrawInstanced() and swglDrawScene() cull instances outside the view frustum before transforming
+// any vertex. With SWGL_INSTANCE_CULLING_SPHERES, the default, the bounding sphere of every instance is tested
+// against the six frustum planes. SWGL_INSTANCE_CULLING_GROUPS also tests a sphere around every 64 consecutive
+// instances first, which culls or accepts the whole group with one test when it is outside or inside the frustum;
+// it only pays off when consecutive instances are close to each other. SWGL_INSTANCE_CULLING_NONE draws every
+// instance.
+int swglSetInstanceCulling(int mode);
+
+// Runs a sample without a window: creates a context, calls resize and init once,
+// then renders and presents frames, printing the achieved frame rate.
+// Options: -frames <count>, -size <width>x<height>, -output <file.ppm>,
+// -isa <scalar|sse4.1|avx2>, -validate, -threads <count>,
+// -hint <fastest|nicest>, which overrides GL_PERSPECTIVE_CORRECTION_HINT after init,
+// -quads <native|split>, see swglSetNativeQuads(),
+// -cull <front|back|none>, which overrides GL_CULL_FACE and glCullFace() after init,
+// -clip <guardband|frustum>, see swglSetGuardBand(),
+// -vertices <batched|immediate>, see swglSetVertexBatching(),
+// -vertexcache <on|off>, see swglSetVertexCache(),
+// -drawcache <on|off>, see swglSetDrawCache(),
+// -instancecull <none|spheres|groups>, see swglSetInstanceCulling(),
+// -fps <rate|uncapped|vsync>, which paces the frames, see frameScheduler.h; vsync emulates 60 Hz. Uncapped by default.
+// -queue <depth>, see swglSetFrameQueueDepth(),
+// -damage <on|off>, see swglSetDamageTracking().
+int swglRunHeadless(int argc, char *argv[], int width, int height,
+    GLvoid (*resizeScene)(GLsizei, GLsizei), int (*initScene)(GLvoid), int (*drawScene)(GLvoid));
+
+#endif // SOFTWARE_RENDERER_H
@@ -0,0 +1,202 @@
+// Worker threads shared by all software rendering contexts.
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "softwareRenderer.h"
+#include "threadPool.h"
+
+#define SW_MAX_THREADS 256
+
+struct SWThreadPool
+{
+    std::mutex jobMutex; // Held by the thread running a job, the rendering threads of several contexts take turns.
+    std::mutex mutex;
+    std::condition_variable workAvailable; // Signalled when a job is posted or the pool stops.
+    std::condition_variable workDone; // Signalled when the last busy worker goes idle.
+    std::vector<std::thread> workers;
+    bool stopping;
+
+    // Current job, only changed while no worker is busy.
+    unsigned int generation;
+    SWTask task;
+    void *data;
+    int count;
+    std::atomic<int> nextIndex;
+    int busyWorkers;
+
+    SWThreadPool() : stopping(false), generation(0), task(NULL), data(NULL), count(0), nextIndex(0), busyWorkers(0)
+    {
+    }
+};
+
+static SWThreadPool swThreadPool;
+static std::atomic<int> swThreadCount(0); // Threads rendering a frame, including the calling thread. 0 until first use.
+
+static void runTasks(SWTask task, void *data, int count, std::atomic<int> *nextIndex)
+{
+    for(int index = nextIndex->fetch_add(1); index < count; index = nextIndex->fetch_add(1))
+    {
+        task(data, index);
+    }
+}
+
+static void workerMain(void)
+{
+    SWThreadPool *pool = &swThreadPool;
+    unsigned int seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(pool->mutex);
+
+    for(;;)
+    {
+        while(!pool->stopping && pool->generation == seenGeneration)
+        {
+            pool->workAvailable.wait(lock);
+        }
+
+        if(pool->stopping)
+        {
+            return;
+        }
+
+        // Take the job while holding the lock, it can not change until this worker is idle again.
+        seenGeneration = pool->generation;
+        SWTask task = pool->task;
+        void *data = pool->data;
+        int count = pool->count;
+        pool->busyWorkers++;
+
+        lock.unlock();
+        runTasks(task, data, count, &pool->nextIndex);
+        lock.lock();
+
+        if(--pool->busyWorkers == 0)
+        {
+            pool->workDone.notify_all();
+        }
+    }
+}
+
+static void stopWorkers(void)
+{
+    SWThreadPool *pool = &swThreadPool;
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stopping = true;
+    }
+
+    pool->workAvailable.notify_all();
+
+    for(size_t i = 0; i < pool->workers.size(); ++i)
+    {
+        pool->workers[i].join();
+    }
+
+    pool->workers.clear();
+    pool->stopping = false;
+}
+
+// Joins the workers before static destruction of the pool.
+struct SWThreadPoolShutdown
+{
+    ~SWThreadPoolShutdown()
+    {
+        stopWorkers();
+    }
+};
+
+static SWThreadPoolShutdown swThreadPoolShutdown;
+
+int swglSetThreadCount(int count)
+{
+    if(count < 0 || count > SW_MAX_THREADS)
+    {
+        return FALSE;
+    }
+
+    if(count == 0)
+    {
+        // Use every hardware thread.
+        count = (int)std::thread::hardware_concurrency();
+        count = count < 1 ? 1 : (count > SW_MAX_THREADS ? SW_MAX_THREADS : count);
+    }
+
+    // Wait for the job of a rendering thread, see swglSetFrameQueueDepth().
+    std::lock_guard<std::mutex> jobLock(swThreadPool.jobMutex);
+
+    if(count == swThreadCount)
+    {
+        return TRUE;
+    }
+
+    stopWorkers();
+    swThreadCount = count;
+
+    // The calling thread is one of the rendering threads.
+    for(int i = 1; i < count; ++i)
+    {
+        swThreadPool.workers.push_back(std::thread(workerMain));
+    }
+
+    return TRUE;
+}
+
+int swglGetThreadCount(void)
+{
+    if(swThreadCount == 0)
+    {
+        swglSetThreadCount(0);
+    }
+
+    return swThreadCount;
+}
+
+void swParallelFor(int count, SWTask task, void *data)
+{
+    if(count <= 0)
+    {
+        return;
+    }
+
+    if(count == 1 || swglGetThreadCount() == 1)
+    {
+        for(int index = 0; index < count; ++index)
+        {
+            task(data, index);
+        }
+
+        return;
+    }
+
+    SWThreadPool *pool = &swThreadPool;
+    std::lock_guard<std::mutex> jobLock(pool->jobMutex);
+    std::unique_lock<std::mutex> lock(pool->mutex);
+
+    // A worker that woke up late for the previous job may still hold it.
+    while(pool->busyWorkers > 0)
+    {
+        pool->workDone.wait(lock);
+    }
+
+    pool->task = task;
+    pool->data = data;
+    pool->count = count;
+    pool->nextIndex.store(0);
+    pool->generation++;
+    lock.unlock();
+    pool->workAvailable.notify_all();
+
+    runTasks(task, data, count, &pool->nextIndex);
+
+    // Every index has been taken, wait for the workers still running theirs.
+    lock.lock();
+
+    while(pool->busyWorkers > 0)
+    {
+        pool->workDone.wait(lock);
+    }
+}
@@ -0,0 +1,12 @@
+// Worker threads shared by all software rendering contexts.
+
+#ifndef SOFTWARE_RENDERER_THREAD_POOL_H
+#define SOFTWARE_RENDERER_THREAD_POOL_H
+
+typedef void (*SWTask)(void *data, int index);
+
+// Calls task(data, index) for every index in range 0 to count - 1, spread over the worker threads
+// and the calling thread. Returns once all calls have finished.
+void swParallelFor(int count, SWTask task, void *data);
+
+#endif // SOFTWARE_RENDERER_THREAD_POOL_H
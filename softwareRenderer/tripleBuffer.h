@@ -0,0 +1,66 @@
+// Lock-free triple buffer handing the latest of a stream of values from one producer thread to one consumer thread.
+//
+// Header only like frameScheduler.h. Each thread owns one slot and the third one is shared. The producer writes its
+// slot and publishes it by exchanging it with the shared one; the consumer takes the shared slot in exchange for its
+// own when it holds a value published since its last read. Neither thread ever waits for the other: values the
+// consumer did not get to are overwritten, and the consumer keeps its value until a newer one is published.
+
+#ifndef SOFTWARE_RENDERER_TRIPLE_BUFFER_H
+#define SOFTWARE_RENDERER_TRIPLE_BUFFER_H
+
+#include <atomic>
+
+#define SW_TRIPLE_BUFFER_FRESH 4u // Set in shared when it was published after the last read.
+
+template<typename T>
+struct SWTripleBuffer
+{
+    T slots[3];
+    std::atomic<unsigned int> shared; // Index of the shared slot, with SW_TRIPLE_BUFFER_FRESH.
+    unsigned int written; // Slot of the producer.
+    unsigned int read; // Slot of the consumer.
+};
+
+// Not thread safe, called before the threads start. The consumer reads initial until the first value is published.
+template<typename T>
+inline void swInitTripleBuffer(SWTripleBuffer<T> *buffer, const T &initial)
+{
+    for(int slot = 0; slot < 3; ++slot)
+    {
+        buffer->slots[slot] = initial;
+    }
+
+    buffer->written = 0;
+    buffer->shared.store(1);
+    buffer->read = 2;
+}
+
+// Slot the producer writes the next value into.
+template<typename T>
+inline T *swTripleBufferWriteSlot(SWTripleBuffer<T> *buffer)
+{
+    return &buffer->slots[buffer->written];
+}
+
+// Publishes the write slot, the producer gets a new one to write.
+template<typename T>
+inline void swPublishTripleBuffer(SWTripleBuffer<T> *buffer)
+{
+    buffer->written = buffer->shared.exchange(buffer->written | SW_TRIPLE_BUFFER_FRESH, std::memory_order_acq_rel) & 3u;
+}
+
+// Returns the latest published value, and sets fresh to whether it was published since the last call.
+template<typename T>
+inline const T *swAcquireTripleBuffer(SWTripleBuffer<T> *buffer, bool *fresh)
+{
+    *fresh = (buffer->shared.load(std::memory_order_relaxed) & SW_TRIPLE_BUFFER_FRESH) != 0;
+
+    if(*fresh)
+    {
+        buffer->read = buffer->shared.exchange(buffer->read, std::memory_order_acq_rel) & 3u;
+    }
+
+    return &buffer->slots[buffer->read];
+}
+
+#endif // SOFTWARE_RENDERER_TRIPLE_BUFFER_H
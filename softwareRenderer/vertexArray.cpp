@@ -0,0 +1,123 @@
+// Vertex arrays of the software renderer: glVertexPointer(), glColorPointer() and glDrawElements().
+
+#include "context.h"
+
+static SWClientArray *clientArray(SWGLContext *context, GLenum array)
+{
+    switch(array)
+    {
+        case GL_VERTEX_ARRAY: return &context->vertexArray;
+        case GL_COLOR_ARRAY: return &context->colorArray;
+        default: return NULL;
+    }
+}
+
+static void setClientState(GLenum array, bool enabled)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    SWClientArray *target = clientArray(context, array);
+
+    if(!target)
+    {
+        swSetError(context, GL_INVALID_ENUM);
+        return;
+    }
+
+    target->enabled = enabled;
+}
+
+GLvoid glEnableClientState(GLenum array)
+{
+    setClientState(array, true);
+}
+
+GLvoid glDisableClientState(GLenum array)
+{
+    setClientState(array, false);
+}
+
+static void setPointer(GLenum array, GLint size, GLint minimumSize, GLint maximumSize, GLenum type, GLsizei stride, const GLvoid *pointer)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(type != GL_FLOAT)
+    {
+        swSetError(context, GL_INVALID_ENUM);
+        return;
+    }
+
+    if(size < minimumSize || size > maximumSize || stride < 0)
+    {
+        swSetError(context, GL_INVALID_VALUE);
+        return;
+    }
+
+    SWClientArray *target = clientArray(context, array);
+    target->size = size;
+    target->stride = stride ? stride : size * (int)sizeof(GLfloat); // 0 means tightly packed.
+    target->pointer = (const unsigned char *)pointer;
+}
+
+GLvoid glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer)
+{
+    setPointer(GL_VERTEX_ARRAY, size, 2, 3, type, stride, pointer);
+}
+
+GLvoid glColorPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer)
+{
+    setPointer(GL_COLOR_ARRAY, size, 3, 4, type, stride, pointer);
+}
+
+GLvoid glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices)
+{
+    SWGLContext *context = swCurrentContext;
+
+    if(!context)
+    {
+        return;
+    }
+
+    if(context->insideBeginEnd)
+    {
+        swSetError(context, GL_INVALID_OPERATION);
+        return;
+    }
+
+    if((mode != GL_TRIANGLES && mode != GL_QUADS) || (type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT && type != GL_UNSIGNED_INT))
+    {
+        swSetError(context, GL_INVALID_ENUM);
+        return;
+    }
+
+    if(count < 0)
+    {
+        swSetError(context, GL_INVALID_VALUE);
+        return;
+    }
+
+    // Without positions there is nothing to draw.
+    if(!context->vertexArray.enabled || !context->vertexArray.pointer || !indices || count == 0)
+    {
+        return;
+    }
+
+    bool colors = context->colorArray.enabled && context->colorArray.pointer;
+    SWVertexSource source;
+    source.positions = context->vertexArray.pointer;
+    source.positionStride = (size_t)context->vertexArray.stride;
+    source.positionSize = context->vertexArray.size;
+    source.colors = colors ? context->colorArray.pointer : NULL;
+    source.colorStride = (size_t)context->colorArray.stride;
+    swDrawElements(context, mode, &source, type, indices, count);
+}
@@ -0,0 +1,222 @@
+// Triangle reordering for the post-transform vertex cache, see swglOptimizeVertexCache().
+//
+// Tom Forsyth's greedy algorithm: every vertex gets a score from its position in a modelled LRU cache and from the
+// number of triangles still using it, and every triangle the sum of the scores of its vertices. The triangle with
+// the highest score among those touching the cache is emitted next, which keeps drawing around the vertices already
+// transformed and finishes off vertices with few triangles left before they leave the cache. Only triangles of the
+// cached vertices are rescored, so the whole pass is linear in the number of triangles.
+
+#include <math.h>
+#include <string.h>
+
+#include <new>
+#include <vector>
+
+#include "context.h"
+
+#define SW_MODEL_CACHE_SIZE 32 // Entries of the modelled LRU cache, as in the article. The direct-mapped cache of
+                               // primitive.cpp has twice as many to make up for entries evicted by conflicts.
+#define SW_VALENCE_TABLE_SIZE 32
+
+// Parameters of the article.
+static const float swCacheDecayPower = 1.5f;
+static const float swLastTriangleScore = 0.75f;
+static const float swValenceBoostScale = 2.0f;
+static const float swValenceBoostPower = 0.5f;
+
+struct SWScoreTables
+{
+    float cache[SW_MODEL_CACHE_SIZE];
+    float valence[SW_VALENCE_TABLE_SIZE];
+
+    SWScoreTables()
+    {
+        for(int position = 0; position < SW_MODEL_CACHE_SIZE; ++position)
+        {
+            // The vertices of the last triangle score the same, whatever their order.
+            cache[position] = position < 3 ? swLastTriangleScore
+                : powf(1.0f - (position - 3) / (float)(SW_MODEL_CACHE_SIZE - 3), swCacheDecayPower);
+        }
+
+        for(int remaining = 0; remaining < SW_VALENCE_TABLE_SIZE; ++remaining)
+        {
+            valence[remaining] = remaining ? swValenceBoostScale * powf((float)remaining, -swValenceBoostPower) : 0.0f;
+        }
+    }
+};
+
+static const SWScoreTables swScoreTables;
+
+static float vertexScore(int cachePosition, int remaining)
+{
+    if(remaining == 0)
+    {
+        return -1.0f; // Not used by any triangle left.
+    }
+
+    float score = cachePosition >= 0 ? swScoreTables.cache[cachePosition] : 0.0f;
+    return score + (remaining < SW_VALENCE_TABLE_SIZE ? swScoreTables.valence[remaining]
+        : swValenceBoostScale * powf((float)remaining, -swValenceBoostPower));
+}
+
+static void optimize(GLuint *indices, int triangleCount, int vertexCount)
+{
+    // Triangles of every vertex, the ones still to be emitted first.
+    std::vector<int> firstTriangle(vertexCount + 1, 0);
+    std::vector<int> remaining(vertexCount, 0);
+    std::vector<int> vertexTriangles(triangleCount * 3);
+
+    for(int i = 0; i < triangleCount * 3; ++i)
+    {
+        remaining[indices[i]]++;
+    }
+
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        firstTriangle[vertex + 1] = firstTriangle[vertex] + remaining[vertex];
+        remaining[vertex] = 0;
+    }
+
+    for(int i = 0; i < triangleCount * 3; ++i)
+    {
+        GLuint vertex = indices[i];
+        vertexTriangles[firstTriangle[vertex] + remaining[vertex]++] = i / 3;
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<GLuint> output(triangleCount * 3);
+
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        score[vertex] = vertexScore(-1, remaining[vertex]);
+    }
+
+    int cache[SW_MODEL_CACHE_SIZE + 3];
+    int cacheSize = 0;
+    int best = -1;
+    int nextInOrder = 0; // Triangles before it have all been emitted.
+
+    for(int emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        // Nothing left around the cache, continue with the first triangle not emitted yet.
+        if(best < 0)
+        {
+            while(emitted[nextInOrder])
+            {
+                ++nextInOrder;
+            }
+
+            best = nextInOrder;
+        }
+
+        const GLuint *triangle = &indices[best * 3];
+        memcpy(&output[emittedCount * 3], triangle, 3 * sizeof(GLuint));
+        emitted[best] = true;
+
+        // Move the triangle behind the ones still to be emitted in the lists of its vertices.
+        for(int corner = 0; corner < 3; ++corner)
+        {
+            GLuint vertex = triangle[corner];
+            int *triangles = &vertexTriangles[firstTriangle[vertex]];
+            int last = --remaining[vertex];
+
+            for(int i = 0; i <= last; ++i)
+            {
+                if(triangles[i] == best)
+                {
+                    triangles[i] = triangles[last];
+                    triangles[last] = best;
+                    break;
+                }
+            }
+        }
+
+        // The vertices of the triangle move to the front of the cache, the oldest entries fall out.
+        int newCache[SW_MODEL_CACHE_SIZE + 3];
+        int newSize = 0;
+
+        for(int corner = 0; corner < 3; ++corner)
+        {
+            newCache[newSize++] = (int)triangle[corner];
+        }
+
+        for(int i = 0; i < cacheSize; ++i)
+        {
+            int vertex = cache[i];
+
+            if(vertex != (int)triangle[0] && vertex != (int)triangle[1] && vertex != (int)triangle[2])
+            {
+                newCache[newSize++] = vertex;
+            }
+        }
+
+        for(int i = 0; i < newSize; ++i)
+        {
+            int vertex = newCache[i];
+            cachePosition[vertex] = i < SW_MODEL_CACHE_SIZE ? i : -1;
+            score[vertex] = vertexScore(cachePosition[vertex], remaining[vertex]);
+        }
+
+        cacheSize = newSize < SW_MODEL_CACHE_SIZE ? newSize : SW_MODEL_CACHE_SIZE;
+        memcpy(cache, newCache, cacheSize * sizeof(int));
+
+        // Rescore the triangles touching the cache, including the vertices that just fell out of it.
+        float bestScore = -1.0f;
+        best = -1;
+
+        for(int i = 0; i < newSize; ++i)
+        {
+            int vertex = newCache[i];
+            const int *triangles = &vertexTriangles[firstTriangle[vertex]];
+
+            for(int j = 0; j < remaining[vertex]; ++j)
+            {
+                int candidate = triangles[j];
+                const GLuint *corners = &indices[candidate * 3];
+                float candidateScore = score[corners[0]] + score[corners[1]] + score[corners[2]];
+
+                if(candidateScore > bestScore)
+                {
+                    bestScore = candidateScore;
+                    best = candidate;
+                }
+            }
+        }
+    }
+
+    memcpy(indices, output.data(), output.size() * sizeof(GLuint));
+}
+
+int swglOptimizeVertexCache(GLuint *indices, GLsizei indexCount, GLsizei vertexCount)
+{
+    if(indexCount < 0 || indexCount % 3 || vertexCount < 0 || (indexCount && !indices))
+    {
+        return FALSE;
+    }
+
+    for(GLsizei i = 0; i < indexCount; ++i)
+    {
+        if(indices[i] >= (GLuint)vertexCount)
+        {
+            return FALSE;
+        }
+    }
+
+    if(indexCount == 0)
+    {
+        return TRUE;
+    }
+
+    try
+    {
+        optimize(indices, indexCount / 3, vertexCount);
+    }
+    catch(const std::bad_alloc &)
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}